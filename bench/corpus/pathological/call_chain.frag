@@ -0,0 +1,172 @@
+precision highp float;
+
+// A long chain of small functions calling each other, plus wide unrolled
+// expressions. Stresses the call DAG, inlining-related passes and validation.
+uniform vec4 u_seed;
+varying vec4 v_value;
+
+vec4 f0(vec4 v) { return v * 1.0001 + 0.5; }
+vec4 f1(vec4 v) { return f0(v.wzyx + vec4(1.0)) * 0.99; }
+vec4 f2(vec4 v) { return f1(v.wzyx + vec4(2.0)) * 0.99; }
+vec4 f3(vec4 v) { return f2(v.wzyx + vec4(3.0)) * 0.99; }
+vec4 f4(vec4 v) { return f3(v.wzyx + vec4(4.0)) * 0.99; }
+vec4 f5(vec4 v) { return f4(v.wzyx + vec4(5.0)) * 0.99; }
+vec4 f6(vec4 v) { return f5(v.wzyx + vec4(6.0)) * 0.99; }
+vec4 f7(vec4 v) { return f6(v.wzyx + vec4(7.0)) * 0.99; }
+vec4 f8(vec4 v) { return f7(v.yzwx * 1.0080) - f7(v) * 0.5; }
+vec4 f9(vec4 v) { return f8(v.wzyx + vec4(9.0)) * 0.99; }
+vec4 f10(vec4 v) { return f9(v.wzyx + vec4(10.0)) * 0.99; }
+vec4 f11(vec4 v) { return f10(v.wzyx + vec4(11.0)) * 0.99; }
+vec4 f12(vec4 v) { return f11(v.wzyx + vec4(12.0)) * 0.99; }
+vec4 f13(vec4 v) { return f12(v.wzyx + vec4(13.0)) * 0.99; }
+vec4 f14(vec4 v) { return f13(v.wzyx + vec4(14.0)) * 0.99; }
+vec4 f15(vec4 v) { return f14(v.wzyx + vec4(15.0)) * 0.99; }
+vec4 f16(vec4 v) { return f15(v.yzwx * 1.0160) - f15(v) * 0.5; }
+vec4 f17(vec4 v) { return f16(v.wzyx + vec4(17.0)) * 0.99; }
+vec4 f18(vec4 v) { return f17(v.wzyx + vec4(18.0)) * 0.99; }
+vec4 f19(vec4 v) { return f18(v.wzyx + vec4(19.0)) * 0.99; }
+vec4 f20(vec4 v) { return f19(v.wzyx + vec4(20.0)) * 0.99; }
+vec4 f21(vec4 v) { return f20(v.wzyx + vec4(21.0)) * 0.99; }
+vec4 f22(vec4 v) { return f21(v.wzyx + vec4(22.0)) * 0.99; }
+vec4 f23(vec4 v) { return f22(v.wzyx + vec4(23.0)) * 0.99; }
+vec4 f24(vec4 v) { return f23(v.yzwx * 1.0240) - f23(v) * 0.5; }
+vec4 f25(vec4 v) { return f24(v.wzyx + vec4(25.0)) * 0.99; }
+vec4 f26(vec4 v) { return f25(v.wzyx + vec4(26.0)) * 0.99; }
+vec4 f27(vec4 v) { return f26(v.wzyx + vec4(27.0)) * 0.99; }
+vec4 f28(vec4 v) { return f27(v.wzyx + vec4(28.0)) * 0.99; }
+vec4 f29(vec4 v) { return f28(v.wzyx + vec4(29.0)) * 0.99; }
+vec4 f30(vec4 v) { return f29(v.wzyx + vec4(30.0)) * 0.99; }
+vec4 f31(vec4 v) { return f30(v.wzyx + vec4(31.0)) * 0.99; }
+vec4 f32(vec4 v) { return f31(v.yzwx * 1.0320) - f31(v) * 0.5; }
+vec4 f33(vec4 v) { return f32(v.wzyx + vec4(33.0)) * 0.99; }
+vec4 f34(vec4 v) { return f33(v.wzyx + vec4(34.0)) * 0.99; }
+vec4 f35(vec4 v) { return f34(v.wzyx + vec4(35.0)) * 0.99; }
+vec4 f36(vec4 v) { return f35(v.wzyx + vec4(36.0)) * 0.99; }
+vec4 f37(vec4 v) { return f36(v.wzyx + vec4(37.0)) * 0.99; }
+vec4 f38(vec4 v) { return f37(v.wzyx + vec4(38.0)) * 0.99; }
+vec4 f39(vec4 v) { return f38(v.wzyx + vec4(39.0)) * 0.99; }
+vec4 f40(vec4 v) { return f39(v.yzwx * 1.0400) - f39(v) * 0.5; }
+vec4 f41(vec4 v) { return f40(v.wzyx + vec4(41.0)) * 0.99; }
+vec4 f42(vec4 v) { return f41(v.wzyx + vec4(42.0)) * 0.99; }
+vec4 f43(vec4 v) { return f42(v.wzyx + vec4(43.0)) * 0.99; }
+vec4 f44(vec4 v) { return f43(v.wzyx + vec4(44.0)) * 0.99; }
+vec4 f45(vec4 v) { return f44(v.wzyx + vec4(45.0)) * 0.99; }
+vec4 f46(vec4 v) { return f45(v.wzyx + vec4(46.0)) * 0.99; }
+vec4 f47(vec4 v) { return f46(v.wzyx + vec4(47.0)) * 0.99; }
+vec4 f48(vec4 v) { return f47(v.yzwx * 1.0480) - f47(v) * 0.5; }
+vec4 f49(vec4 v) { return f48(v.wzyx + vec4(49.0)) * 0.99; }
+vec4 f50(vec4 v) { return f49(v.wzyx + vec4(50.0)) * 0.99; }
+vec4 f51(vec4 v) { return f50(v.wzyx + vec4(51.0)) * 0.99; }
+vec4 f52(vec4 v) { return f51(v.wzyx + vec4(52.0)) * 0.99; }
+vec4 f53(vec4 v) { return f52(v.wzyx + vec4(53.0)) * 0.99; }
+vec4 f54(vec4 v) { return f53(v.wzyx + vec4(54.0)) * 0.99; }
+vec4 f55(vec4 v) { return f54(v.wzyx + vec4(55.0)) * 0.99; }
+vec4 f56(vec4 v) { return f55(v.yzwx * 1.0560) - f55(v) * 0.5; }
+vec4 f57(vec4 v) { return f56(v.wzyx + vec4(57.0)) * 0.99; }
+vec4 f58(vec4 v) { return f57(v.wzyx + vec4(58.0)) * 0.99; }
+vec4 f59(vec4 v) { return f58(v.wzyx + vec4(59.0)) * 0.99; }
+vec4 f60(vec4 v) { return f59(v.wzyx + vec4(60.0)) * 0.99; }
+vec4 f61(vec4 v) { return f60(v.wzyx + vec4(61.0)) * 0.99; }
+vec4 f62(vec4 v) { return f61(v.wzyx + vec4(62.0)) * 0.99; }
+vec4 f63(vec4 v) { return f62(v.wzyx + vec4(63.0)) * 0.99; }
+vec4 f64(vec4 v) { return f63(v.yzwx * 1.0640) - f63(v) * 0.5; }
+vec4 f65(vec4 v) { return f64(v.wzyx + vec4(65.0)) * 0.99; }
+vec4 f66(vec4 v) { return f65(v.wzyx + vec4(66.0)) * 0.99; }
+vec4 f67(vec4 v) { return f66(v.wzyx + vec4(67.0)) * 0.99; }
+vec4 f68(vec4 v) { return f67(v.wzyx + vec4(68.0)) * 0.99; }
+vec4 f69(vec4 v) { return f68(v.wzyx + vec4(69.0)) * 0.99; }
+vec4 f70(vec4 v) { return f69(v.wzyx + vec4(70.0)) * 0.99; }
+vec4 f71(vec4 v) { return f70(v.wzyx + vec4(71.0)) * 0.99; }
+vec4 f72(vec4 v) { return f71(v.yzwx * 1.0720) - f71(v) * 0.5; }
+vec4 f73(vec4 v) { return f72(v.wzyx + vec4(73.0)) * 0.99; }
+vec4 f74(vec4 v) { return f73(v.wzyx + vec4(74.0)) * 0.99; }
+vec4 f75(vec4 v) { return f74(v.wzyx + vec4(75.0)) * 0.99; }
+vec4 f76(vec4 v) { return f75(v.wzyx + vec4(76.0)) * 0.99; }
+vec4 f77(vec4 v) { return f76(v.wzyx + vec4(77.0)) * 0.99; }
+vec4 f78(vec4 v) { return f77(v.wzyx + vec4(78.0)) * 0.99; }
+vec4 f79(vec4 v) { return f78(v.wzyx + vec4(79.0)) * 0.99; }
+vec4 f80(vec4 v) { return f79(v.yzwx * 1.0800) - f79(v) * 0.5; }
+vec4 f81(vec4 v) { return f80(v.wzyx + vec4(81.0)) * 0.99; }
+vec4 f82(vec4 v) { return f81(v.wzyx + vec4(82.0)) * 0.99; }
+vec4 f83(vec4 v) { return f82(v.wzyx + vec4(83.0)) * 0.99; }
+vec4 f84(vec4 v) { return f83(v.wzyx + vec4(84.0)) * 0.99; }
+vec4 f85(vec4 v) { return f84(v.wzyx + vec4(85.0)) * 0.99; }
+vec4 f86(vec4 v) { return f85(v.wzyx + vec4(86.0)) * 0.99; }
+vec4 f87(vec4 v) { return f86(v.wzyx + vec4(87.0)) * 0.99; }
+vec4 f88(vec4 v) { return f87(v.yzwx * 1.0880) - f87(v) * 0.5; }
+vec4 f89(vec4 v) { return f88(v.wzyx + vec4(89.0)) * 0.99; }
+vec4 f90(vec4 v) { return f89(v.wzyx + vec4(90.0)) * 0.99; }
+vec4 f91(vec4 v) { return f90(v.wzyx + vec4(91.0)) * 0.99; }
+vec4 f92(vec4 v) { return f91(v.wzyx + vec4(92.0)) * 0.99; }
+vec4 f93(vec4 v) { return f92(v.wzyx + vec4(93.0)) * 0.99; }
+vec4 f94(vec4 v) { return f93(v.wzyx + vec4(94.0)) * 0.99; }
+vec4 f95(vec4 v) { return f94(v.wzyx + vec4(95.0)) * 0.99; }
+
+void main() {
+    vec4 v = v_value + u_seed;
+    v = v * vec4(0.0 + 0.25) + v.yzwx * 0.00 - (v.zwxy + vec4(0.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(1.0 + 0.25) + v.yzwx * 0.01 - (v.zwxy + vec4(1.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(2.0 + 0.25) + v.yzwx * 0.02 - (v.zwxy + vec4(2.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(3.0 + 0.25) + v.yzwx * 0.03 - (v.zwxy + vec4(3.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(4.0 + 0.25) + v.yzwx * 0.04 - (v.zwxy + vec4(4.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(5.0 + 0.25) + v.yzwx * 0.05 - (v.zwxy + vec4(5.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(6.0 + 0.25) + v.yzwx * 0.06 - (v.zwxy + vec4(6.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(0.0 + 0.25) + v.yzwx * 0.07 - (v.zwxy + vec4(7.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(1.0 + 0.25) + v.yzwx * 0.08 - (v.zwxy + vec4(8.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(2.0 + 0.25) + v.yzwx * 0.09 - (v.zwxy + vec4(9.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(3.0 + 0.25) + v.yzwx * 0.10 - (v.zwxy + vec4(10.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(4.0 + 0.25) + v.yzwx * 0.11 - (v.zwxy + vec4(11.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(5.0 + 0.25) + v.yzwx * 0.12 - (v.zwxy + vec4(12.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(6.0 + 0.25) + v.yzwx * 0.13 - (v.zwxy + vec4(13.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(0.0 + 0.25) + v.yzwx * 0.14 - (v.zwxy + vec4(14.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(1.0 + 0.25) + v.yzwx * 0.15 - (v.zwxy + vec4(15.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(2.0 + 0.25) + v.yzwx * 0.16 - (v.zwxy + vec4(16.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(3.0 + 0.25) + v.yzwx * 0.17 - (v.zwxy + vec4(17.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(4.0 + 0.25) + v.yzwx * 0.18 - (v.zwxy + vec4(18.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(5.0 + 0.25) + v.yzwx * 0.19 - (v.zwxy + vec4(19.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(6.0 + 0.25) + v.yzwx * 0.20 - (v.zwxy + vec4(20.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(0.0 + 0.25) + v.yzwx * 0.21 - (v.zwxy + vec4(21.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(1.0 + 0.25) + v.yzwx * 0.22 - (v.zwxy + vec4(22.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(2.0 + 0.25) + v.yzwx * 0.23 - (v.zwxy + vec4(23.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(3.0 + 0.25) + v.yzwx * 0.24 - (v.zwxy + vec4(24.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(4.0 + 0.25) + v.yzwx * 0.25 - (v.zwxy + vec4(25.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(5.0 + 0.25) + v.yzwx * 0.26 - (v.zwxy + vec4(26.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(6.0 + 0.25) + v.yzwx * 0.27 - (v.zwxy + vec4(27.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(0.0 + 0.25) + v.yzwx * 0.28 - (v.zwxy + vec4(28.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(1.0 + 0.25) + v.yzwx * 0.29 - (v.zwxy + vec4(29.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(2.0 + 0.25) + v.yzwx * 0.30 - (v.zwxy + vec4(30.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(3.0 + 0.25) + v.yzwx * 0.31 - (v.zwxy + vec4(31.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(4.0 + 0.25) + v.yzwx * 0.32 - (v.zwxy + vec4(32.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(5.0 + 0.25) + v.yzwx * 0.33 - (v.zwxy + vec4(33.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(6.0 + 0.25) + v.yzwx * 0.34 - (v.zwxy + vec4(34.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(0.0 + 0.25) + v.yzwx * 0.35 - (v.zwxy + vec4(35.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(1.0 + 0.25) + v.yzwx * 0.36 - (v.zwxy + vec4(36.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(2.0 + 0.25) + v.yzwx * 0.37 - (v.zwxy + vec4(37.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(3.0 + 0.25) + v.yzwx * 0.38 - (v.zwxy + vec4(38.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(4.0 + 0.25) + v.yzwx * 0.39 - (v.zwxy + vec4(39.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(5.0 + 0.25) + v.yzwx * 0.40 - (v.zwxy + vec4(40.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(6.0 + 0.25) + v.yzwx * 0.41 - (v.zwxy + vec4(41.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(0.0 + 0.25) + v.yzwx * 0.42 - (v.zwxy + vec4(42.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(1.0 + 0.25) + v.yzwx * 0.43 - (v.zwxy + vec4(43.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(2.0 + 0.25) + v.yzwx * 0.44 - (v.zwxy + vec4(44.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(3.0 + 0.25) + v.yzwx * 0.45 - (v.zwxy + vec4(45.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(4.0 + 0.25) + v.yzwx * 0.46 - (v.zwxy + vec4(46.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(5.0 + 0.25) + v.yzwx * 0.47 - (v.zwxy + vec4(47.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(6.0 + 0.25) + v.yzwx * 0.48 - (v.zwxy + vec4(48.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(0.0 + 0.25) + v.yzwx * 0.49 - (v.zwxy + vec4(49.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(1.0 + 0.25) + v.yzwx * 0.50 - (v.zwxy + vec4(50.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(2.0 + 0.25) + v.yzwx * 0.51 - (v.zwxy + vec4(51.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(3.0 + 0.25) + v.yzwx * 0.52 - (v.zwxy + vec4(52.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(4.0 + 0.25) + v.yzwx * 0.53 - (v.zwxy + vec4(53.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(5.0 + 0.25) + v.yzwx * 0.54 - (v.zwxy + vec4(54.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(6.0 + 0.25) + v.yzwx * 0.55 - (v.zwxy + vec4(55.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(0.0 + 0.25) + v.yzwx * 0.56 - (v.zwxy + vec4(56.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(1.0 + 0.25) + v.yzwx * 0.57 - (v.zwxy + vec4(57.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(2.0 + 0.25) + v.yzwx * 0.58 - (v.zwxy + vec4(58.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(3.0 + 0.25) + v.yzwx * 0.59 - (v.zwxy + vec4(59.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(4.0 + 0.25) + v.yzwx * 0.60 - (v.zwxy + vec4(60.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(5.0 + 0.25) + v.yzwx * 0.61 - (v.zwxy + vec4(61.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(6.0 + 0.25) + v.yzwx * 0.62 - (v.zwxy + vec4(62.0)) / (abs(v.wxyz) + 1.0);
+    v = v * vec4(0.0 + 0.25) + v.yzwx * 0.63 - (v.zwxy + vec4(63.0)) / (abs(v.wxyz) + 1.0);
+    gl_FragColor = f95(v);
+}
@@ -0,0 +1,117 @@
+precision mediump float;
+
+// Each level expands to two copies of the level below, so L10 is 1024
+// additions after preprocessing. Stresses macro expansion and constant folding.
+#define L0(x) (x)
+#define L1(x) (L0(x) + L0((x) * 0.5))
+#define L2(x) (L1(x) + L1((x) * 0.5))
+#define L3(x) (L2(x) + L2((x) * 0.5))
+#define L4(x) (L3(x) + L3((x) * 0.5))
+#define L5(x) (L4(x) + L4((x) * 0.5))
+#define L6(x) (L5(x) + L5((x) * 0.5))
+#define L7(x) (L6(x) + L6((x) * 0.5))
+#define L8(x) (L7(x) + L7((x) * 0.5))
+#define L9(x) (L8(x) + L8((x) * 0.5))
+#define L10(x) (L9(x) + L9((x) * 0.5))
+
+#define CHANNEL(v, k) L8((v) * float(k))
+#define OP(a, b) ((a) * (b) + (b))
+#define SWAP(a, b) vec2((b), (a))
+
+#if defined(GL_ES) || 0 < 1000
+  #if defined(GL_ES) || 1 < 1000
+    #if defined(GL_ES) || 2 < 1000
+      #if defined(GL_ES) || 3 < 1000
+        #if defined(GL_ES) || 4 < 1000
+          #if defined(GL_ES) || 5 < 1000
+            #if defined(GL_ES) || 6 < 1000
+              #if defined(GL_ES) || 7 < 1000
+                #if defined(GL_ES) || 8 < 1000
+                  #if defined(GL_ES) || 9 < 1000
+                    #if defined(GL_ES) || 10 < 1000
+                      #if defined(GL_ES) || 11 < 1000
+                        #if defined(GL_ES) || 12 < 1000
+                          #if defined(GL_ES) || 13 < 1000
+                            #if defined(GL_ES) || 14 < 1000
+                              #if defined(GL_ES) || 15 < 1000
+                                #if defined(GL_ES) || 16 < 1000
+                                  #if defined(GL_ES) || 17 < 1000
+                                    #if defined(GL_ES) || 18 < 1000
+                                      #if defined(GL_ES) || 19 < 1000
+                                        #if defined(GL_ES) || 20 < 1000
+                                          #if defined(GL_ES) || 21 < 1000
+                                            #if defined(GL_ES) || 22 < 1000
+                                              #if defined(GL_ES) || 23 < 1000
+                                                #define NESTED_OK 1
+                                              #endif
+                                            #endif
+                                          #endif
+                                        #endif
+                                      #endif
+                                    #endif
+                                  #endif
+                                #endif
+                              #endif
+                            #endif
+                          #endif
+                        #endif
+                      #endif
+                    #endif
+                  #endif
+                #endif
+              #endif
+            #endif
+          #endif
+        #endif
+      #endif
+    #endif
+  #endif
+#endif
+
+uniform float u_scale;
+uniform vec2 u_offset;
+varying vec2 v_uv;
+
+#define TERM0(p) OP(CHANNEL((p).x, 1), CHANNEL((p).y, 16))
+#define TERM1(p) OP(CHANNEL((p).x, 2), CHANNEL((p).y, 15))
+#define TERM2(p) OP(CHANNEL((p).x, 3), CHANNEL((p).y, 14))
+#define TERM3(p) OP(CHANNEL((p).x, 4), CHANNEL((p).y, 13))
+#define TERM4(p) OP(CHANNEL((p).x, 5), CHANNEL((p).y, 12))
+#define TERM5(p) OP(CHANNEL((p).x, 6), CHANNEL((p).y, 11))
+#define TERM6(p) OP(CHANNEL((p).x, 7), CHANNEL((p).y, 10))
+#define TERM7(p) OP(CHANNEL((p).x, 8), CHANNEL((p).y, 9))
+#define TERM8(p) OP(CHANNEL((p).x, 9), CHANNEL((p).y, 8))
+#define TERM9(p) OP(CHANNEL((p).x, 10), CHANNEL((p).y, 7))
+#define TERM10(p) OP(CHANNEL((p).x, 11), CHANNEL((p).y, 6))
+#define TERM11(p) OP(CHANNEL((p).x, 12), CHANNEL((p).y, 5))
+#define TERM12(p) OP(CHANNEL((p).x, 13), CHANNEL((p).y, 4))
+#define TERM13(p) OP(CHANNEL((p).x, 14), CHANNEL((p).y, 3))
+#define TERM14(p) OP(CHANNEL((p).x, 15), CHANNEL((p).y, 2))
+#define TERM15(p) OP(CHANNEL((p).x, 16), CHANNEL((p).y, 1))
+
+float accumulate(vec2 p) {
+    float sum = 0.0;
+    sum += TERM0(SWAP(p.x, p.y));
+    sum += TERM1(SWAP(p.x, p.y));
+    sum += TERM2(SWAP(p.x, p.y));
+    sum += TERM3(SWAP(p.x, p.y));
+    sum += TERM4(SWAP(p.x, p.y));
+    sum += TERM5(SWAP(p.x, p.y));
+    sum += TERM6(SWAP(p.x, p.y));
+    sum += TERM7(SWAP(p.x, p.y));
+    sum += TERM8(SWAP(p.x, p.y));
+    sum += TERM9(SWAP(p.x, p.y));
+    sum += TERM10(SWAP(p.x, p.y));
+    sum += TERM11(SWAP(p.x, p.y));
+    sum += TERM12(SWAP(p.x, p.y));
+    sum += TERM13(SWAP(p.x, p.y));
+    sum += TERM14(SWAP(p.x, p.y));
+    sum += TERM15(SWAP(p.x, p.y));
+    return sum;
+}
+
+void main() {
+    vec2 p = v_uv * u_scale + u_offset;
+    float value = L10(p.x) + accumulate(p) * float(NESTED_OK);
+    gl_FragColor = vec4(fract(value), fract(value * 0.5), fract(value * 0.25), 1.0);
+}
@@ -0,0 +1,96 @@
+#version 300 es
+precision highp float;
+uniform vec3 iResolution;
+uniform float iTime;
+uniform vec4 iMouse;
+out vec4 out_FragColor;
+
+vec3 hash3(vec2 p) {
+    vec3 q = vec3(dot(p, vec2(127.1, 311.7)), dot(p, vec2(269.5, 183.3)), dot(p, vec2(419.2, 371.9)));
+    return fract(sin(q) * 43758.5453);
+}
+
+float hash(vec2 p) {
+    p = fract(p * vec2(123.34, 456.21));
+    p += dot(p, p + 45.32);
+    return fract(p.x * p.y);
+}
+
+float valueNoise(vec2 p) {
+    vec2 i = floor(p);
+    vec2 f = fract(p);
+    vec2 u = f * f * (3.0 - 2.0 * f);
+    return mix(mix(hash(i + vec2(0.0, 0.0)), hash(i + vec2(1.0, 0.0)), u.x),
+               mix(hash(i + vec2(0.0, 1.0)), hash(i + vec2(1.0, 1.0)), u.x), u.y);
+}
+
+vec2 grad(vec2 p) {
+    float a = hash(p) * 6.2831853;
+    return vec2(cos(a), sin(a));
+}
+
+float gradientNoise(vec2 p) {
+    vec2 i = floor(p);
+    vec2 f = fract(p);
+    vec2 u = f * f * f * (f * (f * 6.0 - 15.0) + 10.0);
+    float a = dot(grad(i + vec2(0.0, 0.0)), f - vec2(0.0, 0.0));
+    float b = dot(grad(i + vec2(1.0, 0.0)), f - vec2(1.0, 0.0));
+    float c = dot(grad(i + vec2(0.0, 1.0)), f - vec2(0.0, 1.0));
+    float d = dot(grad(i + vec2(1.0, 1.0)), f - vec2(1.0, 1.0));
+    return mix(mix(a, b, u.x), mix(c, d, u.x), u.y);
+}
+
+vec3 voronoi(vec2 x) {
+    vec2 n = floor(x);
+    vec2 f = fract(x);
+    vec3 m = vec3(8.0);
+    for (int j = -1; j <= 1; j++) {
+        for (int i = -1; i <= 1; i++) {
+            vec2 g = vec2(float(i), float(j));
+            vec3 o = hash3(n + g);
+            vec2 r = g - f + (0.5 + 0.5 * sin(iTime + 6.2831 * o.xy));
+            float d = dot(r, r);
+            if (d < m.x) m = vec3(d, o.z, o.x);
+        }
+    }
+    return vec3(sqrt(m.x), m.yz);
+}
+
+float fbm(vec2 p) {
+    float value = 0.0;
+    float amplitude = 0.5;
+    mat2 m = mat2(1.6, 1.2, -1.2, 1.6);
+    for (int i = 0; i < 8; i++) {
+        value += amplitude * gradientNoise(p);
+        p = m * p;
+        amplitude *= 0.5;
+    }
+    return value;
+}
+
+float domainWarp(vec2 p, out vec2 q, out vec2 r) {
+    q = vec2(fbm(p + vec2(0.0, 0.0)), fbm(p + vec2(5.2, 1.3)));
+    r = vec2(fbm(p + 4.0 * q + vec2(1.7, 9.2) + 0.15 * iTime), fbm(p + 4.0 * q + vec2(8.3, 2.8) + 0.126 * iTime));
+    return fbm(p + 4.0 * r);
+}
+
+vec3 palette(float t, vec3 a, vec3 b, vec3 c, vec3 d) {
+    return a + b * cos(6.28318 * (c * t + d));
+}
+
+void mainImage(out vec4 fragColor, in vec2 fragCoord) {
+    vec2 uv = fragCoord / iResolution.y;
+    vec2 q, r;
+    float f = domainWarp(uv * 3.0, q, r);
+    vec3 cells = voronoi(uv * 8.0 + iMouse.xy / iResolution.xy);
+
+    vec3 col = palette(f + cells.y * 0.2, vec3(0.5), vec3(0.5), vec3(1.0, 1.0, 0.5), vec3(0.8, 0.9, 0.3));
+    col = mix(col, vec3(0.9, 0.9, 0.6), dot(r, r) * 0.5);
+    col *= 0.8 + 0.2 * smoothstep(0.0, 0.05, cells.x);
+    col += 0.1 * valueNoise(fragCoord * 0.5);
+    fragColor = vec4(col, 1.0);
+}
+
+void main() {
+    mainImage(out_FragColor, gl_FragCoord.xy);
+}
@@ -0,0 +1,127 @@
+#version 300 es
+precision highp float;
+uniform vec3 iResolution;
+uniform float iTime;
+uniform vec4 iMouse;
+out vec4 out_FragColor;
+
+#define MAX_STEPS 128
+#define MAX_DIST 100.0
+#define SURF_DIST 0.001
+
+mat2 rot(float a) {
+    float s = sin(a), c = cos(a);
+    return mat2(c, -s, s, c);
+}
+
+float sdSphere(vec3 p, float r) { return length(p) - r; }
+
+float sdBox(vec3 p, vec3 b) {
+    vec3 q = abs(p) - b;
+    return length(max(q, 0.0)) + min(max(q.x, max(q.y, q.z)), 0.0);
+}
+
+float sdTorus(vec3 p, vec2 t) {
+    vec2 q = vec2(length(p.xz) - t.x, p.y);
+    return length(q) - t.y;
+}
+
+float sdCapsule(vec3 p, vec3 a, vec3 b, float r) {
+    vec3 pa = p - a, ba = b - a;
+    float h = clamp(dot(pa, ba) / dot(ba, ba), 0.0, 1.0);
+    return length(pa - ba * h) - r;
+}
+
+float smin(float a, float b, float k) {
+    float h = clamp(0.5 + 0.5 * (b - a) / k, 0.0, 1.0);
+    return mix(b, a, h) - k * h * (1.0 - h);
+}
+
+vec2 map(vec3 p) {
+    vec3 q = p;
+    q.xz *= rot(iTime * 0.3);
+    float ground = p.y + 1.0;
+    float sphere = sdSphere(q - vec3(0.0, 0.2 + 0.3 * sin(iTime), 0.0), 0.8);
+    float box = sdBox(q - vec3(1.8, 0.0, 0.0), vec3(0.5)) - 0.05;
+    float torus = sdTorus(q + vec3(1.8, 0.0, 0.0), vec2(0.6, 0.2));
+    float capsule = sdCapsule(q, vec3(0.0, -0.5, 1.8), vec3(0.0, 0.8, 1.8), 0.25);
+    float blob = smin(smin(sphere, box, 0.4), smin(torus, capsule, 0.4), 0.4);
+    return blob < ground ? vec2(blob, 1.0) : vec2(ground, 2.0);
+}
+
+vec2 rayMarch(vec3 ro, vec3 rd) {
+    float d = 0.0;
+    float material = 0.0;
+    for (int i = 0; i < MAX_STEPS; i++) {
+        vec2 h = map(ro + rd * d);
+        material = h.y;
+        d += h.x;
+        if (d > MAX_DIST || abs(h.x) < SURF_DIST) break;
+    }
+    return vec2(d, material);
+}
+
+vec3 getNormal(vec3 p) {
+    vec2 e = vec2(0.001, 0.0);
+    return normalize(map(p).x - vec3(map(p - e.xyy).x, map(p - e.yxy).x, map(p - e.yyx).x));
+}
+
+float softShadow(vec3 ro, vec3 rd, float mint, float maxt, float k) {
+    float res = 1.0;
+    float t = mint;
+    for (int i = 0; i < 64; i++) {
+        float h = map(ro + rd * t).x;
+        if (h < 0.0001) return 0.0;
+        res = min(res, k * h / t);
+        t += h;
+        if (t > maxt) break;
+    }
+    return clamp(res, 0.0, 1.0);
+}
+
+float ambientOcclusion(vec3 p, vec3 n) {
+    float occ = 0.0;
+    float scale = 1.0;
+    for (int i = 0; i < 5; i++) {
+        float h = 0.01 + 0.12 * float(i) / 4.0;
+        occ += (h - map(p + h * n).x) * scale;
+        scale *= 0.95;
+    }
+    return clamp(1.0 - 3.0 * occ, 0.0, 1.0);
+}
+
+vec3 checker(vec2 p) {
+    vec2 q = floor(p);
+    return mix(vec3(0.2), vec3(0.8), mod(q.x + q.y, 2.0));
+}
+
+void mainImage(out vec4 fragColor, in vec2 fragCoord) {
+    vec2 uv = (fragCoord - 0.5 * iResolution.xy) / iResolution.y;
+    vec2 mouse = iMouse.xy / iResolution.xy;
+
+    vec3 ro = vec3(0.0, 1.5, -5.0);
+    ro.yz *= rot(-mouse.y + 0.2);
+    ro.xz *= rot(-mouse.x * 6.2831);
+    vec3 forward = normalize(-ro);
+    vec3 right = normalize(cross(vec3(0.0, 1.0, 0.0), forward));
+    vec3 up = cross(forward, right);
+    vec3 rd = normalize(forward + uv.x * right + uv.y * up);
+
+    vec3 col = vec3(0.6, 0.7, 0.9) - rd.y * 0.4;
+    vec2 hit = rayMarch(ro, rd);
+    if (hit.x < MAX_DIST) {
+        vec3 p = ro + rd * hit.x;
+        vec3 n = getNormal(p);
+        vec3 lightDir = normalize(vec3(0.6, 0.8, -0.4));
+        float diffuse = max(dot(n, lightDir), 0.0) * softShadow(p + n * 0.01, lightDir, 0.02, 10.0, 16.0);
+        float specular = pow(max(dot(reflect(-lightDir, n), -rd), 0.0), 32.0);
+        vec3 albedo = hit.y > 1.5 ? checker(p.xz) : 0.5 + 0.5 * cos(iTime + p.xyx + vec3(0.0, 2.0, 4.0));
+        col = albedo * (0.15 * ambientOcclusion(p, n) + diffuse) + specular * diffuse;
+        col = mix(col, vec3(0.6, 0.7, 0.9), 1.0 - exp(-0.002 * hit.x * hit.x));
+    }
+    fragColor = vec4(pow(col, vec3(0.4545)), 1.0);
+}
+
+void main() {
+    mainImage(out_FragColor, gl_FragCoord.xy);
+}
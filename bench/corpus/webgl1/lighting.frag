@@ -0,0 +1,45 @@
+precision mediump float;
+
+#define NUM_LIGHTS 4
+
+struct Light {
+    vec3 position;
+    vec3 color;
+    float radius;
+};
+
+uniform Light u_lights[NUM_LIGHTS];
+uniform vec3 u_cameraPosition;
+uniform sampler2D u_diffuseMap;
+uniform sampler2D u_specularMap;
+uniform float u_shininess;
+
+varying vec3 v_worldPosition;
+varying vec3 v_normal;
+varying vec2 v_texCoord;
+
+vec3 shade(Light light, vec3 normal, vec3 viewDir, vec3 albedo, float specularStrength) {
+    vec3 toLight = light.position - v_worldPosition;
+    float distance = length(toLight);
+    vec3 lightDir = toLight / distance;
+    float attenuation = clamp(1.0 - distance / light.radius, 0.0, 1.0);
+    attenuation *= attenuation;
+
+    float diffuse = max(dot(normal, lightDir), 0.0);
+    vec3 halfway = normalize(lightDir + viewDir);
+    float specular = pow(max(dot(normal, halfway), 0.0), u_shininess) * specularStrength;
+    return (albedo * diffuse + vec3(specular)) * light.color * attenuation;
+}
+
+void main() {
+    vec3 normal = normalize(v_normal);
+    vec3 viewDir = normalize(u_cameraPosition - v_worldPosition);
+    vec3 albedo = texture2D(u_diffuseMap, v_texCoord).rgb;
+    float specularStrength = texture2D(u_specularMap, v_texCoord).r;
+
+    vec3 color = albedo * 0.05;
+    for (int i = 0; i < NUM_LIGHTS; ++i) {
+        color += shade(u_lights[i], normal, viewDir, albedo, specularStrength);
+    }
+    gl_FragColor = vec4(pow(color, vec3(1.0 / 2.2)), 1.0);
+}
@@ -0,0 +1,20 @@
+attribute vec3 a_position;
+attribute vec3 a_normal;
+attribute vec2 a_texCoord;
+
+uniform mat4 u_model;
+uniform mat4 u_view;
+uniform mat4 u_projection;
+uniform mat3 u_normalMatrix;
+
+varying vec3 v_worldPosition;
+varying vec3 v_normal;
+varying vec2 v_texCoord;
+
+void main() {
+    vec4 worldPosition = u_model * vec4(a_position, 1.0);
+    v_worldPosition = worldPosition.xyz;
+    v_normal = normalize(u_normalMatrix * a_normal);
+    v_texCoord = a_texCoord;
+    gl_Position = u_projection * u_view * worldPosition;
+}
@@ -0,0 +1,10 @@
+precision mediump float;
+
+uniform sampler2D u_sampler;
+uniform vec4 u_tint;
+
+varying vec2 v_texCoord;
+
+void main() {
+    gl_FragColor = texture2D(u_sampler, v_texCoord) * u_tint;
+}
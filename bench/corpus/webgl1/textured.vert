@@ -0,0 +1,11 @@
+attribute vec3 a_position;
+attribute vec2 a_texCoord;
+
+uniform mat4 u_modelViewProjection;
+
+varying vec2 v_texCoord;
+
+void main() {
+    v_texCoord = a_texCoord;
+    gl_Position = u_modelViewProjection * vec4(a_position, 1.0);
+}
@@ -0,0 +1,23 @@
+#version 300 es
+
+layout(location = 0) in vec3 a_position;
+layout(location = 1) in vec3 a_normal;
+layout(location = 2) in mat4 a_instanceModel;
+layout(location = 6) in vec4 a_instanceColor;
+
+uniform SceneUniforms {
+    mat4 u_view;
+    mat4 u_projection;
+    vec4 u_lightDirection;
+};
+
+out vec3 v_normal;
+out vec4 v_color;
+flat out int v_instance;
+
+void main() {
+    v_normal = mat3(a_instanceModel) * a_normal;
+    v_color = a_instanceColor;
+    v_instance = gl_InstanceID;
+    gl_Position = u_projection * u_view * a_instanceModel * vec4(a_position, 1.0);
+}
@@ -0,0 +1,94 @@
+#version 300 es
+precision highp float;
+
+const float PI = 3.14159265359;
+
+uniform MaterialUniforms {
+    vec4 u_baseColor;
+    float u_metallic;
+    float u_roughness;
+    float u_exposure;
+};
+
+uniform sampler2D u_albedoMap;
+uniform sampler2D u_normalMap;
+uniform samplerCube u_irradianceMap;
+uniform samplerCube u_prefilterMap;
+uniform sampler2D u_brdfLut;
+uniform vec3 u_cameraPosition;
+uniform vec3 u_lightPositions[4];
+uniform vec3 u_lightColors[4];
+
+in vec3 v_worldPosition;
+in vec3 v_normal;
+in vec2 v_texCoord;
+in vec3 v_tangent;
+
+out vec4 fragColor;
+
+float distributionGGX(vec3 n, vec3 h, float roughness) {
+    float a = roughness * roughness;
+    float a2 = a * a;
+    float nDotH = max(dot(n, h), 0.0);
+    float denom = nDotH * nDotH * (a2 - 1.0) + 1.0;
+    return a2 / (PI * denom * denom);
+}
+
+float geometrySchlickGGX(float nDotV, float roughness) {
+    float k = (roughness + 1.0) * (roughness + 1.0) / 8.0;
+    return nDotV / (nDotV * (1.0 - k) + k);
+}
+
+float geometrySmith(vec3 n, vec3 v, vec3 l, float roughness) {
+    return geometrySchlickGGX(max(dot(n, v), 0.0), roughness) * geometrySchlickGGX(max(dot(n, l), 0.0), roughness);
+}
+
+vec3 fresnelSchlick(float cosTheta, vec3 f0) {
+    return f0 + (1.0 - f0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
+}
+
+vec3 fresnelSchlickRoughness(float cosTheta, vec3 f0, float roughness) {
+    return f0 + (max(vec3(1.0 - roughness), f0) - f0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
+}
+
+vec3 perturbNormal() {
+    vec3 tangentNormal = texture(u_normalMap, v_texCoord).xyz * 2.0 - 1.0;
+    vec3 n = normalize(v_normal);
+    vec3 t = normalize(v_tangent - dot(v_tangent, n) * n);
+    vec3 b = cross(n, t);
+    return normalize(mat3(t, b, n) * tangentNormal);
+}
+
+void main() {
+    vec3 albedo = pow(texture(u_albedoMap, v_texCoord).rgb, vec3(2.2)) * u_baseColor.rgb;
+    vec3 n = perturbNormal();
+    vec3 v = normalize(u_cameraPosition - v_worldPosition);
+    vec3 r = reflect(-v, n);
+    vec3 f0 = mix(vec3(0.04), albedo, u_metallic);
+
+    vec3 lo = vec3(0.0);
+    for (int i = 0; i < 4; ++i) {
+        vec3 l = normalize(u_lightPositions[i] - v_worldPosition);
+        vec3 h = normalize(v + l);
+        float distance = length(u_lightPositions[i] - v_worldPosition);
+        vec3 radiance = u_lightColors[i] / (distance * distance);
+
+        float ndf = distributionGGX(n, h, u_roughness);
+        float g = geometrySmith(n, v, l, u_roughness);
+        vec3 f = fresnelSchlick(max(dot(h, v), 0.0), f0);
+
+        vec3 specular = ndf * g * f / (4.0 * max(dot(n, v), 0.0) * max(dot(n, l), 0.0) + 0.0001);
+        vec3 kd = (vec3(1.0) - f) * (1.0 - u_metallic);
+        lo += (kd * albedo / PI + specular) * radiance * max(dot(n, l), 0.0);
+    }
+
+    vec3 f = fresnelSchlickRoughness(max(dot(n, v), 0.0), f0, u_roughness);
+    vec3 kd = (1.0 - f) * (1.0 - u_metallic);
+    vec3 diffuse = texture(u_irradianceMap, n).rgb * albedo;
+    vec3 prefiltered = textureLod(u_prefilterMap, r, u_roughness * 4.0).rgb;
+    vec2 brdf = texture(u_brdfLut, vec2(max(dot(n, v), 0.0), u_roughness)).rg;
+    vec3 ambient = kd * diffuse + prefiltered * (f * brdf.x + brdf.y);
+
+    vec3 color = vec3(1.0) - exp(-(ambient + lo) * u_exposure);
+    fragColor = vec4(pow(color, vec3(1.0 / 2.2)), u_baseColor.a);
+}
@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+"""
+Translation throughput benchmark.
+
+Runs every shader of bench/corpus/manifest.json for each spec x output
+combination and reports shaders/sec, p50/p99 latency and peak memory as JSON.
+
+    # WASM module through the angle_translator package (default)
+    python bench/run_bench.py --output wasm.json
+
+    # Another WASM build, e.g. from BUILD_PROFILE=release scripts/build.sh
+    python bench/run_bench.py --wasm build/angle_shader_translator_standalone.wasm --output release.json
+
+    # Native binary, which runs the same corpus in-process with --bench
+    python bench/run_bench.py --native build/angle_shader_translator_standalone --output native.json
+
+    # Compare two reports, e.g. from before and after a change
+    python bench/run_bench.py --compare before.json after.json
+
+Compilers are warmed up before timing and the translation result cache is
+disabled, so repeated shaders are really recompiled.
+"""
+
+import argparse
+import json
+import os
+import resource
+import subprocess
+import sys
+import time
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_MANIFEST = os.path.join(BENCH_DIR, "corpus", "manifest.json")
+
+def percentile(sorted_values, q):
+    """Nearest-rank percentile, matching the native runner."""
+    rank = max(1, min(len(sorted_values), int(q * len(sorted_values) + 0.999999)))
+    return sorted_values[rank - 1]
+
+def peak_rss_kb():
+    peak = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+    return peak // 1024 if sys.platform == "darwin" else peak  # macOS reports bytes
+
+def load_corpus(manifest_path):
+    with open(manifest_path) as f:
+        manifest = json.load(f)
+    base_dir = os.path.dirname(os.path.abspath(manifest_path))
+    shaders = []
+    specs = []
+    for entry in manifest["shaders"]:
+        with open(os.path.join(base_dir, entry["file"])) as f:
+            source = f.read()
+        entry_specs = entry.get("specs", ["webgl"])
+        shaders.append({"file": entry["file"], "shader_type": entry["shader_type"], "specs": entry_specs, "source": source})
+        specs.extend(spec for spec in entry_specs if spec not in specs)
+    return shaders, specs, manifest.get("outputs", ["essl"])
+
+def run_wasm(manifest_path, iterations, print_vars, wasm_path=None):
+    from angle_translator import ShaderTranslator
+
+    start = time.perf_counter()
+    if wasm_path:
+        # Compiled from scratch, so startup_ms includes the JIT compile that
+        # the bundled module's precompiled cache otherwise skips.
+        from wasmtime import Module
+        from angle_translator.translator import _make_engine
+        engine = _make_engine()
+        translator = ShaderTranslator(engine, Module.from_file(engine, wasm_path))
+    else:
+        translator = ShaderTranslator()
+    startup_ms = (time.perf_counter() - start) * 1e3
+    translator.cache_clear(max_bytes=0)
+
+    shaders, specs, outputs = load_corpus(manifest_path)
+    results = []
+    with translator:
+        for spec in specs:
+            for output in outputs:
+                selected = [shader for shader in shaders if spec in shader["specs"]]
+
+                def translate(shader):
+                    return translator.translate_shader(shader["source"], shader["shader_type"], spec=spec,
+                                                       output=output, print_vars=print_vars)
+
+                per_shader = []
+                failures = 0
+                for shader in selected:
+                    failed = "error" in translate(shader)
+                    failures += failed
+                    per_shader.append({"file": shader["file"], "failed": failed})
+
+                latencies = []
+                shader_latencies = [[] for _ in selected]
+                for _ in range(iterations):
+                    for i, shader in enumerate(selected):
+                        begin = time.perf_counter_ns()
+                        translate(shader)
+                        us = (time.perf_counter_ns() - begin) / 1e3
+                        latencies.append(us)
+                        shader_latencies[i].append(us)
+
+                combination = {"spec": spec, "output": output, "shaders": len(selected),
+                               "translations": len(latencies), "failures": failures}
+                if latencies:
+                    total_us = sum(latencies)
+                    latencies.sort()
+                    combination.update({
+                        "shaders_per_sec": len(latencies) * 1e6 / total_us if total_us else 0.0,
+                        "mean_us": total_us / len(latencies),
+                        "p50_us": percentile(latencies, 0.50),
+                        "p99_us": percentile(latencies, 0.99),
+                    })
+                    for entry, samples in zip(per_shader, shader_latencies):
+                        entry["p50_us"] = percentile(sorted(samples), 0.50)
+                combination["peak_rss_kb"] = peak_rss_kb()
+                combination["per_shader"] = per_shader
+                results.append(combination)
+        wasm_memory_kb = translator.stats()["memory"]["process_kb"]
+
+    return {
+        "backend": "wasm",
+        "module": wasm_path or "bundled",
+        "corpus": manifest_path,
+        "iterations": iterations,
+        "print_active_variables": print_vars,
+        "startup_ms": startup_ms,
+        "peak_rss_kb": peak_rss_kb(),
+        "wasm_memory_kb": wasm_memory_kb,
+        "results": results,
+    }
+
+def run_native(binary, manifest_path, iterations, print_vars):
+    command = [binary, f"--bench={manifest_path}", f"--iterations={iterations}"]
+    if print_vars:
+        command.append("--active-variables")
+    completed = subprocess.run(command, check=True, stdout=subprocess.PIPE)
+    return json.loads(completed.stdout)
+
+def compare(old_path, new_path):
+    with open(old_path) as f:
+        old = {(r["spec"], r["output"]): r for r in json.load(f)["results"]}
+    with open(new_path) as f:
+        new = json.load(f)["results"]
+
+    print(f"{'spec':<8} {'output':<9} {'shaders/sec':>22} {'p50 us':>22} {'p99 us':>22}")
+    for result in new:
+        before = old.get((result["spec"], result["output"]))
+        if not before or "shaders_per_sec" not in result or "shaders_per_sec" not in before:
+            continue
+        cells = []
+        for key in ("shaders_per_sec", "p50_us", "p99_us"):
+            delta = (result[key] - before[key]) / before[key] * 100 if before[key] else 0.0
+            cells.append(f"{before[key]:>8.1f} -> {result[key]:>8.1f} {delta:+5.0f}%")
+        print(f"{result['spec']:<8} {result['output']:<9} " + " ".join(cells))
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--manifest", default=DEFAULT_MANIFEST, help="corpus manifest (default: bench/corpus/manifest.json)")
+    parser.add_argument("--iterations", type=int, default=20, help="timed passes over the corpus per combination")
+    parser.add_argument("--active-variables", action="store_true", help="also serialize active variables")
+    parser.add_argument("--native", metavar="BINARY", help="benchmark a native translator binary instead of the WASM module")
+    parser.add_argument("--wasm", metavar="MODULE", help="benchmark this .wasm file instead of the bundled module")
+    parser.add_argument("--output", help="write the JSON report here instead of stdout")
+    parser.add_argument("--compare", nargs=2, metavar=("OLD", "NEW"), help="compare two reports and exit")
+    args = parser.parse_args()
+
+    if args.compare:
+        compare(*args.compare)
+        return
+
+    if args.native:
+        report = run_native(args.native, args.manifest, args.iterations, args.active_variables)
+    else:
+        report = run_wasm(args.manifest, args.iterations, args.active_variables, args.wasm)
+
+    text = json.dumps(report, indent=2)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text + "\n")
+    else:
+        print(text)
+
+if __name__ == "__main__":
+    main()
@@ -37,20 +37,45 @@ rm -rf ${BUILD_DIR} # Clean previous build
 mkdir -p ${BUILD_DIR}
 cd ${BUILD_DIR}
 
+# BUILD_PROFILE=size (the default) optimizes for download size; release
+# optimizes for speed (see TRANSLATOR_RELEASE_PROFILE in CMakeLists.txt).
+BUILD_PROFILE="${BUILD_PROFILE:-size}"
+case "${BUILD_PROFILE}" in
+    size)
+        CMAKE_PROFILE_ARGS=""
+        WASM_OPT_ARGS="-Oz"
+        ;;
+    release)
+        CMAKE_PROFILE_ARGS="-DCMAKE_BUILD_TYPE=Release -DTRANSLATOR_RELEASE_PROFILE=ON"
+        # SIMD and the other features in use are read from the module's target_features section.
+        WASM_OPT_ARGS="-O4 --converge"
+        ;;
+    *)
+        echo "Error: BUILD_PROFILE must be 'size' or 'release', not '${BUILD_PROFILE}'."
+        exit 1
+        ;;
+esac
+
 # Configure the project using emcmake for the Emscripten toolchain.
-emcmake cmake .. -DANGLE_ROOT=/workspace/angle
+emcmake cmake .. -DANGLE_ROOT=/workspace/angle ${CMAKE_PROFILE_ARGS}
 
-# Compile the target specified in your CMakeLists.txt
-make angle_shader_translator_standalone
+# Compile the module variants: standalone (ESSL/GLSL), spirv and hlsl.
+# Set TRANSLATOR_VARIANTS to build fewer, e.g. TRANSLATOR_VARIANTS=standalone.
+VARIANTS="${TRANSLATOR_VARIANTS:-standalone spirv hlsl}"
+for variant in ${VARIANTS}; do
+    make angle_shader_translator_${variant}
+done
 
 # Create the final output directory.
 cd /workspace
 rm -rf ${WASM_OUT_DIR} # Clean previous output
 mkdir -p ${WASM_OUT_DIR}
 
-# Optimize the wasm binary with wasm-opt and copy the artifacts.
+# Optimize the wasm binaries with wasm-opt and copy the artifacts.
 echo "--- Optimizing and copying final artifacts ---"
-wasm-opt -Oz -o ${WASM_OUT_DIR}/angle_shader_translator_standalone.wasm ${BUILD_DIR}/angle_shader_translator_standalone.wasm
+for variant in ${VARIANTS}; do
+    wasm-opt ${WASM_OPT_ARGS} -o ${WASM_OUT_DIR}/angle_shader_translator_${variant}.wasm ${BUILD_DIR}/angle_shader_translator_${variant}.wasm
+done
 cp ${BUILD_DIR}/angle_shader_translator_standalone.js ${WASM_OUT_DIR}/
 
 echo "--- Build complete. Artifacts are in the ${WASM_OUT_DIR} directory. ---"
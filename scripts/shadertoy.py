@@ -72,7 +72,7 @@ class ShaderTranslator:
                 "shader_type": shader_type,
                 "spec": spec, "output": output,
                 "print_active_variables": True,
-                "compile_options": {"objectCode": True}
+                "compile_options": {"object_code": True}
             }
         }
         request_str = json.dumps(request_payload)
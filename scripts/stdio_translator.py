@@ -7,14 +7,22 @@ import os
 import re
 import json     # For ShaderTranslatorRPCClient
 import base64   # For ShaderTranslatorRPCClient
+import threading # For pipelined requests
 
 # --- ShaderTranslatorRPCClient Class (from previous responses) ---
 # Ensure this class definition is included here. For brevity, I'm assuming it's
 # the version we developed that handles JSON RPC, process management, and base64.
 # If you need it again, I can paste the full class.
 class ShaderTranslatorRPCClient:
-    def __init__(self, translator_executable_path):
+    def __init__(self, translator_executable_path, framing="content-length"):
+        """
+        framing: "content-length" sends each message with a Content-Length header, so
+                 large shaders are read in one piece; "lines" uses one JSON object per line.
+        """
+        if framing not in ("content-length", "lines"):
+            raise ValueError(f"Unknown framing '{framing}'")
         self.executable_path = translator_executable_path
+        self.framing = framing
         self.process = None
         self.request_id_counter = 0
         self._start_process()
@@ -29,15 +37,13 @@ class ShaderTranslatorRPCClient:
             raise PermissionError(f"Translator executable at {self.executable_path} is not executable")
 
         try:
+            # Binary, fully buffered pipes: messages are flushed explicitly once
+            # everything that is ready has been written.
             self.process = subprocess.Popen(
-                [self.executable_path, "--json-rpc"],
+                [self.executable_path, "--json-rpc", f"--framing={self.framing}"],
                 stdin=subprocess.PIPE,
                 stdout=subprocess.PIPE,
                 stderr=subprocess.PIPE,
-                text=True,
-                bufsize=1, 
-                universal_newlines=True, # Ensures text mode for pipes
-                encoding='utf-8' # Explicitly set encoding
             )
         except Exception as e:
             raise ConnectionError(f"Failed to start translator subprocess: {e}")
@@ -47,6 +53,84 @@ class ShaderTranslatorRPCClient:
         self.request_id_counter += 1
         return f"py_req_{self.request_id_counter}_{time.time_ns()}" # More unique ID
 
+    def _write_message(self, message: dict):
+        data = json.dumps(message).encode("utf-8")
+        if self.framing == "content-length":
+            self.process.stdin.write(b"Content-Length: %d\r\n\r\n" % len(data) + data)
+        else:
+            self.process.stdin.write(data + b"\n")
+
+    def _read_message(self):
+        """Reads one response, or returns None at end of output."""
+        if self.framing == "lines":
+            line = self.process.stdout.readline()
+            return json.loads(line) if line else None
+        length = None
+        while True:
+            header = self.process.stdout.readline()
+            if not header:
+                return None
+            header = header.strip()
+            if not header:
+                if length is not None:
+                    break
+                continue
+            name, _, value = header.partition(b":")
+            if name.strip().lower() == b"content-length":
+                length = int(value)
+        data = self.process.stdout.read(length)
+        if len(data) < length:
+            return None
+        return json.loads(data)
+
+    def send_pipelined(self, requests) -> list:
+        """
+        Sends many requests without waiting for each response.
+
+        Args:
+            requests (iterable): (method, params) tuples.
+
+        Returns:
+            list: The responses in request order, matched by "id", since the
+                  translator may answer out of order when run with --workers.
+        """
+        if not self.process or self.process.poll() is not None:
+            self._start_process()
+
+        messages = []
+        for method, params in requests:
+            messages.append({"jsonrpc": "2.0", "method": method, "params": params,
+                             "id": self._generate_request_id()})
+
+        # Writing from a separate thread keeps both pipes moving: the translator
+        # blocks on a full stdout pipe if nobody reads it while we are still writing.
+        write_error = []
+        def writer():
+            try:
+                for message in messages:
+                    self._write_message(message)
+                self.process.stdin.flush()
+            except Exception as e:
+                write_error.append(e)
+        writer_thread = threading.Thread(target=writer, daemon=True)
+        writer_thread.start()
+
+        responses = {}
+        while len(responses) < len(messages):
+            response = self._read_message()
+            if response is None:
+                break
+            responses[response.get("id")] = response
+        writer_thread.join()
+
+        if len(responses) < len(messages):
+            self.process.poll()
+            cause = f" ({write_error[0]})" if write_error else ""
+            raise ConnectionError(
+                f"Translator answered {len(responses)} of {len(messages)} pipelined requests{cause}. "
+                f"Return code: {self.process.returncode}.")
+        return [responses[message["id"]] for message in messages]
+
     def _send_request(self, method: str, params: dict) -> dict:
         if not self.process or self.process.poll() is not None:
             # print("DEBUG: Translator process is not running. Attempting to restart...")
@@ -61,19 +145,17 @@ class ShaderTranslatorRPCClient:
             "params": params,
             "id": request_id
         }
-        request_str = json.dumps(rpc_request)
-        
-        # print(f"DEBUG: Sending to C++ (ID: {request_id}): {request_str}")
+        # print(f"DEBUG: Sending to C++ (ID: {request_id}): {rpc_request}")
         try:
-            self.process.stdin.write(request_str + "\n")
+            self._write_message(rpc_request)
             self.process.stdin.flush()
 
             # It's crucial to handle the possibility of the process dying
-            # and readline() blocking indefinitely or returning empty.
-            response_str = self.process.stdout.readline()
-            # print(f"DEBUG: Received from C++ (ID: {request_id}): {response_str.strip()}")
+            # and the read blocking indefinitely or returning nothing.
+            response_json = self._read_message()
+            # print(f"DEBUG: Received from C++ (ID: {request_id}): {response_json}")
 
-            if not response_str: # Empty response often means process died
+            if response_json is None: # No response often means process died
                 self.process.poll() # Update returncode status
                 stderr_output = ""
                 try: # Try to grab stderr output non-blockingly if possible (tricky)
@@ -81,7 +163,7 @@ class ShaderTranslatorRPCClient:
                         # Reading all of stderr can block if the process is still writing.
                         # For a quick check, one might use select or a very short timeout read.
                         # For simplicity, let's assume a quick read is okay or it's already available.
-                         stderr_output = "".join(self.process.stderr.readlines() if self.process.stderr.readable() else [])
+                         stderr_output = b"".join(self.process.stderr.readlines() if self.process.stderr.readable() else []).decode("utf-8", "replace")
 
                 except Exception as e_stderr:
                     stderr_output = f"(Error reading stderr: {e_stderr})"
@@ -91,7 +173,6 @@ class ShaderTranslatorRPCClient:
                     f"Return code: {self.process.returncode}. Stderr hint: '{stderr_output.strip()}'"
                 )
 
-            response_json = json.loads(response_str)
             if response_json.get("id") != request_id:
                  # This is a more serious issue, indicates out-of-order or mismatched responses
                 print(f"CRITICAL WARNING: Response ID mismatch for request {request_id}. Expected {request_id}, got {response_json.get('id')}. Response: {response_json}")
@@ -101,14 +182,14 @@ class ShaderTranslatorRPCClient:
 
         except BrokenPipeError:
             self.process.poll()
-            stderr_output = "".join(self.process.stderr.readlines() if self.process.stderr and self.process.stderr.readable() else [])
+            stderr_output = b"".join(self.process.stderr.readlines() if self.process.stderr and self.process.stderr.readable() else []).decode("utf-8", "replace")
             raise ConnectionError(
                 f"Broken pipe for request {request_id}. Translator process likely crashed. "
                 f"Return code: {self.process.returncode}. Stderr: '{stderr_output.strip()}'"
             )
         except Exception as e:
             self.process.poll()
-            stderr_output = "".join(self.process.stderr.readlines() if self.process.stderr and self.process.stderr.readable() else [])
+            stderr_output = b"".join(self.process.stderr.readlines() if self.process.stderr and self.process.stderr.readable() else []).decode("utf-8", "replace")
             raise ConnectionError(
                 f"Exception during communication for request {request_id}: {type(e).__name__} - {e}. "
                 f"Return code: {self.process.returncode}. Stderr: '{stderr_output.strip()}'"
@@ -119,11 +200,29 @@ class ShaderTranslatorRPCClient:
                   compile_options: dict = None, 
                   resources: dict = None, 
                   print_active_variables: bool = False) -> dict:
-
-        shader_code_base64 = base64.b64encode(shader_code_str.encode('utf-8')).decode('ascii')
-        
+        params = self._translate_params(shader_code_str, shader_type, spec, output_format,
+                                        compile_options, resources, print_active_variables)
+        return self._translate_result(self._send_request("translate", params), params)
+
+    def translate_pipelined(self, shaders, spec: str, output_format: str,
+                            compile_options: dict = None,
+                            resources: dict = None,
+                            print_active_variables: bool = False) -> list:
+        """
+        Translates many (shader_code_str, shader_type) pairs in one pipelined
+        exchange and returns their results in order, like translate() would.
+        """
+        requests = [("translate", self._translate_params(code, shader_type, spec, output_format, compile_options,
+                                                         resources, print_active_variables))
+                    for code, shader_type in shaders]
+        responses = self.send_pipelined(requests)
+        return [self._translate_result(response, params) for response, (_, params) in zip(responses, requests)]
+
+    def _translate_params(self, shader_code_str, shader_type, spec, output_format,
+                          compile_options, resources, print_active_variables) -> dict:
+        # JSON already escapes the source safely, so send it as-is rather than base64.
         params = {
-            "shader_code_base64": shader_code_base64,
+            "shader_code": shader_code_str,
             "shader_type": shader_type,
             "spec": spec,
             "output": output_format,
@@ -138,9 +237,10 @@ class ShaderTranslatorRPCClient:
 
         if resources:
             params["resources"] = resources
+        return params
 
-        response = self._send_request("translate", params)
-
+    def _translate_result(self, response: dict, params: dict) -> dict:
+        final_compile_options = params["compile_options"]
         if "error" in response and response["error"] is not None:
             err = response["error"]
             error_message = f"ANGLE Translation Error (Code: {err.get('code')}, Method: translate): {err.get('message')}"
@@ -162,23 +262,20 @@ class ShaderTranslatorRPCClient:
             raise ValueError(f"Translation Error: 'result' field is missing or not a dictionary. "
                              f"InfoLog (if any): {info_log_details}. Full response: {response}")
 
-        translated_code_output = None
+        # Text outputs come back as 'object_code'; only binary SPIR-V is base64 encoded.
+        translated_code_output = result.get("object_code")
         translated_code_b64 = result.get("object_code_base64")
 
         if translated_code_b64 is not None: # Allow empty string for empty code
             try:
-                decoded_bytes = base64.b64decode(translated_code_b64)
-                if output_format == "spirv": # Add other binary output formats if any
-                    translated_code_output = decoded_bytes
-                else:
-                    translated_code_output = decoded_bytes.decode('utf-8')
+                translated_code_output = base64.b64decode(translated_code_b64)
             except Exception as e_decode:
                 raise ValueError(f"Error decoding base64 object code: {e_decode}. Base64 (first 100 chars): '{str(translated_code_b64)[:100]}'")
 
-        elif final_compile_options.get("object_code", True): # Object code was expected
-            # This is problematic if object_code was true and we got no 'object_code_base64' key
+        elif translated_code_output is None and final_compile_options.get("object_code", True): # Object code was expected
+            # This is problematic if object_code was true and we got neither key
              info_log_content = result.get('info_log', '(Info log not available in result)')
-             raise ValueError(f"Translation warning/error: 'object_code_base64' key missing in result, "
+             raise ValueError(f"Translation warning/error: 'object_code' key missing in result, "
                               f"though object_code was requested.\n--- ANGLE Info Log ---\n{info_log_content}\n----------------------")
 
 
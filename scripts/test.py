@@ -108,7 +108,7 @@ class ShaderTranslator:
                 "output": output,
                 "print_active_variables": print_vars,
                 "compile_options": {
-                    "objectCode": True
+                    "object_code": True
                 }
             }
         }
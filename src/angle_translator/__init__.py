@@ -1,5 +1,10 @@
 # src/angle_translator/__init__.py
 
-from .translator import ShaderTranslator
+from .translator import ShaderTranslator, load_module, default_module_cache_dir, output_variant
+from .pool import ShaderTranslatorPool
+from .disk_cache import TranslationDiskCache
+from .session import TranslationSession
+from .async_translator import AsyncShaderTranslator
+from .reflection import ActiveVariables
 
-__all__ = ["ShaderTranslator"]
\ No newline at end of file
+__all__ = ["ShaderTranslator", "ShaderTranslatorPool", "AsyncShaderTranslator", "TranslationSession", "TranslationDiskCache", "ActiveVariables", "load_module", "default_module_cache_dir", "output_variant"]
\ No newline at end of file
@@ -0,0 +1,264 @@
+# src/angle_translator/async_translator.py
+
+import asyncio
+import json
+import os
+
+from .pool import ShaderTranslatorPool
+from .translator import ShaderTranslator, _with_reflection
+
+class AsyncShaderTranslator:
+    """
+    Translates shaders from asyncio code without blocking the event loop.
+
+    By default requests run on a ShaderTranslatorPool, created here or passed
+    in. AsyncShaderTranslator.spawn() instead starts the native translator as
+    `--json-rpc --framing=content-length --workers=N` and keeps many requests
+    in flight on its pipes, matching the responses (which arrive in
+    completion order) to their requests by id.
+
+    At most max_in_flight requests are outstanding at once, by default twice
+    the number of workers so each has its next request queued; further calls
+    wait for a slot, so a burst of callers waits here instead of piling up
+    unbounded queues in the pool or the pipe.
+
+    Use it as an async context manager or await aclose(). A pool-backed
+    translator can be used from several event loops in turn; a spawned one
+    only from the loop spawn() ran on, which owns its pipes.
+    """
+    IN_FLIGHT_PER_WORKER = 2
+
+    def __init__(self, pool: ShaderTranslatorPool = None, max_in_flight: int = None, **pool_options):
+        """
+        Args:
+            pool (ShaderTranslatorPool, optional): The pool to translate on; it
+                                  stays open when this is closed. Without one,
+                                  a pool is created from pool_options (size,
+                                  timeout_ms, cache_dir, backend, ...) and
+                                  closed with this.
+            max_in_flight (int, optional): Bound on outstanding requests.
+                                  Defaults to IN_FLIGHT_PER_WORKER per worker.
+        """
+        self._owns_pool = pool is None
+        self._pool = ShaderTranslatorPool(**pool_options) if pool is None else pool
+        self._server = None
+        self._init_limit(max_in_flight, self._pool.size)
+
+    @classmethod
+    async def spawn(cls, executable: str, workers: int = None, max_in_flight: int = None, server_args=()):
+        """
+        Starts a native translator process and returns a translator using it.
+
+        Args:
+            executable (str): Path to the native angle_shader_translator.
+            workers (int, optional): Its --workers count. Defaults to os.cpu_count().
+            max_in_flight (int, optional): As for the constructor.
+            server_args (iterable, optional): More server options, e.g.
+                                  "--timeout-ms=500" or "--disk-cache=DIR".
+
+        Raises:
+            FileNotFoundError, PermissionError: If executable cannot be run.
+        """
+        workers = workers or os.cpu_count() or 1
+        self = cls.__new__(cls)
+        self._owns_pool = False
+        self._pool = None
+        self._server = await _ServerProcess.start(executable, workers, server_args)
+        self._init_limit(max_in_flight, workers)
+        return self
+
+    def _init_limit(self, max_in_flight: int, workers: int):
+        self.max_in_flight = max_in_flight or self.IN_FLIGHT_PER_WORKER * workers
+        self._slots = None  # Created on first use, inside the running loop
+        self._slots_loop = None
+        self._closed = False
+
+    async def translate(self, shader_code: str, shader_type: str, **kwargs) -> dict:
+        """
+        Translates one shader; takes the same arguments as
+        ShaderTranslator.translate_shader and returns its response dict.
+
+        With spawn(), profile_id refers to a profile registered on the server
+        through request("register_profile", ...). A keep_reflection handle is
+        only good on the instance that returned it, so fetch its lists with
+        request("get_reflection", ...) under spawn() or the native backend,
+        where there is one.
+        """
+        if self._server is None:
+            return await self._run(lambda: self._pool.submit(shader_code, shader_type, **kwargs))
+        return _with_reflection(await self.request("translate", self._translate_params(shader_code, shader_type, **kwargs)))
+
+    async def map(self, shaders, **kwargs) -> list:
+        """
+        Translates every (shader_code, shader_type) tuple or dict with those
+        keys, with kwargs as for translate(), and returns the responses in
+        input order.
+        """
+        items = [(shader["shader_code"], shader["shader_type"]) if isinstance(shader, dict) else shader
+                 for shader in shaders]
+        return await asyncio.gather(*(self.translate(code, shader_type, **kwargs) for code, shader_type in items))
+
+    async def request(self, method: str, params: dict = None) -> dict:
+        """Sends any JSON-RPC request (stats, register_profile, ...) and returns the response."""
+        if self._server is None:
+            return await self._run(lambda: self._pool._submit("_send_request", (method, params or {}), {}))
+        slots = await self._acquire()
+        try:
+            return await self._server.request(method, params or {})
+        finally:
+            slots.release()
+
+    async def aclose(self):
+        """Waits for the outstanding requests, then stops the server or the owned pool."""
+        if self._closed:
+            return
+        self._closed = True
+        if self._server is not None:
+            await self._server.close()
+        elif self._owns_pool:
+            await asyncio.get_running_loop().run_in_executor(None, self._pool.close)
+
+    async def __aenter__(self):
+        return self
+
+    async def __aexit__(self, exc_type, exc_val, exc_tb):
+        await self.aclose()
+
+    async def _acquire(self) -> asyncio.Semaphore:
+        """Waits for a slot and returns the semaphore to release it on."""
+        if self._closed:
+            raise RuntimeError("Translator has been closed and cannot be used.")
+        loop = asyncio.get_running_loop()
+        if self._slots is None or self._slots_loop is not loop:
+            # A semaphore belongs to the loop it first waits on
+            self._slots = asyncio.Semaphore(self.max_in_flight)
+            self._slots_loop = loop
+        slots = self._slots
+        await slots.acquire()
+        return slots
+
+    async def _run(self, submit) -> dict:
+        slots = await self._acquire()
+        try:
+            return await asyncio.wrap_future(submit())
+        finally:
+            slots.release()
+
+    @staticmethod
+    def _translate_params(shader_code: str, shader_type: str, spec: str = "webgl", output: str = "essl",
+                          print_vars: bool = True, enable_name_hashing: bool = False, optimize: int = 0,
+                          profile: bool = False, profile_id: int = None, timeout_ms: int = None,
+                          reflection_format: str = "json", reflect: list = None,
+                          keep_reflection: bool = False) -> dict:
+        if profile_id is not None:
+            params = {"profile_id": profile_id}
+        else:
+            params = ShaderTranslator._options_params(spec, output, print_vars, enable_name_hashing, optimize,
+                                                      reflection_format, reflect)
+        params["shader_code"] = shader_code
+        params["shader_type"] = shader_type
+        if keep_reflection:
+            params["keep_reflection"] = True
+        if profile:
+            params["profile"] = True
+        if timeout_ms is not None:
+            params["timeout_ms"] = timeout_ms
+        return params
+
+
+class _ServerProcess:
+    """The native JSON-RPC server as an asyncio subprocess, with requests matched by id."""
+
+    def __init__(self, process):
+        self._loop = asyncio.get_running_loop()
+        self._process = process
+        self._pending = {}
+        self._next_id = 0
+        self._failure = None
+        self._reader = asyncio.ensure_future(self._read_responses())
+
+    @classmethod
+    async def start(cls, executable: str, workers: int, server_args) -> "_ServerProcess":
+        if not os.path.isfile(executable):
+            raise FileNotFoundError(f"Translator executable not found at {executable}")
+        if not os.access(executable, os.X_OK):
+            raise PermissionError(f"Translator executable at {executable} is not executable")
+        process = await asyncio.create_subprocess_exec(
+            executable, "--json-rpc", "--framing=content-length", f"--workers={workers}", *server_args,
+            stdin=asyncio.subprocess.PIPE, stdout=asyncio.subprocess.PIPE, stderr=asyncio.subprocess.DEVNULL)
+        return cls(process)
+
+    async def request(self, method: str, params: dict) -> dict:
+        if asyncio.get_running_loop() is not self._loop:
+            raise RuntimeError("A spawned translator can only be used from the event loop it was spawned on.")
+        if self._failure is not None:
+            raise self._failure
+        self._next_id += 1
+        request_id = self._next_id
+        response = asyncio.get_running_loop().create_future()
+        self._pending[request_id] = response
+        data = json.dumps({"jsonrpc": "2.0", "method": method, "params": params, "id": request_id}).encode("utf-8")
+        try:
+            self._process.stdin.write(b"Content-Length: %d\r\n\r\n" % len(data) + data)
+            await self._process.stdin.drain()  # Waits while the pipe is full
+        except (BrokenPipeError, ConnectionResetError) as e:
+            self._pending.pop(request_id, None)
+            raise ConnectionError(f"Translator process is gone: {e}") from e
+        return await response
+
+    async def close(self):
+        """Sends "shutdown", which the server answers after every request before it."""
+        if self._failure is None:
+            try:
+                await self.request("shutdown", {})
+            except ConnectionError:
+                pass
+        if self._process.stdin and not self._process.stdin.is_closing():
+            self._process.stdin.close()
+        try:
+            await asyncio.wait_for(self._process.wait(), timeout=1.0)
+        except asyncio.TimeoutError:
+            self._process.kill()
+            await self._process.wait()
+        self._reader.cancel()
+
+    async def _read_responses(self):
+        stdout = self._process.stdout
+        try:
+            while True:
+                length = None
+                while True:
+                    header = await stdout.readline()
+                    if not header:
+                        raise EOFError
+                    header = header.strip()
+                    if not header:
+                        if length is not None:
+                            break
+                        continue
+                    name, _, value = header.partition(b":")
+                    if name.strip().lower() == b"content-length":
+                        length = int(value)
+                response = json.loads(await stdout.readexactly(length))
+                if response.get("id") is None:
+                    # An error the server could not tie to a request, such as
+                    # one it failed to parse; any pending request may be it.
+                    error = RuntimeError("Translator answered a request it could not identify: "
+                                         f"{response.get('error', {}).get('message', response)}")
+                    for future in self._pending.values():
+                        if not future.done():
+                            future.set_exception(error)
+                    self._pending.clear()
+                    continue
+                future = self._pending.pop(response.get("id"), None)
+                if future is not None and not future.done():
+                    future.set_result(response)
+        except (EOFError, asyncio.IncompleteReadError, ValueError, OSError) as e:
+            await self._process.wait()
+            self._failure = ConnectionError(
+                f"Translator process stopped answering ({type(e).__name__}). "
+                f"Return code: {self._process.returncode}.")
+            for future in self._pending.values():
+                if not future.done():
+                    future.set_exception(self._failure)
+            self._pending.clear()
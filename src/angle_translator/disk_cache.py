@@ -0,0 +1,125 @@
+# src/angle_translator/disk_cache.py
+
+import hashlib
+import json
+import mmap
+import os
+import tempfile
+import threading
+import time
+
+class TranslationDiskCache:
+    """
+    A directory of translation responses shared by every process pointed at
+    it; pass cache_dir= to ShaderTranslator or ShaderTranslatorPool to use one.
+
+    Entries are named by a hash of the request and live under a subdirectory
+    named for the WASM module, whose hash covers the ANGLE commit it was built
+    from, so a different build never sees them. Reads map the file; writes go
+    to a temporary file that is renamed over the entry, so concurrent
+    processes only ever see whole entries. Reading refreshes an entry's
+    modification time, and once the directory grows past max_bytes the least
+    recently used entries are deleted until it is back under 90% of that.
+
+    The native server's --disk-cache works the same way but keys entries
+    differently, so the two do not share entries.
+    """
+    FORMAT_VERSION = 1  # Bump when the responses change shape
+    DEFAULT_MAX_BYTES = 1024 * 1024 * 1024
+
+    def __init__(self, directory: str, module_id: str, max_bytes: int = None):
+        self.root = os.path.join(directory, f"py-v{self.FORMAT_VERSION}-{module_id}")
+        self.max_bytes = self.DEFAULT_MAX_BYTES if max_bytes is None else max_bytes
+        os.makedirs(self.root, exist_ok=True)
+        self._lock = threading.Lock()
+        self._bytes = self._scan()[0]
+
+    @staticmethod
+    def key(method: str, params: dict) -> str:
+        text = json.dumps([method, params], sort_keys=True, separators=(",", ":"))
+        return hashlib.sha256(text.encode("utf-8")).hexdigest()[:32]
+
+    def get(self, key: str):
+        """Returns the cached response for key, or None."""
+        path = self._path(key)
+        try:
+            with open(path, "rb") as f:
+                with mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as data:
+                    response = json.loads(data[:])
+            os.utime(path)  # Mark as recently used for eviction
+            return response
+        except FileNotFoundError:
+            return None
+        except (OSError, ValueError):
+            try:
+                os.remove(path)  # Empty or damaged on disk
+            except OSError:
+                pass
+            return None
+
+    def put(self, key: str, response: dict):
+        data = json.dumps(response, separators=(",", ":")).encode("utf-8")
+        if len(data) > self.max_bytes:
+            return
+        path = self._path(key)
+        tmp_path = None
+        try:
+            os.makedirs(os.path.dirname(path), exist_ok=True)
+            fd, tmp_path = tempfile.mkstemp(dir=os.path.dirname(path), suffix=".tmp")
+            with os.fdopen(fd, "wb") as f:
+                f.write(data)
+            os.replace(tmp_path, path)
+            tmp_path = None
+        except OSError:
+            return  # The cache is an optimization; a full disk is fine
+        finally:
+            if tmp_path:
+                try:
+                    os.remove(tmp_path)
+                except OSError:
+                    pass
+        with self._lock:
+            self._bytes += len(data)
+            over = self._bytes > self.max_bytes
+        if over:
+            self._evict()
+
+    def _path(self, key: str) -> str:
+        return os.path.join(self.root, key[:2], key + ".json")
+
+    def _scan(self) -> tuple:
+        """Returns (bytes in entries, [(mtime, size, path), ...]), removing stale temporary files."""
+        total, files = 0, []
+        stale = time.time() - 600
+        for dirpath, _, names in os.walk(self.root):
+            for name in names:
+                path = os.path.join(dirpath, name)
+                try:
+                    st = os.stat(path)
+                    if not name.endswith(".json"):
+                        if st.st_mtime < stale:
+                            os.remove(path)  # Left behind by a crashed writer
+                        continue
+                except OSError:
+                    continue  # Removed by another process meanwhile
+                total += st.st_size
+                files.append((st.st_mtime, st.st_size, path))
+        return total, files
+
+    def _evict(self):
+        if not self._lock.acquire(blocking=False):
+            return  # Another thread is already evicting
+        try:
+            total, files = self._scan()
+            low_water = self.max_bytes // 10 * 9
+            for _, size, path in sorted(files):
+                if total <= low_water:
+                    break
+                try:
+                    os.remove(path)
+                except OSError:
+                    pass  # Gone either way, if another process beat us to it
+                total -= size
+            self._bytes = total
+        finally:
+            self._lock.release()
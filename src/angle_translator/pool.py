@@ -0,0 +1,146 @@
+# src/angle_translator/pool.py
+
+import os
+import queue
+import threading
+from concurrent.futures import Future
+
+from .translator import ShaderTranslator, _native, _shared_module
+
+class ShaderTranslatorPool:
+    """
+    Translates shaders concurrently on a fixed set of ShaderTranslator instances.
+
+    The WASM module is compiled (or loaded from the precompiled module cache)
+    once and shared; each worker thread instantiates its own Store/Instance
+    from it and only ever touches that instance, since wasmtime stores are not
+    thread-safe. wasmtime's bindings
+    call into native code through ctypes, which releases the GIL for the
+    duration of a call, so workers translate in parallel on separate cores.
+
+    Use it as a context manager or call close() to stop the workers.
+    """
+    def __init__(self, size: int = None, recycle_after_requests: int = None, recycle_above_bytes: int = None,
+                 timeout_ms: int = None, cache_dir: str = None, cache_max_bytes: int = None,
+                 backend: str = "wasm"):
+        """
+        Args:
+            size (int, optional): Number of translator instances. Defaults to
+                                  os.cpu_count().
+            recycle_after_requests, recycle_above_bytes (int, optional):
+                                  Recycle policy for every instance; see
+                                  ShaderTranslator.
+            timeout_ms (int, optional): Default time budget of every
+                                  translation. An instance whose call runs
+                                  over is replaced with a fresh one from the
+                                  shared module; see ShaderTranslator.translate_shader.
+            cache_dir, cache_max_bytes (optional): A disk cache every
+                                  instance shares; see ShaderTranslator.
+            backend (str, optional): "wasm" or "native"; see ShaderTranslator.
+
+        Raises:
+            Exception: Whatever the first worker raised while instantiating
+                       its translator; the pool is closed in that case.
+        """
+        self.size = size or os.cpu_count() or 1
+        self._tasks = queue.SimpleQueue()
+        self._closed = False
+        self._translator_options = {"recycle_after_requests": recycle_after_requests,
+                                    "recycle_above_bytes": recycle_above_bytes,
+                                    "timeout_ms": timeout_ms,
+                                    "cache_dir": cache_dir,
+                                    "cache_max_bytes": cache_max_bytes,
+                                    "backend": backend}
+
+        if backend != "native" or _native is None:
+            # Loaded once up front; the translators then find it shared, and
+            # can move to the interruptible one for per-call time budgets.
+            _shared_module(epoch_interruption=timeout_ms is not None)
+
+        started = [Future() for _ in range(self.size)]
+        self._threads = [
+            threading.Thread(target=self._worker, args=(ready,),
+                             name=f"ShaderTranslatorPool-{i}", daemon=True)
+            for i, ready in enumerate(started)]
+        for thread in self._threads:
+            thread.start()
+        try:
+            for ready in started:
+                ready.result()
+        except BaseException:
+            self.close()
+            raise
+
+    def submit(self, shader_code: str, shader_type: str, **kwargs) -> Future:
+        """
+        Schedules one translation on the next free instance.
+
+        Takes the same arguments as ShaderTranslator.translate_shader and
+        returns a concurrent.futures.Future resolving to its response dict.
+        """
+        return self._submit("translate_shader", (shader_code, shader_type), kwargs)
+
+    def map(self, shaders, **kwargs) -> list:
+        """
+        Schedules one translation per item, spread over all instances.
+
+        Args:
+            shaders (iterable): (shader_code, shader_type) tuples or dicts with
+                                'shader_code' and 'shader_type' keys.
+            **kwargs: Options passed to translate_shader for every item.
+
+        Returns:
+            list: One Future per item, in input order.
+        """
+        futures = []
+        for shader in shaders:
+            if isinstance(shader, dict):
+                shader_code, shader_type = shader["shader_code"], shader["shader_type"]
+            else:
+                shader_code, shader_type = shader
+            futures.append(self.submit(shader_code, shader_type, **kwargs))
+        return futures
+
+    def close(self):
+        """Finishes the queued translations, then closes every instance."""
+        if self._closed:
+            return
+        self._closed = True
+        for _ in self._threads:
+            self._tasks.put(None)
+        for thread in self._threads:
+            thread.join()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        self.close()
+
+    def _submit(self, method: str, args: tuple, kwargs: dict) -> Future:
+        if self._closed:
+            raise RuntimeError("Pool has been closed and cannot be used.")
+        future = Future()
+        self._tasks.put((future, method, args, kwargs))
+        return future
+
+    def _worker(self, ready: Future):
+        try:
+            translator = ShaderTranslator(**self._translator_options)
+        except BaseException as e:
+            ready.set_exception(e)
+            return
+        ready.set_result(None)
+
+        with translator:
+            while True:
+                task = self._tasks.get()
+                if task is None:
+                    break
+                future, method, args, kwargs = task
+                if not future.set_running_or_notify_cancel():
+                    continue
+                try:
+                    future.set_result(getattr(translator, method)(*args, **kwargs))
+                except BaseException as e:
+                    future.set_exception(e)
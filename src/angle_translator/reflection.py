@@ -0,0 +1,201 @@
+# src/angle_translator/reflection.py
+
+import struct
+from collections.abc import Sequence
+
+_HEADER = struct.Struct("<4sHH8I")
+_LIST = struct.Struct("<II")
+_VARIABLE = struct.Struct("<IIIIHHiiiIHHI")
+_BLOCK = struct.Struct("<IIIIHHiIII")
+_U32 = struct.Struct("<I")
+_OMITTED_LIST = 0xFFFFFFFF
+
+_ACTIVE, _STATIC_USE, _ROW_MAJOR = 1, 2, 4
+_LAYOUTS = ("unknown", "shared", "packed", "std140", "std430")
+
+class ActiveVariables:
+    """
+    A shader's active variables in the binary reflection format, returned in
+    place of the active_variables dict for reflection_format="binary".
+
+    Nothing is decoded up front: each list is a sequence over the blob's
+    fixed-width records, and a record's strings are decoded only when read.
+    The lists are the attributes of the same names as the JSON keys
+    (uniforms, attributes, uniform_blocks, ...); uniforms.find("u_color")
+    looks one up by name. A list the reflect mask left out is empty and not
+    `in` the object. to_dict() gives the same dict the JSON format would.
+    The layout is described in reflection_blob.hpp.
+    """
+    MAGIC = b"ANRF"
+    VERSION = 1
+    LISTS = ("attributes", "generic_interface_blocks", "input_varyings", "output_variables",
+             "output_varyings", "shader_storage_buffer_blocks", "uniform_blocks", "uniforms")
+    BLOCK_LISTS = frozenset(("generic_interface_blocks", "shader_storage_buffer_blocks", "uniform_blocks"))
+
+    def __init__(self, data):
+        """
+        Args:
+            data (bytes-like): The blob. It is referenced, not copied.
+
+        Raises:
+            ValueError: If data is not a blob of this version.
+        """
+        self._data = memoryview(data).cast("B")
+        if len(self._data) < _HEADER.size:
+            raise ValueError("Reflection blob is truncated.")
+        magic, version, header_size, *sections = _HEADER.unpack_from(self._data)
+        if magic != self.MAGIC or version != self.VERSION:
+            raise ValueError(f"Not a version {self.VERSION} reflection blob.")
+        (_, self._variables, _, self._blocks, _, self._array_sizes, _, self._strings) = sections
+        self._lists = {}
+        for i, name in enumerate(self.LISTS):
+            first, count = _LIST.unpack_from(self._data, _HEADER.size + i * _LIST.size)
+            if first != _OMITTED_LIST:
+                self._lists[name] = (first, count)
+
+    def __getitem__(self, name: str) -> "RecordList":
+        if name not in self.LISTS:
+            raise KeyError(name)
+        first, count = self._lists.get(name, (0, 0))
+        return RecordList(self, BlockRecord if name in self.BLOCK_LISTS else VariableRecord, first, count)
+
+    def __contains__(self, name: str) -> bool:
+        return name in self._lists
+
+    def to_dict(self) -> dict:
+        return {name: [record.to_dict() for record in self[name]] for name in self.LISTS if name in self._lists}
+
+    def _string(self, offset: int) -> str:
+        start = self._strings + offset + 4
+        return str(self._data[start:start + _U32.unpack_from(self._data, start - 4)[0]], "utf-8")
+
+for _name in ActiveVariables.LISTS:
+    setattr(ActiveVariables, _name, property(lambda self, name=_name: self[name]))
+
+
+class RecordList(Sequence):
+    """Consecutive variable or block records of an ActiveVariables blob."""
+    __slots__ = ("_owner", "_record", "_first", "_count")
+
+    def __init__(self, owner: ActiveVariables, record, first: int, count: int):
+        self._owner, self._record, self._first, self._count = owner, record, first, count
+
+    def __len__(self):
+        return self._count
+
+    def __getitem__(self, index):
+        if isinstance(index, slice):
+            return [self[i] for i in range(*index.indices(self._count))]
+        if index < 0:
+            index += self._count
+        if not 0 <= index < self._count:
+            raise IndexError("record index out of range")
+        return self._record(self._owner, self._first + index)
+
+    def find(self, name: str):
+        """Returns the record named name, or None."""
+        for record in self:
+            if record.name == name:
+                return record
+        return None
+
+    def __repr__(self):
+        return f"<RecordList of {self._count} {self._record.__name__}>"
+
+
+class VariableRecord:
+    """One sh::ShaderVariable. location, binding and offset are -1 when absent, as in ANGLE."""
+    __slots__ = ("_owner", "_fields")
+
+    def __init__(self, owner: ActiveVariables, index: int):
+        self._owner = owner
+        self._fields = _VARIABLE.unpack_from(owner._data, owner._variables + index * _VARIABLE.size)
+
+    name = property(lambda self: self._owner._string(self._fields[0]))
+    mapped_name = property(lambda self: self._owner._string(self._fields[1]))
+    struct_or_block_name = property(lambda self: self._owner._string(self._fields[2]))
+    type_enum = property(lambda self: self._fields[3])
+    precision_enum = property(lambda self: self._fields[4])
+    active = property(lambda self: bool(self._fields[5] & _ACTIVE))
+    static_use = property(lambda self: bool(self._fields[5] & _STATIC_USE))
+    is_row_major = property(lambda self: bool(self._fields[5] & _ROW_MAJOR))
+    location = property(lambda self: self._fields[6])
+    binding = property(lambda self: self._fields[7])
+    offset = property(lambda self: self._fields[8])
+
+    @property
+    def array_sizes(self) -> tuple:
+        first, count = self._fields[9], self._fields[10]
+        start = self._owner._array_sizes + first * 4
+        return struct.unpack_from(f"<{count}I", self._owner._data, start) if count else ()
+
+    @property
+    def fields(self) -> RecordList:
+        return RecordList(self._owner, VariableRecord, self._fields[12], self._fields[11])
+
+    def to_dict(self) -> dict:
+        entry = {"active": self.active}
+        if self._fields[10]:
+            entry["array_sizes"] = list(self.array_sizes)
+        if self.binding != -1:
+            entry["binding"] = self.binding
+        if self._fields[11]:
+            entry["fields"] = [field.to_dict() for field in self.fields]
+        entry["is_row_major"] = self.is_row_major
+        if self.location != -1:
+            entry["location"] = self.location
+        entry["mapped_name"] = self.mapped_name
+        entry["name"] = self.name
+        if self.offset != -1:
+            entry["offset"] = self.offset
+        entry["precision_enum"] = self.precision_enum
+        entry["static_use"] = self.static_use
+        if self.struct_or_block_name:
+            entry["struct_or_block_name"] = self.struct_or_block_name
+        entry["type_enum"] = self.type_enum
+        return entry
+
+    def __repr__(self):
+        return f"<VariableRecord {self.name!r} type_enum={self.type_enum:#x} location={self.location}>"
+
+
+class BlockRecord:
+    """One sh::InterfaceBlock. binding is -1 when absent, as in ANGLE."""
+    __slots__ = ("_owner", "_fields")
+
+    def __init__(self, owner: ActiveVariables, index: int):
+        self._owner = owner
+        self._fields = _BLOCK.unpack_from(owner._data, owner._blocks + index * _BLOCK.size)
+
+    name = property(lambda self: self._owner._string(self._fields[0]))
+    mapped_name = property(lambda self: self._owner._string(self._fields[1]))
+    instance_name = property(lambda self: self._owner._string(self._fields[2]))
+    layout = property(lambda self: _LAYOUTS[self._fields[3]] if self._fields[3] < len(_LAYOUTS) else "unknown")
+    active = property(lambda self: bool(self._fields[4] & _ACTIVE))
+    static_use = property(lambda self: bool(self._fields[4] & _STATIC_USE))
+    is_row_major_layout = property(lambda self: bool(self._fields[4] & _ROW_MAJOR))
+    binding = property(lambda self: self._fields[6])
+    array_size = property(lambda self: self._fields[7])
+
+    @property
+    def fields(self) -> RecordList:
+        return RecordList(self._owner, VariableRecord, self._fields[9], self._fields[8])
+
+    def to_dict(self) -> dict:
+        entry = {"active": self.active}
+        if self.array_size > 0:
+            entry["array_size"] = self.array_size
+        if self.binding != -1:
+            entry["binding"] = self.binding
+        entry["fields"] = [field.to_dict() for field in self.fields]
+        if self.instance_name:
+            entry["instance_name"] = self.instance_name
+        entry["is_row_major_layout"] = self.is_row_major_layout
+        entry["layout"] = self.layout
+        entry["mapped_name"] = self.mapped_name
+        entry["name"] = self.name
+        entry["static_use"] = self.static_use
+        return entry
+
+    def __repr__(self):
+        return f"<BlockRecord {self.name!r} layout={self.layout} fields={self._fields[8]}>"
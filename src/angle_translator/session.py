@@ -0,0 +1,112 @@
+# src/angle_translator/session.py
+
+class TranslationSession:
+    """
+    A shader that is edited in place and re-translated after each edit, as in
+    a live shader editor. Create one with ShaderTranslator.open_session().
+
+    The module keeps a compiler and the last result for the session. An edit
+    that only touches comments or whitespace is answered with that result
+    without compiling (the response's result then has 'reused': True).
+
+    Results carry 'revision', the number of the source they were compiled
+    from; every update() bumps it. A session belongs to its translator and,
+    like it, must only be used from one thread at a time.
+    """
+    def __init__(self, translator, open_params: dict):
+        self._translator = translator
+        self._open_params = open_params
+        self.source = ""
+        self.revision = 0
+        self._session_id = None
+        self._needs_full_source = False
+        self._reopens = 0
+        self._open()
+
+    def _open(self):
+        response = self._translator._send_request("open_session", self._open_params)
+        if "error" in response:
+            raise ValueError(f"open_session failed: {response['error']}")
+        self._session_id = response["result"]["session_id"]
+
+    def _reopen(self):
+        """Called by ShaderTranslator.recycle(): the new instance has no sessions."""
+        self._open()
+        self._needs_full_source = True
+        self._reopens += 1
+
+    @property
+    def closed(self) -> bool:
+        return self._session_id is None
+
+    def update(self, shader_code: str = None, edits=None) -> dict:
+        """
+        Replaces or edits the source and translates it.
+
+        Args:
+            shader_code (str, optional): The new source in full.
+            edits (iterable, optional): Instead of shader_code, (start, end, text)
+                                        tuples replacing source[start:end] with
+                                        text, applied in order, so each one's
+                                        offsets refer to the source as left by
+                                        the previous one.
+
+        Returns:
+            dict: The response, shaped like that of translate_shader, with
+                  'revision', 'latest_revision' and 'reused' added to the
+                  result (or to the error's 'data' if compilation failed).
+                  The translator's timeout_ms applies.
+
+        Raises:
+            RuntimeError: If the session has been closed.
+            ValueError: If both or neither of shader_code and edits are given.
+        """
+        if self.closed:
+            raise RuntimeError("Session has been closed and cannot be used.")
+        if (shader_code is None) == (edits is None):
+            raise ValueError("Specify exactly one of shader_code and edits.")
+
+        params = {"session_id": self._session_id, "revision": self.revision + 1}
+        if shader_code is not None:
+            source = shader_code
+            params["shader_code"] = shader_code
+        else:
+            # The module counts offsets in UTF-8 bytes; convert as the edits apply.
+            source = self.source
+            wire_edits = []
+            for start, end, text in edits:
+                if not 0 <= start <= end <= len(source):
+                    raise ValueError(f"Edit range [{start}, {end}) is outside the source.")
+                byte_start = len(source[:start].encode("utf-8"))
+                byte_end = byte_start + len(source[start:end].encode("utf-8"))
+                wire_edits.append({"start": byte_start, "end": byte_end, "text": text})
+                source = source[:start] + text + source[end:]
+            if self._needs_full_source:
+                params["shader_code"] = source
+            else:
+                params["edits"] = wire_edits
+
+        reopens = self._reopens
+        response = self._translator._send_request("update_session", params, self._translator.timeout_ms)
+        if "error" not in response or response["error"].get("code") != -32602:
+            # Anything but rejected params means the module took the new source
+            self.source = source
+            self.revision += 1
+            if self._reopens == reopens:  # Else the request recycled the instance
+                self._needs_full_source = False
+        return response
+
+    def close(self):
+        """Releases the session's compiler in the module. Safe to call twice."""
+        if self.closed:
+            return
+        if not self._translator._closed:
+            self._translator._send_request("close_session", {"session_id": self._session_id})
+            self._translator._sessions.discard(self)
+        self._session_id = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        self.close()
@@ -2,36 +2,376 @@
 
 import json
 import base64
-from wasmtime import Store, Module, Instance, Linker, Trap, Config, Engine, WasiConfig
+import hashlib
+import os
+import platform
+import tempfile
+import threading
+import time
+import weakref
+from wasmtime import Store, Module, Instance, Linker, Trap, TrapCode, Config, Engine, WasiConfig
+
+from .disk_cache import TranslationDiskCache
+from .reflection import ActiveVariables
+from .session import TranslationSession
+
+try:
+    from . import _native  # Optional in-process build; see ShaderTranslator(backend="native")
+except ImportError:
+    _native = None
 
 try:
     from importlib.resources import files, as_file
 except ImportError:
     from importlib_resources import files, as_file
 
+def _make_engine(epoch_interruption: bool = False) -> Engine:
+    config = Config()
+    config.wasm_exceptions = True
+    if epoch_interruption:
+        # Lets timeout_ms interrupt a runaway compile; costs a counter check at
+        # function entries and loop back-edges, so only engines for
+        # translators with a time budget have it.
+        config.epoch_interruption = True
+    engine = Engine(config)
+    if epoch_interruption:
+        _interruptible_engines.add(engine)
+    return engine
+
+# Engines made by _make_engine(epoch_interruption=True)
+_interruptible_engines = weakref.WeakSet()
+
+# Names the engine configuration in module cache file names. Change it when
+# _make_engine() changes in a way that affects compiled code.
+def _engine_config_tag(engine: Engine) -> str:
+    return "wasm_exceptions,epoch_interruption" if engine in _interruptible_engines else "wasm_exceptions"
+
+# Error code of requests that ran out of time, as in the native server
+TIMEOUT_ERROR_CODE = -32001
+# Error code of requests for an output the module was built without
+BACKEND_UNAVAILABLE_ERROR_CODE = -32002
+
+# Epoch ticks are shared by every store on an engine, so a background thread
+# per engine advances the epoch at a fixed period and each request sets its
+# deadline as a number of ticks. Timeouts are thus rounded up to the tick.
+# The thread only runs while a call with a deadline is in progress on the
+# engine, and holds no reference to it.
+_EPOCH_TICK_MS = 5
+_NO_DEADLINE_TICKS = 1 << 62
+
+class _EpochTicker:
+    _lock = threading.Lock()
+    _tickers = weakref.WeakKeyDictionary()  # Engine -> _EpochTicker
+
+    def __init__(self, engine: Engine):
+        self._engine = weakref.ref(engine)
+        self._timed_calls = 0
+        self._running = False
+
+    @classmethod
+    def begin(cls, engine: Engine) -> "_EpochTicker":
+        """Counts a call with a deadline as started, starting the thread if needed."""
+        with cls._lock:
+            ticker = cls._tickers.get(engine)
+            if ticker is None:
+                ticker = cls._tickers[engine] = cls(engine)
+            ticker._timed_calls += 1
+            if not ticker._running:
+                ticker._running = True
+                threading.Thread(target=ticker._tick, name="angle-translator-epoch", daemon=True).start()
+            return ticker
+
+    def end(self):
+        with self._lock:
+            self._timed_calls -= 1
+
+    def _tick(self):
+        while True:
+            time.sleep(_EPOCH_TICK_MS / 1000)
+            with self._lock:
+                engine = self._engine()
+                if engine is None or not self._timed_calls:
+                    self._running = False
+                    return
+            engine.increment_epoch()
+            del engine
+
+class _DeadlineExceeded(Exception):
+    pass
+
+# The bundled module variants and the outputs each adds; see CMakeLists.txt.
+# "standalone" translates to ESSL and GLSL and is the one loaded up front.
+_DEFAULT_VARIANT = "standalone"
+_VARIANT_OUTPUT_PREFIXES = {"spirv": "spirv", "hlsl": "hlsl"}
+
+def _variant_wasm(variant: str):
+    return files('angle_translator').joinpath('wasm', f'angle_shader_translator_{variant}.wasm')
+
+def _read_wasm_bytes(variant: str = _DEFAULT_VARIANT) -> bytes:
+    with as_file(_variant_wasm(variant)) as wasm_path:
+        return wasm_path.read_bytes()
+
+def output_variant(output: str) -> str:
+    """
+    Returns the name of the bundled module variant that translates to output:
+    "spirv", "hlsl", or "standalone" for ESSL and GLSL. Outputs whose variant
+    was not installed map to "standalone", which answers them with an error
+    with code BACKEND_UNAVAILABLE_ERROR_CODE.
+    """
+    for variant, prefix in _VARIANT_OUTPUT_PREFIXES.items():
+        if output.startswith(prefix) and _variant_wasm(variant).is_file():
+            return variant
+    return _DEFAULT_VARIANT
+
+_bundled_module_id = None
+
+def _bundled_wasm_id() -> str:
+    """A short hash of the bundled WASM module, naming the build in cache directories."""
+    global _bundled_module_id
+    if _bundled_module_id is None:
+        _bundled_module_id = hashlib.sha256(_read_wasm_bytes()).hexdigest()[:16]
+    return _bundled_module_id
+
+def _wasmtime_version() -> str:
+    try:
+        from importlib.metadata import version
+        return version("wasmtime")
+    except Exception:
+        return "unknown"
+
+def default_module_cache_dir():
+    """
+    Returns the directory precompiled modules are cached in, or None if caching
+    is disabled, which it is unless ANGLE_TRANSLATOR_CACHE_DIR names a
+    directory. The cache holds executable code, so nothing is written there,
+    or anywhere else, without that opt-in or an explicit cache_dir.
+    """
+    return os.environ.get("ANGLE_TRANSLATOR_CACHE_DIR") or None
+
+def _module_cache_name(engine: Engine, wasm_bytes: bytes) -> str:
+    # wasmtime also validates the version and CPU features of an artifact when
+    # deserializing it; keying on them keeps machines sharing a cache directory
+    # from overwriting each other's artifacts.
+    wasm_hash = hashlib.sha256(wasm_bytes).hexdigest()
+    host = "|".join((_wasmtime_version(), platform.system(), platform.machine(),
+                     platform.processor(), _engine_config_tag(engine)))
+    host_hash = hashlib.sha256(host.encode('utf-8')).hexdigest()
+    return f"{wasm_hash[:16]}-{host_hash[:16]}.cwasm"
+
+def load_module(engine: Engine = None, cache_dir: str = None, variant: str = _DEFAULT_VARIANT,
+                epoch_interruption: bool = False) -> tuple:
+    """
+    Compiles the bundled translator WASM module, or loads a copy that was
+    precompiled for this wasmtime version, host and WASM build on an earlier run.
+
+    JIT-compiling the translator takes seconds; deserializing a cached artifact
+    takes milliseconds. Nothing is cached unless cache_dir is given or
+    ANGLE_TRANSLATOR_CACHE_DIR is set; if the directory cannot be written, the
+    module is compiled as without one. Artifacts are written atomically, so
+    concurrent processes can share a cache directory. Only point cache_dir at
+    a directory you trust: wasmtime executes deserialized code as-is.
+
+    Args:
+        engine (Engine, optional): The engine to compile for. A new one is
+                                   created if omitted.
+        cache_dir (str, optional): Where to cache precompiled artifacts.
+                                   Defaults to default_module_cache_dir(),
+                                   which is None (no cache) unless
+                                   ANGLE_TRANSLATOR_CACHE_DIR is set.
+        variant (str, optional): Which bundled module to load; see
+                                 output_variant(). Defaults to "standalone".
+        epoch_interruption (bool, optional): Whether a new engine lets
+                                 timeout_ms interrupt calls. Ignored if engine
+                                 is given.
+
+    Returns:
+        tuple: (engine, module), ready to pass to ShaderTranslator(engine, module).
+    """
+    if engine is None:
+        engine = _make_engine(epoch_interruption)
+    wasm_bytes = _read_wasm_bytes(variant)
+    if cache_dir is None:
+        cache_dir = default_module_cache_dir()
+    if not cache_dir:
+        return engine, Module(engine, wasm_bytes)
+
+    cache_path = os.path.join(cache_dir, _module_cache_name(engine, wasm_bytes))
+    if os.path.exists(cache_path):
+        try:
+            return engine, Module.deserialize_file(engine, cache_path)
+        except Exception:
+            pass  # Incompatible or truncated artifact; recompile and replace it
+
+    module = Module(engine, wasm_bytes)
+    tmp_path = None
+    try:
+        os.makedirs(cache_dir, exist_ok=True)
+        fd, tmp_path = tempfile.mkstemp(dir=cache_dir, suffix=".tmp")
+        with os.fdopen(fd, "wb") as f:
+            f.write(module.serialize())
+        os.replace(tmp_path, cache_path)
+        tmp_path = None
+    except OSError:
+        pass  # The cache is an optimization; a read-only home directory is fine
+    finally:
+        if tmp_path:
+            try:
+                os.remove(tmp_path)
+            except OSError:
+                pass
+    return engine, module
+
+# Profile ids of profiles registered on a backend() start here; a module
+# hands out at most 1024 (see ProfileRegistry in shader_translator.cpp).
+_ROUTED_PROFILE_BASE = 1 << 16
+
+_shared_lock = threading.Lock()
+_shared_engines = {}  # epoch_interruption -> Engine
+_shared_modules = {}  # (variant, epoch_interruption) -> Module, compiled for that engine
+
+def _shared_module(variant: str = _DEFAULT_VARIANT, epoch_interruption: bool = False) -> tuple:
+    """
+    The process-wide (engine, module) pair used by translators created
+    without one; there is one engine with epoch interruption, for translators
+    with a time budget, and one without.
+    """
+    with _shared_lock:
+        key = (variant, epoch_interruption)
+        if key not in _shared_modules:
+            engine, _shared_modules[key] = load_module(_shared_engines.get(epoch_interruption), variant=variant,
+                                                       epoch_interruption=epoch_interruption)
+            _shared_engines[epoch_interruption] = engine
+        return _shared_engines[epoch_interruption], _shared_modules[key]
+
+def _with_reflection(response: dict) -> dict:
+    """
+    Replaces a binary-format result's 'active_variables_base64' with an
+    ActiveVariables accessor as 'active_variables', leaving the response the
+    caches hold untouched.
+    """
+    result = response.get("result")
+    if not isinstance(result, dict) or "active_variables_base64" not in result:
+        return response
+    result = dict(result)
+    result["active_variables"] = ActiveVariables(base64.b64decode(result.pop("active_variables_base64")))
+    response = dict(response)
+    response["result"] = result
+    return response
+
 class ShaderTranslator:
     """
     A Python wrapper for the ANGLE shader translator WASM module.
     This class provides both a context manager and an explicit .close() method
     for guaranteed, safe resource cleanup.
+
+    A translator owns one wasmtime Store and must only be used from one thread
+    at a time; see ShaderTranslatorPool for concurrent translation. The
+    compiled Module is shared: by default every translator in the process
+    uses one Engine/Module pair, loaded through load_module(), or a second
+    one with epoch interruption if it has a time budget.
+
+    The SPIR-V and HLSL backends are separate module variants, so the common
+    ESSL/GLSL path does not pay for loading them. The first request for one
+    of their outputs creates a translator on that variant, which serves those
+    outputs from then on; backend() returns it, e.g. for its stats().
+
+    With backend="native" the translator instead calls the angle_translator._native
+    extension, if it was built (see wasm_build.md): the same core running
+    in-process, without WASM or JSON-RPC marshaling around translations.
+    Translations release the GIL, so threads sharing one native translator
+    run in parallel. All native translators in a process share its caches,
+    profiles and stats(), and outputs depend on which backends the extension
+    was built with.
     """
-    def __init__(self):
+    def __init__(self, engine: Engine = None, module: Module = None,
+                 recycle_after_requests: int = None, recycle_above_bytes: int = None,
+                 timeout_ms: int = None, cache_dir: str = None, cache_max_bytes: int = None,
+                 backend: str = "wasm"):
+        """
+        Args:
+            engine (Engine, optional): The wasmtime Engine to run on. Defaults
+                                       to the process-wide shared engine.
+            module (Module, optional): An already compiled translator Module,
+                                       which must belong to engine, e.g. from
+                                       load_module(). Compiled for engine if omitted.
+            recycle_after_requests (int, optional): Replace the WASM instance
+                                       with a fresh one after this many requests.
+            recycle_above_bytes (int, optional): Replace the WASM instance once
+                                       its linear memory reaches this many bytes.
+            timeout_ms (int, optional): Default time budget of translate_shader
+                                       and translate_batch calls; see translate_shader.
+                                       Setting it, even to 0 for no default
+                                       budget, puts the translator on an engine
+                                       with epoch interruption.
+            cache_dir (str, optional): Directory of a TranslationDiskCache that
+                                       translate_shader, translate_batch and
+                                       translate_program responses are kept in,
+                                       so other translators and later processes
+                                       pointed at it skip compiling. Responses
+                                       with profile=True and timeouts are not kept.
+            cache_max_bytes (int, optional): Size the cache directory is held
+                                       under. Defaults to 1 GiB.
+            backend (str, optional): "wasm" (the default) or "native". "native"
+                                       falls back to WASM when the extension is
+                                       not installed; backend_name reports which
+                                       one is in use. The native backend ignores
+                                       engine, module, the recycle options and
+                                       time budgets.
+
+        WASM linear memory never shrinks, so recycling is the only way to hand
+        memory back from a long-lived translator. A fresh instance starts with
+        empty compiler and result caches and zeroed stats().
+        """
         self._closed = False  # Add a flag to track cleanup state
-        
-        config = Config()
-        config.wasm_exceptions = True
-        self.store = Store(Engine(config))
 
-        # ... (The rest of __init__ is the same)
+        if backend not in ("wasm", "native"):
+            raise ValueError(f"Unknown backend {backend!r}; expected 'wasm' or 'native'.")
+        self._native = _native if backend == "native" else None
+        self.backend_name = "native" if self._native is not None else "wasm"
+        if module is not None and engine is None:
+            raise ValueError("A precompiled module requires the engine it was compiled with.")
+        self._shared = engine is None
+        if self._native is not None:
+            module = None
+        elif engine is None:
+            engine, module = _shared_module(epoch_interruption=timeout_ms is not None)
+        elif module is None:
+            engine, module = load_module(engine)
+        self.module = module
+        self.recycle_after_requests = recycle_after_requests
+        self.recycle_above_bytes = recycle_above_bytes
+        self.timeout_ms = timeout_ms
+        self.recycles = 0
+        self._recycling = False
+        self._profiles = {}  # profile_id -> register_profile params, replayed by recycle()
+        self._sessions = weakref.WeakSet()  # Open TranslationSessions, reopened by recycle()
+        if cache_dir:
+            module_id = f"native-{self._native.angle_commit}" if self._native is not None else _bundled_wasm_id()
+            self._disk_cache = TranslationDiskCache(cache_dir, module_id, cache_max_bytes)
+        else:
+            self._disk_cache = None
+        self._variant = _DEFAULT_VARIANT
+        self._backend_options = {"recycle_after_requests": recycle_after_requests,
+                                 "recycle_above_bytes": recycle_above_bytes, "timeout_ms": timeout_ms,
+                                 "cache_dir": cache_dir, "cache_max_bytes": cache_max_bytes}
+        self._backends = {}  # variant -> ShaderTranslator, created by backend()
+        self._routed_profiles = {}  # profile_id -> (backend, its profile_id there)
+        self._native_profile_ids = {}  # JSON of inline options -> profile_id, for the native backend
+        if self._native is None:
+            self._instantiate(engine)
+
+    def _instantiate(self, engine: Engine):
+        """Creates a Store and Instance of self.module and initializes ANGLE in it."""
+        self.store = Store(engine)
+        self.store.set_epoch_deadline(_NO_DEADLINE_TICKS)  # Under epoch interruption the default is 0
+        self._requests_since_instantiate = 0
+
         wasi_config = WasiConfig()
         wasi_config.argv = []
         wasi_config.env = []
         self.store.set_wasi(wasi_config)
         linker = Linker(self.store.engine)
         linker.define_wasi()
-        wasm_file_traversable = files('angle_translator').joinpath('wasm', 'angle_shader_translator_standalone.wasm')
-        with as_file(wasm_file_traversable) as wasm_path:
-            self.module = Module(self.store.engine, wasm_path.read_bytes())
         self.instance = linker.instantiate(self.store, self.module)
         self.exports = self.instance.exports(self.store)
         self.memory = self.exports["memory"]
@@ -41,6 +381,30 @@ class ShaderTranslator:
         self._initialize = self.exports["initialize"]
         self._finalize = self.exports["finalize"]
 
+        # Length-delimited ABI: requests need no NUL terminator and the response
+        # length is written to a 4-byte slot we own, so exactly that many bytes
+        # are read back. Older modules only export invoke().
+        self._invoke_ex = self._optional_export("invoke_ex")
+
+        # Module-owned request buffer that persists across calls, so a request
+        # costs no malloc()/free() round trip. Older modules lack it.
+        self._get_input_buffer = self._optional_export("get_input_buffer")
+
+        # Typed result API: translate() returns a status code and the get_*
+        # exports expose the output in place, skipping JSON on both sides.
+        typed_exports = [self._optional_export(name) for name in (
+            "translate", "get_object_code", "get_info_log", "get_object_binary", "get_error_message")]
+        self._typed_api = all(typed_exports)
+        if self._typed_api:
+            (self._translate, self._get_object_code, self._get_info_log,
+             self._get_object_binary, self._get_error_message) = typed_exports
+
+        self._out_len_ptr = 0
+        if self._invoke_ex or self._typed_api:
+            self._out_len_ptr = self._malloc(self.store, 4)
+            if not self._out_len_ptr:
+                raise MemoryError("WASM malloc failed to allocate memory.")
+
         if not self._initialize(self.store):
              raise RuntimeError("CRITICAL: The ANGLE library failed to initialize.")
 
@@ -50,6 +414,9 @@ class ShaderTranslator:
             to ensure a clean shutdown.
             """
             if not self._closed:
+                for backend in getattr(self, '_backends', {}).values():
+                    backend.close()
+
                 # Finalize the C++ ANGLE library first
                 if hasattr(self, '_finalize') and self._finalize:
                     self._finalize(self.store)
@@ -82,7 +449,7 @@ class ShaderTranslator:
         self.close()
 
     # All other methods (translate_shader, etc.) are unchanged.
-    def translate_shader(self, shader_code: str, shader_type: str, spec: str = "webgl", output: str = "essl", print_vars: bool = True, enable_name_hashing: bool = False) -> dict:
+    def translate_shader(self, shader_code: str, shader_type: str, spec: str = "webgl", output: str = "essl", print_vars: bool = True, enable_name_hashing: bool = False, optimize: int = 0, profile: bool = False, profile_id: int = None, timeout_ms: int = None, reflection_format: str = "json", reflect: list = None, keep_reflection: bool = False) -> dict:
         """
         Translates shader code using the ANGLE shader translator WASM module.
 
@@ -107,12 +474,14 @@ class ShaderTranslator:
                                     Defaults to "essl" (GLSL ES). Other options:
                                     - "essl" (GLSL ES)
                                     - "glsl" or "glsl[NUM]" (e.g., "glsl330" for GLSL 3.30 Core)
-                                    - "spirv" (Vulkan SPIR-V not implemented yet)
-                                    - "hlsl9", "hlsl11" (HLSL for DirectX 9 or 11 not implemented yet)
+                                    - "spirv" (Vulkan SPIR-V, from the "spirv" module variant)
+                                    - "hlsl9", "hlsl11" (HLSL for DirectX 9 or 11, from the "hlsl" variant)
                                     - "msl" (Metal Shading Language not implemented yet)
             print_vars (bool, optional): If True, the response will include a detailed
                                          `active_variables` dictionary showing attributes,
                                          uniforms, varyings, and output variables. Defaults to True.
+                                         When False, the output is read directly from WASM
+                                         memory without a JSON response being built.
             enable_name_hashing (bool, optional): Controls whether ANGLE's internal name hashing
                                                   mechanism is active. Defaults to False.
                                                   - If `True`: ANGLE will generate unique names
@@ -122,6 +491,46 @@ class ShaderTranslator:
                                                   - If `False`: ANGLE's default behavior for
                                                     name mangling which often includes 
                                                     prefixing names with '_u' (e.g., `myUniform -> _umyUniform`).
+            optimize (int, optional): Optimization level, 0 (the default) or 1. Level 1
+                                      removes declarations of variables the shader never
+                                      uses.
+            profile (bool, optional): If True, the result (or the error's 'data') also
+                                      contains a 'timings' dictionary: microseconds spent
+                                      decoding, parsing parameters, constructing the compiler,
+                                      compiling, fetching object code, serializing active
+                                      variables and dumping JSON, plus 'process_memory_kb'
+                                      (WASM linear memory size) and 'compile_memory_growth_kb'.
+                                      With optimize, 'optimize_passes' lists each pass with
+                                      the object code size after it and its 'bytes_delta'.
+            profile_id (int, optional): A handle from register_profile(). Its options
+                                        replace spec, output, print_vars and
+                                        enable_name_hashing, which are then ignored.
+            timeout_ms (int, optional): Time budget for the call, defaulting to the
+                                        translator's timeout_ms. A call that runs over
+                                        is interrupted and returns an error with code
+                                        TIMEOUT_ERROR_CODE; the WASM instance is then
+                                        replaced as by recycle(). Needs an engine with
+                                        epoch interruption: a translator on the shared
+                                        engine without it moves to the one with it on
+                                        its first budgeted call, starting over with
+                                        empty caches, and a translator on an engine
+                                        of its own raises ValueError unless the engine
+                                        came from load_module(epoch_interruption=True).
+            reflection_format (str, optional): "json" (the default) or "binary". With
+                                        "binary", 'active_variables' is an ActiveVariables
+                                        accessor over a compact blob instead of nested
+                                        dicts, which is much cheaper to build and to read
+                                        location tables from.
+            reflect (list, optional): Names of the active_variables lists to return,
+                                        e.g. ["uniforms", "attributes"]; a list
+                                        implies print_vars. Defaults to every list but
+                                        'generic_interface_blocks', which repeats the
+                                        uniform and shader storage blocks.
+            keep_reflection (bool, optional): If True, the module keeps every list
+                                        and the result has a 'reflection_handle' for
+                                        get_reflection(), so lists can be fetched
+                                        only when needed. Responses holding a handle
+                                        bypass the disk cache.
 
         Returns:
             dict: A dictionary containing the translation result.
@@ -142,50 +551,646 @@ class ShaderTranslator:
         """
         if self._closed:
             raise RuntimeError("Translator has been closed and cannot be used.")
-        shader_code_b64 = base64.b64encode(shader_code.encode('utf-8')).decode('utf-8')
+        target, profile_id = self._route(output, profile_id)
+        if target is not self:
+            return target.translate_shader(shader_code, shader_type, spec, output, print_vars, enable_name_hashing,
+                                           optimize, profile, profile_id, timeout_ms, reflection_format, reflect,
+                                           keep_reflection)
+        if profile_id is not None:
+            params = {"shader_code": shader_code, "shader_type": shader_type, "profile_id": profile_id}
+            registered = self._profiles.get(profile_id)
+            print_vars = registered["print_active_variables"] if registered else True
+            output = registered["output"] if registered else output
+        else:
+            params = self._options_params(spec, output, print_vars, enable_name_hashing, optimize, reflection_format,
+                                          reflect)
+            params["shader_code"] = shader_code
+            params["shader_type"] = shader_type
+        if keep_reflection:
+            params["keep_reflection"] = True
+        if timeout_ms is None:
+            timeout_ms = self.timeout_ms
+        if profile:
+            params["profile"] = True
+        elif self._native is not None:
+            return _with_reflection(self._cached("translate", params, lambda: self._translate_native(params)))
+        elif not print_vars and not keep_reflection and self._typed_api:
+            return self._cached("translate", params, lambda: self._translate_typed(params, output, timeout_ms))
+        return _with_reflection(self._cached("translate", params, lambda: self._send_request("translate", params, timeout_ms)))
+
+    def get_reflection(self, handle: int, kind=None, reflection_format: str = "json", output: str = "essl") -> dict:
+        """
+        Fetches active variable lists kept by translate_shader(keep_reflection=True).
+
+        Args:
+            handle (int): The result's 'reflection_handle'. The module keeps
+                          the most recent few hundred; older handles, and any
+                          from before a recycle(), have expired.
+            kind (str or list, optional): The list name(s) to fetch, as for
+                          translate_shader's reflect. Defaults to every list.
+            reflection_format (str, optional): As for translate_shader.
+            output (str, optional): The output the handle's translation used,
+                          which decides the module variant holding it.
 
+        Returns:
+            dict: The response. Its result has 'active_variables' with just
+                  the lists asked for. An expired handle gives an error with
+                  code -32602.
+        """
+        target = self.backend(output)
+        if target is not self:
+            return target.get_reflection(handle, kind, reflection_format)
+        params = {"handle": handle}
+        if kind is not None:
+            params["kind"] = kind if isinstance(kind, str) else list(kind)
+        if reflection_format != "json":
+            params["reflection_format"] = reflection_format
+        return _with_reflection(self._send_request("get_reflection", params))
+
+    def preprocess(self, shader_code: str, shader_type: str, spec: str = "webgl", profile_id: int = None) -> dict:
+        """
+        Runs only ANGLE's preprocessor, which is much cheaper than translating.
+
+        Sources that differ only in comments, whitespace or how macros spell
+        their tokens preprocess to the same token stream, so its hash makes a
+        canonical key for caching translations outside the module, combined
+        with the options they are translated with. The module's own result
+        cache already matches sources this way.
+
+        Args:
+            shader_code, shader_type, spec, profile_id: As for translate_shader.
+
+        Returns:
+            dict: The response. Its result has 'tokens' (the token stream,
+                  with #version, #extension and #pragma directives on lines of
+                  their own), 'hash' (16 hex digits), 'token_count' and
+                  'info_log'. A source that fails to preprocess gives an error
+                  with code 2 and the 'info_log' in its 'data'.
+        """
+        params = {"profile_id": profile_id} if profile_id is not None else {"spec": spec}
+        params["shader_code"] = shader_code
+        params["shader_type"] = shader_type
+        return self._send_request("preprocess", params)
+
+    def register_profile(self, spec: str = "webgl", output: str = "essl", print_vars: bool = True, enable_name_hashing: bool = False, optimize: int = 0, reflection_format: str = "json", reflect: list = None) -> int:
+        """
+        Validates a set of translation options once and returns a small integer
+        handle for them. Passing profile_id= to translate_shader or
+        translate_batch then skips option parsing in the module and lets it
+        find the cached compiler by id. Registering identical options again
+        returns the same handle. Handles belong to this translator and
+        survive recycle().
+
+        Args:
+            spec, output, print_vars, enable_name_hashing, optimize, reflection_format, reflect:
+                As for translate_shader.
+
+        Returns:
+            int: The profile id.
+
+        Raises:
+            ValueError: If the options are invalid.
+        """
+        target = self.backend(output)
+        if target is not self:
+            backend_id = target.register_profile(spec, output, print_vars, enable_name_hashing, optimize, reflection_format,
+                                                 reflect)
+            for profile_id, routed in self._routed_profiles.items():
+                if routed == (target, backend_id):
+                    return profile_id
+            # Above any id a module hands out, so routed ids never collide with ours
+            profile_id = _ROUTED_PROFILE_BASE + len(self._routed_profiles)
+            self._routed_profiles[profile_id] = (target, backend_id)
+            return profile_id
+        params = self._options_params(spec, output, print_vars, enable_name_hashing, optimize, reflection_format,
+                                      reflect)
+        response = self._send_request("register_profile", params)
+        if "error" in response:
+            raise ValueError(f"register_profile failed: {response['error']}")
+        profile_id = response["result"]["profile_id"]
+        self._profiles[profile_id] = params
+        return profile_id
+
+    def open_session(self, shader_type: str, spec: str = "webgl", output: str = "essl", print_vars: bool = True, enable_name_hashing: bool = False, optimize: int = 0, profile_id: int = None) -> TranslationSession:
+        """
+        Opens a live-editing session: a shader whose source is sent as edits
+        and re-translated after each one, reusing the session's own compiler
+        and skipping compilation when only comments or whitespace changed.
+
+        Args:
+            shader_type (str): As for translate_shader.
+            spec, output, print_vars, enable_name_hashing, optimize, profile_id:
+                As for translate_shader, fixed for the life of the session.
+
+        Returns:
+            TranslationSession: Call update() with each new revision of the
+                                source and close() when done. Usable as a
+                                context manager.
+
+        Raises:
+            ValueError: If the options are invalid.
+        """
+        target, profile_id = self._route(output, profile_id)
+        if target is not self:
+            return target.open_session(shader_type, spec, output, print_vars, enable_name_hashing, optimize, profile_id)
+        if profile_id is not None:
+            params = {"profile_id": profile_id}
+        else:
+            params = self._options_params(spec, output, print_vars, enable_name_hashing, optimize)
+        params["shader_type"] = shader_type
+        session = TranslationSession(self, params)
+        self._sessions.add(session)
+        return session
+
+    @staticmethod
+    def _options_params(spec: str, output: str, print_vars: bool, enable_name_hashing: bool, optimize: int = 0,
+                        reflection_format: str = "json", reflect: list = None) -> dict:
         # Build the resources dictionary
         resources_params = {}
         # Add other resources as needed
         resources_params["EnableNameHashing"] = enable_name_hashing
 
-        request_payload = {
-            "jsonrpc": "2.0", "id": 1, "method": "translate",
-            "params": {
-                "shader_code_base64": shader_code_b64, 
-                "shader_type": shader_type,
-                "spec": spec, 
-                "output": output, 
-                "print_active_variables": print_vars,
-                "compile_options": {"objectCode": True},
-                "resources": resources_params,
-            }
+        params = {
+            "spec": spec,
+            "output": output,
+            "print_active_variables": print_vars,
+            "compile_options": {"object_code": True},
+            "resources": resources_params,
         }
-        request_str = json.dumps(request_payload)
+        if optimize:
+            params["optimize"] = optimize
+        if reflection_format != "json":
+            params["reflection_format"] = reflection_format
+        if reflect is not None:
+            params["reflect"] = list(reflect)
+        return params
+
+    def translate_batch(self, shaders, spec: str = "webgl", output: str = "essl", print_vars: bool = True, enable_name_hashing: bool = False, optimize: int = 0, profile_id: int = None, timeout_ms: int = None, reflection_format: str = "json", reflect: list = None) -> list:
+        """
+        Translates many shaders with a single call into the WASM module.
+
+        All shaders share one set of spec/output/resources options, which the
+        module parses once, and compilers are reused between items. This is
+        much cheaper than calling translate_shader in a loop for small shaders.
+
+        Args:
+            shaders (iterable): Items to translate. Each item is either a
+                                (shader_code, shader_type) tuple or a dict with
+                                'shader_code' and 'shader_type' keys.
+            spec, output, print_vars, enable_name_hashing, optimize, profile_id, reflection_format, reflect:
+                                As for translate_shader, applied to every item.
+            timeout_ms (int, optional): As for translate_shader, for the whole
+                                batch. If it runs out, every item reports
+                                the timeout error.
+
+        Returns:
+            list: One dictionary per input item, in order. Each has either a
+                  'result' key or an 'error' key, shaped exactly like the
+                  response of translate_shader.
+
+        Raises:
+            RuntimeError: If the translator has been closed.
+            ValueError: If the batch request as a whole was rejected.
+        """
+        target, profile_id = self._route(output, profile_id)
+        if target is not self:
+            return target.translate_batch(shaders, spec, output, print_vars, enable_name_hashing, optimize,
+                                          profile_id, timeout_ms, reflection_format, reflect)
+        items = []
+        for shader in shaders:
+            if isinstance(shader, dict):
+                shader_code, shader_type = shader["shader_code"], shader["shader_type"]
+            else:
+                shader_code, shader_type = shader
+            items.append({"shader_code": shader_code, "shader_type": shader_type})
+
+        if profile_id is not None:
+            params = {"profile_id": profile_id}
+        else:
+            params = self._options_params(spec, output, print_vars, enable_name_hashing, optimize, reflection_format,
+                                          reflect)
+        params["items"] = items
+        if timeout_ms is None:
+            timeout_ms = self.timeout_ms
+        response = self._cached("translate_many", params, lambda: self._send_request("translate_many", params, timeout_ms))
+        if "error" in response and response["error"]["code"] == TIMEOUT_ERROR_CODE:
+            return [{"error": response["error"]} for _ in items]
+        if "error" in response:
+            raise ValueError(f"translate_many failed: {response['error']}")
+        return [_with_reflection(item) for item in response["result"]["results"]]
+
+    def translate_program(self, vertex_code: str, fragment_code: str, spec: str = "webgl", output: str = "essl", print_vars: bool = True, enable_name_hashing: bool = False, optimize: int = 0, profile_id: int = None, prune_varyings: bool = True, timeout_ms: int = None) -> dict:
+        """
+        Translates a vertex and a fragment shader that are linked together.
+
+        The fragment shader is compiled first. Vertex outputs it does not read
+        are then turned into private globals before the vertex shader is
+        compiled, so they drop out of the stage interface and the driver can
+        discard the code computing them.
+
+        Args:
+            vertex_code (str): The vertex shader source.
+            fragment_code (str): The fragment shader source.
+            spec, output, print_vars, enable_name_hashing, optimize, profile_id, timeout_ms:
+                As for translate_shader, applied to both stages.
+            prune_varyings (bool, optional): Set to False to translate the
+                                             vertex shader unchanged. Defaults to True.
+
+        Returns:
+            dict: The response. Its result has 'vertex' and 'fragment', each
+                  shaped like the result of translate_shader, plus
+                  'linked_varyings' (vertex outputs the fragment shader reads)
+                  and 'pruned_varyings' (those removed). If a stage fails to
+                  compile, the error's 'data' has 'stage' naming it.
+        """
+        target, profile_id = self._route(output, profile_id)
+        if target is not self:
+            return target.translate_program(vertex_code, fragment_code, spec, output, print_vars, enable_name_hashing,
+                                            optimize, profile_id, prune_varyings, timeout_ms)
+        if profile_id is not None:
+            params = {"profile_id": profile_id}
+        else:
+            params = self._options_params(spec, output, print_vars, enable_name_hashing, optimize)
+        params["vertex"] = {"shader_code": vertex_code}
+        params["fragment"] = {"shader_code": fragment_code}
+        params["prune_varyings"] = prune_varyings
+        if timeout_ms is None:
+            timeout_ms = self.timeout_ms
+        return self._cached("translate_program", params, lambda: self._send_request("translate_program", params, timeout_ms))
+
+    def flush_compilers(self) -> int:
+        """
+        Destroys the ANGLE compilers cached inside the WASM module.
+
+        Compilers are kept alive between translate calls so the built-in symbol
+        table is only built once per (shader type, spec, output, resources)
+        combination. Flushing releases that memory; the next translation simply
+        rebuilds what it needs.
+
+        Every thread's compilers are released, not only those of the thread
+        that handles the request: the native server's idle workers flush when
+        it arrives, busy ones after their current request, and threads of the
+        native backend before their next translation. Sessions release theirs
+        too, or once a compile in progress is done.
+
+        Returns:
+            int: The number of compilers that were released, or are about to be.
+        """
+        response = self._send_request("flush_compilers")
+        return response["result"]["flushed"]
+
+    def cache_stats(self) -> dict:
+        """
+        Returns hit/miss counters and memory usage for the caches inside the WASM module.
+
+        Returns:
+            dict: {"result_cache": {...}, "compiler_cache": {...}}. The result
+                  cache reports 'entries', 'bytes', 'max_bytes', 'hits', 'misses'
+                  and 'evictions'; the compiler cache reports 'entries',
+                  'hits' and 'misses' summed over every thread's cache (each
+                  native server worker has one), 'caches' (how many of those
+                  are in use) and the 'capacity' of each.
+        """
+        return self._send_request("cache_stats")["result"]
+
+    def cache_clear(self, max_bytes: int = None) -> int:
+        """
+        Drops every cached translation result.
+
+        Args:
+            max_bytes (int, optional): If given, also sets the result cache
+                                       budget in bytes. 0 disables the cache.
+
+        Returns:
+            int: The number of entries that were removed.
+        """
+        params = {} if max_bytes is None else {"max_bytes": max_bytes}
+        return self._send_request("cache_clear", params)["result"]["cleared"]
+
+    def compact(self, result_cache: bool = False) -> dict:
+        """
+        Releases memory the module retains between requests: every cached
+        compiler (whose pool keeps the pages of its largest compile) and,
+        optionally, the result cache. Freed memory is reused by later requests,
+        but linear memory itself cannot shrink; see recycle() for that.
+
+        Args:
+            result_cache (bool, optional): Also drop every cached translation.
+
+        Returns:
+            dict: 'compilers_released', 'results_released', 'process_kb_before'
+                  and 'memory' ({'process_kb', 'high_water_kb',
+                  'largest_request_growth_kb'}).
+        """
+        return self._send_request("compact", {"result_cache": result_cache})["result"]
+
+    def stats(self, format: str = "json"):
+        """
+        Returns aggregate metrics collected since the module was instantiated.
+
+        Args:
+            format (str, optional): "json" (default) for a dictionary, or
+                                    "prometheus" for the Prometheus text
+                                    exposition format.
+
+        Returns:
+            dict or str: For "json", a dictionary with 'uptime_seconds',
+                         'requests' (counts by method and by spec/output),
+                         'errors' (counts by error code), 'latency_us'
+                         (per-method histograms with p50/p95/p99),
+                         'result_cache', 'compiler_cache' (both with
+                         'hit_rate') and 'memory'. For "prometheus", a str.
+
+        Raises:
+            ValueError: If format is not recognized.
+        """
+        response = self._send_request("stats", {"format": format})
+        if "error" in response:
+            raise ValueError(f"stats failed: {response['error']}")
+        return response["result"]["text"] if format == "prometheus" else response["result"]
+
+    def _send_request(self, method: str, params: dict = None, timeout_ms: int = None) -> dict:
+        if self._closed:
+            raise RuntimeError("Translator has been closed and cannot be used.")
+        request_payload = {"jsonrpc": "2.0", "id": 1, "method": method}
+        if params is not None:
+            request_payload["params"] = params
+        request_bytes = json.dumps(request_payload).encode('utf-8')
+        if self._native is not None:
+            return json.loads(self._native.invoke(request_bytes))
+        self._make_interruptible(timeout_ms)
         request_ptr = 0
         try:
-            request_ptr = self._write_string_to_memory(request_str)
-            result_ptr = self._invoke(self.store, request_ptr)
-            if not result_ptr:
-                raise RuntimeError("WASM invoke function returned a null pointer.")
-            response_str = self._read_string_from_memory(result_ptr)
+            if self._invoke_ex:
+                input_ptr, request_ptr = self._write_input(request_bytes)
+                result_ptr = self._call_export(timeout_ms, self._invoke_ex, input_ptr, len(request_bytes), self._out_len_ptr)
+                if not result_ptr:
+                    raise RuntimeError("WASM invoke_ex function returned a null pointer.")
+                result_len = int.from_bytes(self.memory.read(self.store, self._out_len_ptr, self._out_len_ptr + 4), "little")
+                response_bytes = self.memory.read(self.store, result_ptr, result_ptr + result_len)
+            else:
+                request_ptr = self._write_bytes_to_memory(request_bytes + b'\0')
+                result_ptr = self._call_export(timeout_ms, self._invoke, request_ptr)
+                if not result_ptr:
+                    raise RuntimeError("WASM invoke function returned a null pointer.")
+                response_bytes = self._read_cstring_from_memory(result_ptr)
+        except _DeadlineExceeded:
+            request_ptr = 0  # Belongs to the discarded instance
+            return self._timed_out(timeout_ms)
         finally:
             if request_ptr:
                 self._free(self.store, request_ptr)
-        return json.loads(response_str)
+        response = json.loads(response_bytes)
+        self._after_request()
+        return response
+
+    def backend(self, output: str) -> "ShaderTranslator":
+        """
+        Returns the translator that handles output: this one for ESSL and
+        GLSL, or one on the output's module variant (see output_variant()),
+        created the first time it is asked for with this translator's options.
+        """
+        if self._closed:
+            raise RuntimeError("Translator has been closed and cannot be used.")
+        variant = output_variant(output)
+        if self._native is not None or self._variant != _DEFAULT_VARIANT or variant == _DEFAULT_VARIANT:
+            return self
+        backend = self._backends.get(variant)
+        if backend is None:
+            if self._shared:
+                engine, module = _shared_module(variant, self.store.engine in _interruptible_engines)
+            else:
+                engine, module = load_module(self.store.engine, variant=variant)
+            backend = ShaderTranslator(engine, module, **self._backend_options)
+            backend._variant = variant
+            self._backends[variant] = backend
+        return backend
+
+    def _route(self, output: str, profile_id: int) -> tuple:
+        """Returns the translator a request goes to, and the request's profile_id there."""
+        if profile_id is not None:
+            return self._routed_profiles.get(profile_id, (self, profile_id))
+        return self.backend(output), None
+
+    def _cached(self, method: str, params: dict, send) -> dict:
+        """
+        Returns the disk cache's response to a request if it has one, and
+        otherwise calls send() and keeps what it returns.
+        """
+        cache = self._disk_cache
+        if cache is None or params.get("profile") or params.get("keep_reflection"):
+            return send()
+        key_params = params
+        if "profile_id" in params:
+            # Ids are per instance; key on the options they stand for
+            registered = self._profiles.get(params["profile_id"])
+            if registered is None:
+                return send()
+            key_params = {k: v for k, v in params.items() if k != "profile_id"}
+            key_params.update(registered)
+        key = cache.key(method, key_params)
+        response = cache.get(key)
+        if response is None:
+            response = send()
+            if response.get("error", {}).get("code") != TIMEOUT_ERROR_CODE:
+                cache.put(key, response)
+        return response
+
+    def _translate_native(self, params: dict) -> dict:
+        """
+        translate_shader on the native backend: passes the source as is and a
+        profile id for the options, and builds the response from the output.
+        """
+        profile_id = params.get("profile_id")
+        if profile_id is None:
+            options = {k: v for k, v in params.items() if k not in ("shader_code", "shader_type")}
+            options_key = json.dumps(options, sort_keys=True)
+            profile_id = self._native_profile_ids.get(options_key)
+            if profile_id is None:
+                response = self._send_request("register_profile", options)
+                if "error" in response:
+                    return {"jsonrpc": "2.0", "id": 1, "error": response["error"]}
+                profile_id = self._native_profile_ids[options_key] = response["result"]["profile_id"]
+        try:
+            status, object_code, info_log, message, extra = self._native.translate(
+                params["shader_code"], params["shader_type"], profile_id)
+        except ValueError as exc:
+            return {"jsonrpc": "2.0", "id": 1, "error": {"code": -32602, "message": str(exc)}}
+        if status != 0:
+            error = {"code": status, "message": message}
+            if extra:
+                error["data"] = json.loads(extra)
+            return {"jsonrpc": "2.0", "id": 1, "error": error}
+        result = {"info_log": info_log}
+        if isinstance(object_code, bytes):
+            result["object_code_base64"] = base64.b64encode(object_code).decode('ascii')
+        else:
+            result["object_code"] = object_code
+        if extra:
+            result.update(json.loads(extra))
+        return {"jsonrpc": "2.0", "id": 1, "result": result}
+
+    def _translate_typed(self, params: dict, output: str, timeout_ms: int = None) -> dict:
+        """
+        Fast path for translate_shader when no active variables are wanted:
+        calls the typed translate() export and reads the output straight from
+        WASM memory. Returns the same response shape as the JSON-RPC path.
+        """
+        if self._closed:
+            raise RuntimeError("Translator has been closed and cannot be used.")
+        self._make_interruptible(timeout_ms)
+        params_bytes = json.dumps(params).encode('utf-8')
+        input_ptr, params_ptr = self._write_input(params_bytes)
+        try:
+            status = self._call_export(timeout_ms, self._translate, input_ptr, len(params_bytes))
+        except _DeadlineExceeded:
+            params_ptr = 0  # Belongs to the discarded instance
+            return self._timed_out(timeout_ms)
+        finally:
+            if params_ptr:
+                self._free(self.store, params_ptr)
+
+        info_log = self._read_view(self._get_info_log).decode('utf-8')
+        if status != 0:
+            error = {"code": status, "message": self._read_view(self._get_error_message).decode('utf-8')}
+            if info_log:
+                error["data"] = {"info_log": info_log}
+            response = {"jsonrpc": "2.0", "id": 1, "error": error}
+        else:
+            result = {"info_log": info_log}
+            if output == "spirv":
+                result["object_code_base64"] = base64.b64encode(self._read_view(self._get_object_binary)).decode('ascii')
+            else:
+                result["object_code"] = self._read_view(self._get_object_code).decode('utf-8')
+            response = {"jsonrpc": "2.0", "id": 1, "result": result}
+        self._after_request()
+        return response
+
+    def _call_export(self, timeout_ms, export, *args):
+        """
+        Calls a WASM export, interrupting it once timeout_ms has passed (no
+        limit if None or 0). Raises _DeadlineExceeded if it was interrupted.
+        """
+        if not timeout_ms:
+            return export(self.store, *args)
+        ticker = _EpochTicker.begin(self.store.engine)
+        # One tick more, since the current tick is already partly over
+        self.store.set_epoch_deadline(-(-timeout_ms // _EPOCH_TICK_MS) + 1)
+        try:
+            return export(self.store, *args)
+        except Trap as trap:
+            if trap.trap_code != TrapCode.INTERRUPT:
+                raise
+            raise _DeadlineExceeded() from trap
+        finally:
+            ticker.end()
+            if not self._closed:
+                self.store.set_epoch_deadline(_NO_DEADLINE_TICKS)
+
+    def _make_interruptible(self, timeout_ms):
+        """
+        Before a call with timeout_ms, moves a translator on the shared engine
+        without epoch interruption to the shared engine with it. Call before
+        anything is written to the instance's memory.
+        """
+        if not timeout_ms or self.store.engine in _interruptible_engines:
+            return
+        if not self._shared:
+            raise ValueError("timeout_ms needs an engine with epoch interruption; "
+                             "load one with load_module(epoch_interruption=True).")
+        engine, self.module = _shared_module(self._variant, epoch_interruption=True)
+        self._replace_instance(engine)
+
+    def _timed_out(self, timeout_ms: int) -> dict:
+        """
+        Handles an interrupted request: the instance stopped at an arbitrary
+        point, so it is replaced (see recycle()) before the error is returned.
+        """
+        self.recycle()
+        error = {"code": TIMEOUT_ERROR_CODE, "message": f"Request exceeded its time budget of {timeout_ms} ms."}
+        return {"jsonrpc": "2.0", "id": 1, "error": error}
+
+    def _after_request(self):
+        """Applies the recycle policy once a request's output has been copied out."""
+        if self._recycling or self._native is not None:
+            return
+        self._requests_since_instantiate += 1
+        if ((self.recycle_after_requests and self._requests_since_instantiate >= self.recycle_after_requests) or
+                (self.recycle_above_bytes and self.memory.data_len(self.store) >= self.recycle_above_bytes)):
+            self.recycle()
+
+    def recycle(self):
+        """
+        Replaces the WASM instance with a fresh one, returning all of its linear
+        memory. The compiled module is reused, so this costs one instantiation.
+        """
+        if self._closed:
+            raise RuntimeError("Translator has been closed and cannot be used.")
+        if self._native is not None:
+            return  # The native backend's memory is the process heap; see compact()
+        self._replace_instance(self.store.engine)
+        self.recycles += 1
+
+    def _replace_instance(self, engine: Engine):
+        """Finalizes the instance and instantiates self.module on engine in its place."""
+        self._finalize(self.store)
+        del self.instance
+        del self.store
+        self._instantiate(engine)
+
+        # The new instance starts with an empty profile registry, which hands
+        # out ids in registration order; replaying keeps every handle valid.
+        # Sessions are reopened and send their full source on the next update.
+        self._recycling = True
+        try:
+            for profile_id, params in sorted(self._profiles.items()):
+                response = self._send_request("register_profile", params)
+                if response.get("result", {}).get("profile_id") != profile_id:
+                    raise RuntimeError(f"Could not re-register profile {profile_id} after recycling: {response}")
+            for session in list(self._sessions):
+                session._reopen()
+        finally:
+            self._recycling = False
+
+    def _read_view(self, accessor) -> bytes:
+        """Calls a get_* accessor export and copies out exactly the bytes it points at."""
+        ptr = accessor(self.store, self._out_len_ptr)
+        length = int.from_bytes(self.memory.read(self.store, self._out_len_ptr, self._out_len_ptr + 4), "little")
+        if not length:
+            return b""
+        return bytes(self.memory.read(self.store, ptr, ptr + length))
+
+    def _optional_export(self, name: str):
+        try:
+            return self.exports[name]
+        except KeyError:
+            return None
+
+    def _write_input(self, data: bytes) -> tuple:
+        """
+        Copies a request into WASM memory, preferring the module's persistent
+        input buffer. Returns (ptr, ptr_to_free), where ptr_to_free is 0 unless
+        the bytes had to be malloc'd.
+        """
+        if self._get_input_buffer:
+            ptr = self._get_input_buffer(self.store, len(data))
+            if not ptr:
+                raise MemoryError("WASM get_input_buffer failed to allocate memory.")
+            self.memory.write(self.store, data, ptr)
+            return ptr, 0
+        ptr = self._write_bytes_to_memory(data)
+        return ptr, ptr
 
-    def _write_string_to_memory(self, s: str) -> int:
-        s_bytes = s.encode('utf-8')
-        ptr = self._malloc(self.store, len(s_bytes) + 1)
+    def _write_bytes_to_memory(self, data: bytes) -> int:
+        ptr = self._malloc(self.store, max(len(data), 1))
         if not ptr:
             raise MemoryError("WASM malloc failed to allocate memory.")
-        self.memory.write(self.store, s_bytes, ptr)
-        self.memory.write(self.store, b'\0', ptr + len(s_bytes))
+        self.memory.write(self.store, data, ptr)
         return ptr
 
-    def _read_string_from_memory(self, ptr: int) -> str:
-        mem_data = self.memory.read(self.store, ptr, self.memory.data_len(self.store) - ptr)
+    def _read_cstring_from_memory(self, ptr: int) -> bytes:
+        mem_data = self.memory.read(self.store, ptr, self.memory.data_len(self.store))
         null_term_pos = mem_data.find(b'\0')
         if null_term_pos == -1:
             raise ValueError("String from WASM is not null-terminated")
-        return mem_data[:null_term_pos].decode('utf-8')
\ No newline at end of file
+        return bytes(mem_data[:null_term_pos])
\ No newline at end of file
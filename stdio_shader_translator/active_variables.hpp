@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "GLSLANG/ShaderLang.h"
+#include "result_cache.hpp"
+
+// The lists of a compiler's reflection, in the order of their JSON keys.
+// generic_interface_blocks repeats the uniform and shader storage blocks, so
+// the default "reflect" mask leaves it out.
+enum ActiveVariableList : int {
+    kAttributes,
+    kGenericInterfaceBlocks,
+    kInputVaryings,
+    kOutputVariables,
+    kOutputVaryings,
+    kShaderStorageBufferBlocks,
+    kUniformBlocks,
+    kUniforms,
+    kActiveVariableListCount,
+};
+
+static constexpr const char* kActiveVariableListNames[kActiveVariableListCount] = {
+    "attributes", "generic_interface_blocks", "input_varyings", "output_variables",
+    "output_varyings", "shader_storage_buffer_blocks", "uniform_blocks", "uniforms"};
+
+// Bit i selects list i.
+using ActiveVariableMask = uint8_t;
+static constexpr ActiveVariableMask kAllActiveVariableLists = 0xff;
+static constexpr ActiveVariableMask kDefaultActiveVariableLists =
+    kAllActiveVariableLists & ~(1u << kGenericInterfaceBlocks);
+
+inline bool IsBlockList(int list) {
+    return list == kGenericInterfaceBlocks || list == kShaderStorageBufferBlocks || list == kUniformBlocks;
+}
+
+// Returns the list named name, or -1.
+inline int FindActiveVariableList(const std::string& name) {
+    for (int i = 0; i < kActiveVariableListCount; ++i) {
+        if (name == kActiveVariableListNames[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Views of the lists, either a compiler's or an ActiveVariableSnapshot's.
+// Block lists are in blocks, the others in variables; the rest are null,
+// as is anything the ANGLE API returned null for.
+struct ActiveVariableLists {
+    const std::vector<sh::ShaderVariable>* variables[kActiveVariableListCount] = {};
+    const std::vector<sh::InterfaceBlock>* blocks[kActiveVariableListCount] = {};
+
+    static ActiveVariableLists FromCompiler(ShHandle compiler) {
+        ActiveVariableLists lists;
+        lists.variables[kAttributes] = sh::GetAttributes(compiler);
+        lists.blocks[kGenericInterfaceBlocks] = sh::GetInterfaceBlocks(compiler);
+        lists.variables[kInputVaryings] = sh::GetInputVaryings(compiler);
+        lists.variables[kOutputVariables] = sh::GetOutputVariables(compiler);
+        lists.variables[kOutputVaryings] = sh::GetOutputVaryings(compiler);
+        lists.blocks[kShaderStorageBufferBlocks] = sh::GetShaderStorageBlocks(compiler);
+        lists.blocks[kUniformBlocks] = sh::GetUniformBlocks(compiler);
+        lists.variables[kUniforms] = sh::GetUniforms(compiler);
+        return lists;
+    }
+};
+
+// A copy of a compiler's lists that outlives its next compile.
+struct ActiveVariableSnapshot {
+    std::vector<sh::ShaderVariable> variables[kActiveVariableListCount];
+    std::vector<sh::InterfaceBlock> blocks[kActiveVariableListCount];
+
+    explicit ActiveVariableSnapshot(const ActiveVariableLists& lists) {
+        for (int i = 0; i < kActiveVariableListCount; ++i) {
+            if (lists.variables[i]) {
+                variables[i] = *lists.variables[i];
+            }
+            if (lists.blocks[i]) {
+                blocks[i] = *lists.blocks[i];
+            }
+        }
+    }
+
+    ActiveVariableLists lists() const {
+        ActiveVariableLists lists;
+        for (int i = 0; i < kActiveVariableListCount; ++i) {
+            if (IsBlockList(i)) {
+                lists.blocks[i] = &blocks[i];
+            } else {
+                lists.variables[i] = &variables[i];
+            }
+        }
+        return lists;
+    }
+};
+
+// Snapshots kept for "get_reflection" after a translate request with
+// "keep_reflection": true, under a handle returned with the result. Only the
+// most recent kMaxEntries are kept; older handles expire.
+//
+// Snapshots are also found by the result cache key of the translation they
+// came from, so a result cache hit can hand out the handle of an identical
+// earlier compile instead of compiling again for its reflection.
+//
+// Thread-safe: one instance is shared by every worker of the JSON-RPC server.
+class ReflectionStore {
+public:
+    static constexpr size_t kMaxEntries = 256;
+
+    uint64_t add(const ResultCache::Key& key, const ActiveVariableLists& lists) {
+        auto snapshot = std::make_shared<const ActiveVariableSnapshot>(lists);
+        std::lock_guard<std::mutex> lock(mutex_);
+        const uint64_t handle = ++last_handle_;
+        if (order_.size() == kMaxEntries) {
+            auto oldest = entries_.find(order_.front());
+            if (oldest != entries_.end()) {
+                auto by_key = handles_.find(oldest->second.key);
+                if (by_key != handles_.end() && by_key->second == order_.front()) {
+                    handles_.erase(by_key);
+                }
+                entries_.erase(oldest);
+            }
+            order_.pop_front();
+        }
+        entries_.emplace(handle, Entry{key, std::move(snapshot)});
+        handles_[key] = handle;
+        order_.push_back(handle);
+        return handle;
+    }
+
+    // Returns the snapshot for handle, or null if it expired or never existed.
+    std::shared_ptr<const ActiveVariableSnapshot> find(uint64_t handle) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(handle);
+        return it == entries_.end() ? nullptr : it->second.snapshot;
+    }
+
+    // Returns the handle of the latest snapshot under key, or 0.
+    uint64_t find_key(const ResultCache::Key& key) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = handles_.find(key);
+        return it == handles_.end() ? 0 : it->second;
+    }
+
+private:
+    struct Entry {
+        ResultCache::Key key;
+        std::shared_ptr<const ActiveVariableSnapshot> snapshot;
+    };
+    struct KeyHash {
+        size_t operator()(const ResultCache::Key& key) const {
+            return static_cast<size_t>(key.source_hash ^ (key.params_hash * 31));
+        }
+    };
+
+    mutable std::mutex mutex_;
+    uint64_t last_handle_ = 0;
+    std::unordered_map<uint64_t, Entry> entries_;
+    std::unordered_map<ResultCache::Key, uint64_t, KeyHash> handles_;
+    std::deque<uint64_t> order_;
+};
@@ -1,10 +1,9 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
-#include <vector>
-#include <algorithm>
-#include <cctype>
 #include <string_view>
+#include <vector>
 
 namespace base64 {
 
@@ -13,103 +12,137 @@ static constexpr std::string_view base64_chars =
     "abcdefghijklmnopqrstuvwxyz"
     "0123456789+/";
 
-static inline bool is_base64(unsigned char c) {
-    return (std::isalnum(c) || (c == '+') || (c == '/'));
-}
+namespace detail {
 
-inline std::string base64_encode(const unsigned char* buf, unsigned int bufLen) {
-    std::string ret;
-    int i = 0;
-    unsigned char char_array_3[3];
-    unsigned char char_array_4[4];
-
-    while (bufLen--) {
-        char_array_3[i++] = *(buf++);
-        if (i == 3) {
-            char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-            char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-            char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-            char_array_4[3] = char_array_3[2] & 0x3f;
-
-            for (i = 0; i < 4; ++i)
-                ret += base64_chars[i];
-            i = 0;
-        }
+// Decode table entries: 0-63 for alphabet characters, kPad for '=' and
+// kSkip for everything else (whitespace, line breaks, stray characters).
+// Both markers have the top bits set so one OR over a group detects them.
+static constexpr unsigned char kSkip = 0xFF;
+static constexpr unsigned char kPad = 0xFE;
+
+struct DecodeTable {
+    unsigned char values[256];
+
+    constexpr DecodeTable() : values() {
+        for (int i = 0; i < 256; ++i)
+            values[i] = kSkip;
+        for (size_t i = 0; i < base64_chars.size(); ++i)
+            values[static_cast<unsigned char>(base64_chars[i])] = static_cast<unsigned char>(i);
+        values[static_cast<unsigned char>('=')] = kPad;
     }
+};
+
+static constexpr DecodeTable decode_table{};
 
-    if (i) {
-        for (int j = i; j < 3; ++j)
-            char_array_3[j] = '\0';
+} // namespace detail
+
+static inline bool is_base64(unsigned char c) {
+    return detail::decode_table.values[c] < 64;
+}
 
-        char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-        char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-        char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-        char_array_4[3] = char_array_3[2] & 0x3f;
+inline std::string base64_encode(const unsigned char* buf, size_t bufLen) {
+    std::string ret((bufLen + 2) / 3 * 4, '=');
+    char* out = &ret[0];
 
-        for (int j = 0; j < i + 1; ++j)
-            ret += base64_chars[j];
+    size_t i = 0;
+    for (; i + 3 <= bufLen; i += 3) {
+        const uint32_t n = (uint32_t(buf[i]) << 16) | (uint32_t(buf[i + 1]) << 8) | buf[i + 2];
+        out[0] = base64_chars[n >> 18];
+        out[1] = base64_chars[(n >> 12) & 0x3f];
+        out[2] = base64_chars[(n >> 6) & 0x3f];
+        out[3] = base64_chars[n & 0x3f];
+        out += 4;
+    }
 
-        while (i++ < 3)
-            ret += '=';
+    // The remaining one or two bytes produce two or three characters; the
+    // padding '=' is already in place from the constructor.
+    if (i < bufLen) {
+        uint32_t n = uint32_t(buf[i]) << 16;
+        if (i + 1 < bufLen)
+            n |= uint32_t(buf[i + 1]) << 8;
+        out[0] = base64_chars[n >> 18];
+        out[1] = base64_chars[(n >> 12) & 0x3f];
+        if (i + 1 < bufLen)
+            out[2] = base64_chars[(n >> 6) & 0x3f];
     }
 
     return ret;
 }
 
-inline std::string base64_encode(const std::string& s) {
-    return base64_encode(reinterpret_cast<const unsigned char*>(s.data()), static_cast<unsigned int>(s.size()));
+inline std::string base64_encode(std::string_view s) {
+    return base64_encode(reinterpret_cast<const unsigned char*>(s.data()), s.size());
 }
 
-inline std::vector<unsigned char> decode(const std::string& encoded_string) {
-    std::string str = encoded_string;
-    str.erase(std::remove_if(str.begin(), str.end(), [](char c) {
-        return !is_base64(static_cast<unsigned char>(c)) && c != '=';
-    }), str.end());
+// Decodes encoded into out, replacing its contents. Characters outside the
+// alphabet are skipped and decoding stops at the first '=', matching the
+// lenient behaviour clients have always relied on. Whole 4-character groups
+// are decoded straight out of the lookup table; only groups that contain
+// skipped characters take the byte-at-a-time path.
+inline void decode_into(std::string_view encoded, std::string& out) {
+    const unsigned char* const table = detail::decode_table.values;
+    const unsigned char* src = reinterpret_cast<const unsigned char*>(encoded.data());
+    const unsigned char* const end = src + encoded.size();
+
+    out.resize(encoded.size() / 4 * 3 + 3); // Upper bound; trimmed below
+    char* dst = &out[0];
+
+    uint32_t acc = 0;
+    int pending = 0;
+    while (src < end) {
+        if (pending == 0) {
+            while (end - src >= 4) {
+                const uint32_t a = table[src[0]], b = table[src[1]], c = table[src[2]], d = table[src[3]];
+                if ((a | b | c | d) & 0xC0)
+                    break;
+                const uint32_t n = (a << 18) | (b << 12) | (c << 6) | d;
+                dst[0] = static_cast<char>(n >> 16);
+                dst[1] = static_cast<char>(n >> 8);
+                dst[2] = static_cast<char>(n);
+                dst += 3;
+                src += 4;
+            }
+            if (src == end)
+                break;
+        }
 
-    size_t in_len = str.size();
-    size_t i = 0;
-    size_t in_ = 0;
-    unsigned char char_array_4[4], char_array_3[3];
-    std::vector<unsigned char> ret;
-
-    while (in_len-- && (str[in_] != '=') && is_base64(static_cast<unsigned char>(str[in_]))) {
-        char_array_4[i++] = str[in_];
-        ++in_;
-        if (i == 4) {
-            for (i = 0; i < 4; ++i)
-                char_array_4[i] = static_cast<unsigned char>(base64_chars.find(char_array_4[i]));
-
-            char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-            char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-            char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-
-            for (i = 0; i < 3; ++i)
-                ret.push_back(char_array_3[i]);
-            i = 0;
+        const unsigned char v = table[*src++];
+        if (v == detail::kPad)
+            break;
+        if (v == detail::kSkip)
+            continue;
+        acc = (acc << 6) | v;
+        if (++pending == 4) {
+            dst[0] = static_cast<char>(acc >> 16);
+            dst[1] = static_cast<char>(acc >> 8);
+            dst[2] = static_cast<char>(acc);
+            dst += 3;
+            acc = 0;
+            pending = 0;
         }
     }
 
-    if (i) {
-        for (size_t j = i; j < 4; ++j)
-            char_array_4[j] = 0;
-
-        for (size_t j = 0; j < 4; ++j)
-            char_array_4[j] = static_cast<unsigned char>(base64_chars.find(char_array_4[j]));
-
-        char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-        char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-        char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-
-        for (size_t j = 0; j < i - 1; ++j)
-            ret.push_back(char_array_3[j]);
+    // Two leftover characters carry one byte, three carry two. A single
+    // leftover character is incomplete and is dropped.
+    if (pending >= 2) {
+        acc <<= 6 * (4 - pending);
+        *dst++ = static_cast<char>(acc >> 16);
+        if (pending == 3)
+            *dst++ = static_cast<char>(acc >> 8);
     }
 
-    return ret;
+    out.resize(static_cast<size_t>(dst - out.data()));
+}
+
+inline std::vector<unsigned char> decode(std::string_view encoded_string) {
+    std::string bytes;
+    decode_into(encoded_string, bytes);
+    return std::vector<unsigned char>(bytes.begin(), bytes.end());
 }
 
-inline std::string base64_decode_to_string(const std::string& s) {
-    auto bytes = decode(s);
-    return std::string(bytes.begin(), bytes.end());
+inline std::string base64_decode_to_string(std::string_view s) {
+    std::string ret;
+    decode_into(s, ret);
+    return ret;
 }
 
 } // namespace base64
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <vector>
+
+#include "GLSLANG/ShaderLang.h"
+
+// Keeps ShHandles alive across translate requests so the built-in symbol table
+// is only built once per (shaderType, spec, output, resources) combination.
+// ANGLE compilers reset their per-compile state inside sh::Compile, so a handle
+// can be reused for any number of sources (the CLI mode relies on the same thing).
+//
+// Not thread-safe: each thread that translates should own its own cache.
+// Only the counters may be read from other threads, through GetTotals(), which
+// sums them over every cache in the process.
+class CompilerCache {
+public:
+    static constexpr size_t kDefaultCapacity = 8;
+
+    // Counters of every cache in the process. hits and misses include those
+    // of caches destroyed since, so they only grow.
+    struct Totals {
+        size_t entries = 0;
+        size_t caches = 0; // Live caches that have handed out a compiler
+        unsigned long long hits = 0;
+        unsigned long long misses = 0;
+    };
+
+    explicit CompilerCache(size_t capacity = kDefaultCapacity) : capacity_(capacity ? capacity : 1) {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.caches.push_back(this);
+    }
+    ~CompilerCache() {
+        flush();
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.caches.erase(std::find(registry.caches.begin(), registry.caches.end(), this));
+        registry.retired_hits += hits();
+        registry.retired_misses += misses();
+    }
+
+    CompilerCache(const CompilerCache&) = delete;
+    CompilerCache& operator=(const CompilerCache&) = delete;
+
+    // Returns a compiler for the given configuration, constructing one if needed.
+    // The handle stays owned by the cache; it is valid until the next call that
+    // evicts it (acquire() of capacity() other configurations, or flush()).
+    // Returns nullptr if ANGLE fails to construct the compiler.
+    //
+    // A non-zero profile_id promises that every call passing it also passes the
+    // same spec, output and resources, so such lookups compare the id instead
+    // of hashing and comparing the resources struct.
+    ShHandle acquire(sh::GLenum shaderType, ShShaderSpec spec, ShShaderOutput output,
+                     const ShBuiltInResources& resources, uint32_t profile_id = 0) {
+        if (profile_id) {
+            for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+                if (it->profile_id == profile_id && it->shaderType == shaderType) {
+                    hits_.fetch_add(1, std::memory_order_relaxed);
+                    entries_.splice(entries_.begin(), entries_, it); // Move to MRU position
+                    return entries_.front().handle;
+                }
+            }
+        }
+
+        const khronos_uint64_t resources_hash = hash_resources(resources);
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            if (it->shaderType == shaderType && it->spec == spec && it->output == output &&
+                it->resources_hash == resources_hash &&
+                memcmp(&it->resources, &resources, sizeof(ShBuiltInResources)) == 0) {
+                if (profile_id) {
+                    it->profile_id = profile_id; // Let the next lookup for this profile take the fast path
+                }
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                entries_.splice(entries_.begin(), entries_, it); // Move to MRU position
+                return entries_.front().handle;
+            }
+        }
+
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        ShHandle handle = sh::ConstructCompiler(shaderType, spec, output, &resources);
+        if (!handle) {
+            return nullptr;
+        }
+        while (entries_.size() >= capacity_) {
+            sh::Destruct(entries_.back().handle);
+            entries_.pop_back();
+        }
+        entries_.push_front(Entry{shaderType, spec, output, resources_hash, resources, handle, profile_id});
+        size_.store(entries_.size(), std::memory_order_relaxed);
+        return handle;
+    }
+
+    // Destroys every cached compiler. Returns how many were released.
+    size_t flush() {
+        size_t count = entries_.size();
+        for (auto& entry : entries_) {
+            sh::Destruct(entry.handle);
+        }
+        entries_.clear();
+        size_.store(0, std::memory_order_relaxed);
+        return count;
+    }
+
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+    size_t capacity() const { return capacity_; }
+    unsigned long long hits() const { return hits_.load(std::memory_order_relaxed); }
+    unsigned long long misses() const { return misses_.load(std::memory_order_relaxed); }
+
+    static Totals GetTotals() {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        Totals totals;
+        totals.hits = registry.retired_hits;
+        totals.misses = registry.retired_misses;
+        for (const CompilerCache* cache : registry.caches) {
+            const unsigned long long hits = cache->hits(), misses = cache->misses();
+            totals.entries += cache->size();
+            totals.caches += hits + misses ? 1 : 0;
+            totals.hits += hits;
+            totals.misses += misses;
+        }
+        return totals;
+    }
+
+    // FNV-1a over the raw struct. sh::InitBuiltInResources memsets the struct
+    // before filling it in, so padding bytes are deterministic.
+    static khronos_uint64_t hash_resources(const ShBuiltInResources& resources) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&resources);
+        khronos_uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < sizeof(ShBuiltInResources); ++i) {
+            hash ^= static_cast<khronos_uint64_t>(bytes[i]);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+private:
+    struct Entry {
+        sh::GLenum shaderType;
+        ShShaderSpec spec;
+        ShShaderOutput output;
+        khronos_uint64_t resources_hash;
+        ShBuiltInResources resources;
+        ShHandle handle;
+        uint32_t profile_id; // Last profile this compiler was acquired for, or 0
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<const CompilerCache*> caches;
+        unsigned long long retired_hits = 0;
+        unsigned long long retired_misses = 0;
+    };
+
+    // Never destroyed, so caches in static and thread_local storage can
+    // unregister in any order at exit.
+    static Registry& GetRegistry() {
+        static Registry* registry = new Registry;
+        return *registry;
+    }
+
+    size_t capacity_;
+    std::list<Entry> entries_; // Front is most recently used
+    std::atomic<size_t> size_{0}; // entries_.size(), for GetTotals()
+    std::atomic<unsigned long long> hits_{0};
+    std::atomic<unsigned long long> misses_{0};
+};
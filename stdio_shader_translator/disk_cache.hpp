@@ -0,0 +1,285 @@
+#pragma once
+
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "angle_commit.h"
+#include "json.hpp"
+
+// Directory of serialized translate payloads shared by every process pointed
+// at it, so a new server starts warm. Entries are named by the result cache
+// key (see ResultCache::Key::name()) and live under a subdirectory named for
+// the entry format and the ANGLE commit, so a different ANGLE never sees them.
+//
+// Reads map the file and parse it in place (on Windows they read it into a
+// string instead). Writes go to a temporary file
+// that is renamed over the entry, so concurrent readers and writers in other
+// processes only ever see whole entries. Reading an entry refreshes its
+// modification time; once the directory grows past max_bytes the least
+// recently used entries are deleted until it is back under 90% of that.
+//
+// Thread-safe. The size used to decide when to evict is this process's
+// estimate; eviction itself rescans the directory.
+class DiskCache {
+public:
+    static constexpr int kFormatVersion = 2; // Bump when the payloads change shape
+    static constexpr uint64_t kDefaultMaxBytes = 1024ull * 1024 * 1024;
+
+    DiskCache(const std::string& directory, uint64_t max_bytes)
+        : root_(std::filesystem::path(directory) /
+                ("v" + std::to_string(kFormatVersion) + "-" + ANGLE_COMMIT_HASH)),
+          max_bytes_(max_bytes) {
+        std::error_code error;
+        std::filesystem::create_directories(root_, error);
+        usable_ = !error;
+        if (usable_) {
+            bytes_ = scan(nullptr);
+        }
+    }
+
+    // False if the directory could not be created; the cache then does nothing.
+    bool usable() const { return usable_; }
+
+    bool read(const std::string& name, nlohmann::json* payload) {
+        if (!usable_) {
+            return false;
+        }
+        const std::filesystem::path path = entry_path(name);
+        bool damaged = false;
+        if (!ReadEntry(path, payload, &damaged)) {
+            if (damaged) {
+                std::error_code error;
+                std::filesystem::remove(path, error); // Not written by us, or damaged on disk
+            }
+            ++misses_;
+            return false;
+        }
+        ++hits_;
+        return true;
+    }
+
+    void write(const std::string& name, const std::string& text) {
+        if (!usable_ || text.size() > max_bytes_) {
+            return;
+        }
+        const std::filesystem::path path = entry_path(name);
+        std::error_code error;
+        std::filesystem::create_directories(path.parent_path(), error);
+        const std::filesystem::path temp_path =
+            path.string() + ".tmp." + std::to_string(ProcessId()) + "." + std::to_string(++temp_counter_);
+        if (!WriteFile(temp_path, text)) {
+            return;
+        }
+        // An entry replaced in place no longer counts towards the size
+        uint64_t replaced = std::filesystem::file_size(path, error);
+        if (error) {
+            replaced = 0;
+        }
+        std::filesystem::rename(temp_path, path, error);
+        if (error) {
+            std::filesystem::remove(temp_path, error);
+            return;
+        }
+        bytes_ -= std::min<uint64_t>(replaced, bytes_);
+        ++writes_;
+        if ((bytes_ += text.size()) > max_bytes_) {
+            evict();
+        }
+    }
+
+    nlohmann::json stats() const {
+        nlohmann::json jstats;
+        jstats["directory"] = root_.string();
+        jstats["bytes"] = bytes_.load();
+        jstats["max_bytes"] = max_bytes_;
+        jstats["hits"] = hits_.load();
+        jstats["misses"] = misses_.load();
+        jstats["writes"] = writes_.load();
+        jstats["evictions"] = evictions_.load();
+        return jstats;
+    }
+
+private:
+    struct File {
+        std::filesystem::path path;
+        uint64_t bytes;
+        std::filesystem::file_time_type used;
+    };
+
+    // Returns false if the entry is missing, or with *damaged set if it does
+    // not parse. Marks a parsed entry as recently used for eviction.
+    static bool ReadEntry(const std::filesystem::path& path, nlohmann::json* payload, bool* damaged) {
+#if defined(_WIN32)
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            return false;
+        }
+        const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        *payload = nlohmann::json::parse(text, nullptr, false);
+        if (text.empty() || payload->is_discarded()) {
+            *damaged = true;
+            return false;
+        }
+        std::error_code error;
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+        return true;
+#else
+        const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        bool ok = fstat(fd, &st) == 0 && st.st_size > 0;
+        if (ok) {
+            void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            ok = data != MAP_FAILED;
+            if (ok) {
+                const char* text = static_cast<const char*>(data);
+                *payload = nlohmann::json::parse(text, text + st.st_size, nullptr, false);
+                munmap(data, static_cast<size_t>(st.st_size));
+                ok = !payload->is_discarded();
+            }
+        }
+        if (ok) {
+            futimens(fd, nullptr);
+        }
+        close(fd);
+        *damaged = !ok;
+        return ok;
+#endif
+    }
+
+    // Writes text to a new file at path; fails if it already exists, and
+    // removes what it wrote if it fails later.
+    static bool WriteFile(const std::filesystem::path& path, const std::string& text) {
+#if defined(_WIN32)
+        std::error_code error;
+        if (std::filesystem::exists(path, error)) {
+            return false;
+        }
+        std::ofstream out(path, std::ios::binary);
+        out.write(text.data(), static_cast<std::streamsize>(text.size()));
+        out.close();
+        if (out.fail()) {
+            std::filesystem::remove(path, error);
+            return false;
+        }
+        return true;
+#else
+        const int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        size_t written = 0;
+        while (written < text.size()) {
+            const ssize_t n = ::write(fd, text.data() + written, text.size() - written);
+            if (n <= 0) {
+                break;
+            }
+            written += static_cast<size_t>(n);
+        }
+        if (close(fd) != 0 || written != text.size()) {
+            unlink(path.c_str());
+            return false;
+        }
+        return true;
+#endif
+    }
+
+    static long ProcessId() {
+#if defined(_WIN32)
+        return _getpid();
+#else
+        return static_cast<long>(getpid());
+#endif
+    }
+
+    // <root>/<first two hex digits>/<name>.json, so no directory grows huge.
+    std::filesystem::path entry_path(const std::string& name) const {
+        return root_ / name.substr(0, 2) / (name + ".json");
+    }
+
+    // Returns the bytes in entries, listing them in *files if given.
+    // Temporary files a crashed writer left behind are deleted on the way.
+    uint64_t scan(std::vector<File>* files) {
+        uint64_t total = 0;
+        std::error_code error;
+        const auto stale = std::filesystem::file_time_type::clock::now() - std::chrono::minutes(10);
+        for (auto it = std::filesystem::recursive_directory_iterator(root_, error);
+             !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error)) {
+            std::error_code entry_error;
+            if (!it->is_regular_file(entry_error)) {
+                continue;
+            }
+            const uint64_t bytes = it->file_size(entry_error);
+            const auto used = it->last_write_time(entry_error);
+            if (entry_error) {
+                continue; // Removed by another process meanwhile
+            }
+            if (it->path().extension() != ".json") {
+                if (used < stale) {
+                    std::filesystem::remove(it->path(), entry_error);
+                }
+                continue;
+            }
+            total += bytes;
+            if (files) {
+                files->push_back(File{it->path(), bytes, used});
+            }
+        }
+        return total;
+    }
+
+    void evict() {
+        std::unique_lock<std::mutex> lock(evict_mutex_, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return; // Another thread is already evicting
+        }
+        std::vector<File> files;
+        uint64_t total = scan(&files);
+        std::sort(files.begin(), files.end(), [](const File& a, const File& b) { return a.used < b.used; });
+        const uint64_t low_water = max_bytes_ / 10 * 9;
+        for (const File& file : files) {
+            if (total <= low_water) {
+                break;
+            }
+            std::error_code error;
+            if (std::filesystem::remove(file.path, error)) {
+                ++evictions_;
+            }
+            total -= file.bytes; // Gone either way, if another process beat us to it
+        }
+        bytes_ = total;
+    }
+
+    std::filesystem::path root_;
+    uint64_t max_bytes_;
+    bool usable_ = false;
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<unsigned long long> hits_{0};
+    std::atomic<unsigned long long> misses_{0};
+    std::atomic<unsigned long long> writes_{0};
+    std::atomic<unsigned long long> evictions_{0};
+    std::atomic<unsigned long long> temp_counter_{0};
+    std::mutex evict_mutex_;
+};
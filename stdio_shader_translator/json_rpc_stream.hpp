@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+
+// Reads JSON-RPC messages from and writes them to a pair of streams.
+//
+// Two framings are supported:
+// - kLines: one message per line (the default, as before).
+// - kContentLength: each message is preceded by a "Content-Length: N" header
+//   and an empty line, as in the Language Server Protocol. The payload is read
+//   with a single read() of N bytes, so large shaders need no newline scanning
+//   and may contain raw newlines. N must be a plain decimal number of at most
+//   max_message_bytes; anything else is a malformed header.
+//
+// Responses are not flushed one by one. write() flushes only when its
+// caller reports that no more work is pending, or once flush_batch responses
+// have accumulated, so a client that pipelines many requests gets its
+// responses in a few large writes. A client that waits for each response
+// still gets it immediately, because the input is dry at that point.
+//
+// Not thread-safe; callers that share one stream must serialize writes.
+class JsonRpcStream {
+public:
+    enum class Framing { kLines, kContentLength };
+
+    static constexpr uint64_t kDefaultMaxMessageBytes = 64ull << 20;
+
+    JsonRpcStream(std::istream& in, std::ostream& out, Framing framing, size_t flush_batch,
+                  uint64_t max_message_bytes = kDefaultMaxMessageBytes)
+        : in_(in), out_(out), framing_(framing), flush_batch_(flush_batch ? flush_batch : 1),
+          max_message_bytes_(max_message_bytes) {}
+
+    // Reads the next message into *message. Returns false at end of input or
+    // if a frame header is malformed, which malformed() then reports.
+    bool read(std::string* message) {
+        if (framing_ == Framing::kLines) {
+            return static_cast<bool>(std::getline(in_, *message));
+        }
+
+        size_t length = 0;
+        bool have_length = false;
+        std::string header;
+        while (std::getline(in_, header)) {
+            if (!header.empty() && header.back() == '\r') {
+                header.pop_back();
+            }
+            if (header.empty()) {
+                if (!have_length) {
+                    continue; // Tolerate blank lines between frames
+                }
+                message->resize(length);
+                if (length && !in_.read(&(*message)[0], static_cast<std::streamsize>(length))) {
+                    malformed_ = true;
+                    return false;
+                }
+                return true;
+            }
+            static const char kContentLength[] = "Content-Length:";
+            if (header.compare(0, sizeof(kContentLength) - 1, kContentLength) == 0) {
+                if (!parse_length(header.substr(sizeof(kContentLength) - 1), &length)) {
+                    malformed_ = true;
+                    return false;
+                }
+                have_length = true;
+            }
+            // Other headers (e.g. Content-Type) are ignored.
+        }
+        malformed_ = have_length; // EOF inside a header block
+        return false;
+    }
+
+    bool malformed() const { return malformed_; }
+
+    // True if input is already buffered, i.e. the next read() will not block.
+    bool input_pending() const { return in_.rdbuf()->in_avail() > 0; }
+
+    // Queues one response. more_pending tells whether the caller already has
+    // further requests to answer; if not, everything queued is flushed.
+    void write(const std::string& message, bool more_pending) {
+        if (framing_ == Framing::kContentLength) {
+            out_ << "Content-Length: " << message.size() << "\r\n\r\n" << message;
+        } else {
+            out_ << message << '\n';
+        }
+        if (!more_pending || ++unflushed_ >= flush_batch_) {
+            flush();
+        }
+    }
+
+    void flush() {
+        out_.flush();
+        unflushed_ = 0;
+    }
+
+private:
+    // Parses the value of a Content-Length header: optional blanks around
+    // decimal digits, no sign, and at most max_message_bytes_.
+    bool parse_length(const std::string& text, size_t* length) const {
+        size_t i = text.find_first_not_of(" \t");
+        const size_t end = text.find_last_not_of(" \t");
+        if (i == std::string::npos) {
+            return false;
+        }
+        const uint64_t limit = max_message_bytes_ < SIZE_MAX ? max_message_bytes_ : SIZE_MAX;
+        uint64_t value = 0;
+        for (; i <= end; ++i) {
+            if (text[i] < '0' || text[i] > '9') {
+                return false;
+            }
+            const uint64_t digit = static_cast<uint64_t>(text[i] - '0');
+            if (value > (limit - digit) / 10) {
+                return false; // Also rules out overflow
+            }
+            value = value * 10 + digit;
+        }
+        *length = static_cast<size_t>(value);
+        return true;
+    }
+
+    std::istream& in_;
+    std::ostream& out_;
+    Framing framing_;
+    size_t flush_batch_;
+    uint64_t max_message_bytes_;
+    size_t unflushed_ = 0;
+    bool malformed_ = false;
+};
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "json.hpp"
+
+// Streaming JSON writer that appends compact JSON text to a caller-owned
+// buffer, so hot serializers can emit large documents without building an
+// nlohmann::json node per field. Output matches nlohmann::json::dump() for
+// the same document as long as callers emit object keys in sorted order.
+//
+// Commas are tracked with a single flag rather than a stack: after a value or
+// a closing bracket one is due before the next key or array element.
+class JsonWriter {
+public:
+    // Binary subtype marking a json::binary value that holds pre-serialized
+    // JSON text. Dump() splices such values into its output verbatim.
+    static constexpr std::uint64_t kRawJsonSubtype = 0x4a;
+
+    explicit JsonWriter(std::string* out) : out_(*out) {}
+
+    void begin_object() {
+        separate();
+        out_ += '{';
+        need_comma_ = false;
+    }
+    void end_object() {
+        out_ += '}';
+        need_comma_ = true;
+    }
+    void begin_array() {
+        separate();
+        out_ += '[';
+        need_comma_ = false;
+    }
+    void end_array() {
+        out_ += ']';
+        need_comma_ = true;
+    }
+
+    void key(const char* name) {
+        separate();
+        out_ += '"';
+        out_ += name; // Keys are string literals that never need escaping
+        out_ += "\":";
+        need_comma_ = false;
+    }
+
+    void value(const std::string& text) { value(text.data(), text.size()); }
+    void value(const char* text) { value(text, std::strlen(text)); }
+    void value(const char* text, size_t size) {
+        separate();
+        append_string(text, size);
+        need_comma_ = true;
+    }
+    void value(bool flag) {
+        separate();
+        out_ += flag ? "true" : "false";
+        need_comma_ = true;
+    }
+    template <typename Int, typename = std::enable_if_t<std::is_integral<Int>::value>>
+    void value(Int number) {
+        separate();
+        append_integer(number);
+        need_comma_ = true;
+    }
+
+    template <typename Int>
+    void array(const std::vector<Int>& numbers) {
+        begin_array();
+        for (Int number : numbers) {
+            value(number);
+        }
+        end_array();
+    }
+
+    // Wraps serialized JSON text so it can sit inside an nlohmann::json tree
+    // and still be written verbatim by Dump().
+    static nlohmann::json RawJson(const std::string& json_text) {
+        return nlohmann::json::binary(std::vector<std::uint8_t>(json_text.begin(), json_text.end()), kRawJsonSubtype);
+    }
+
+    // nlohmann::json::dump() with RawJson() values spliced in as JSON.
+    static std::string Dump(const nlohmann::json& document) {
+        std::string text;
+        Dump(document, &text);
+        return text;
+    }
+
+    // Same, replacing the contents of *text but keeping its capacity, so a
+    // buffer reused across calls stops allocating once it has grown.
+    static void Dump(const nlohmann::json& document, std::string* text) {
+        text->clear();
+        JsonWriter writer(text);
+        writer.write(document);
+    }
+
+    // Writes an nlohmann::json value, splicing RawJson() values in verbatim.
+    void write(const nlohmann::json& document) {
+        switch (document.type()) {
+            case nlohmann::json::value_t::object:
+                begin_object();
+                for (const auto& item : document.items()) {
+                    separate();
+                    append_string(item.key().data(), item.key().size());
+                    out_ += ':';
+                    need_comma_ = false;
+                    write(item.value());
+                }
+                end_object();
+                break;
+            case nlohmann::json::value_t::array:
+                begin_array();
+                for (const auto& element : document) {
+                    write(element);
+                }
+                end_array();
+                break;
+            case nlohmann::json::value_t::string:
+                value(document.get_ref<const std::string&>());
+                break;
+            case nlohmann::json::value_t::binary: {
+                const auto& bytes = document.get_binary();
+                separate();
+                if (bytes.has_subtype() && bytes.subtype() == kRawJsonSubtype) {
+                    out_.append(bytes.begin(), bytes.end());
+                } else {
+                    out_ += document.dump();
+                }
+                need_comma_ = true;
+                break;
+            }
+            default: // null, booleans and numbers
+                separate();
+                out_ += document.dump();
+                need_comma_ = true;
+                break;
+        }
+    }
+
+private:
+    void separate() {
+        if (need_comma_) {
+            out_ += ',';
+        }
+    }
+
+    template <typename Int>
+    void append_integer(Int number) {
+        char digits[24];
+        char* end = digits + sizeof(digits);
+        char* begin = end;
+        using Unsigned = std::make_unsigned_t<Int>;
+        Unsigned magnitude = static_cast<Unsigned>(number);
+        if (number < 0) {
+            magnitude = static_cast<Unsigned>(Unsigned(0) - magnitude);
+        }
+        do {
+            *--begin = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude);
+        if (number < 0) {
+            *--begin = '-';
+        }
+        out_.append(begin, end);
+    }
+
+    // Escapes like nlohmann::json::dump(): quotes, backslashes and control
+    // characters are escaped, UTF-8 is passed through unchanged.
+    void append_string(const char* text, size_t size) {
+        static const char kHex[] = "0123456789abcdef";
+        out_ += '"';
+        size_t run = 0; // Start of the pending run of bytes that need no escaping
+        for (size_t i = 0; i < size; ++i) {
+            const unsigned char c = static_cast<unsigned char>(text[i]);
+            if (c >= 0x20 && c != '"' && c != '\\') {
+                continue;
+            }
+            out_.append(text + run, i - run);
+            run = i + 1;
+            switch (c) {
+                case '"': out_ += "\\\""; break;
+                case '\\': out_ += "\\\\"; break;
+                case '\b': out_ += "\\b"; break;
+                case '\f': out_ += "\\f"; break;
+                case '\n': out_ += "\\n"; break;
+                case '\r': out_ += "\\r"; break;
+                case '\t': out_ += "\\t"; break;
+                default:
+                    out_ += "\\u00";
+                    out_ += kHex[c >> 4];
+                    out_ += kHex[c & 0xf];
+                    break;
+            }
+        }
+        out_.append(text + run, size - run);
+        out_ += '"';
+    }
+
+    std::string& out_;
+    bool need_comma_ = false;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "common/system_utils.h"
+
+// Records the highest process memory use seen at the end of a request, and
+// the largest growth a single request caused. Under WASM linear memory never
+// shrinks, so the high-water mark is what the host ends up paying for; natively
+// it is the peak resident set size observed between requests.
+//
+// Natively, reading memory use means parsing /proc, so only one request per
+// kSampleInterval is measured; "stats" and "compact" take a reading of their
+// own as well. Short spikes between samples can therefore be missed. Under
+// WASM the reading is the linear memory size and every request is measured.
+//
+// Thread-safe. With several workers, growth is process-wide and may include
+// concurrent requests.
+class MemoryWatermark {
+public:
+    static constexpr std::chrono::milliseconds kSampleInterval{100};
+
+    // Measures memory use around one request, if it is due for a sample.
+    class Scope {
+    public:
+        explicit Scope(MemoryWatermark& watermark)
+            : watermark_(watermark), sampled_(watermark.sample_due()),
+              before_kb_(sampled_ ? angle::GetProcessMemoryUsageKB() : 0) {}
+        ~Scope() {
+            if (sampled_) {
+                watermark_.observe(before_kb_, angle::GetProcessMemoryUsageKB());
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        MemoryWatermark& watermark_;
+        bool sampled_;
+        uint64_t before_kb_;
+    };
+
+    void observe(uint64_t before_kb, uint64_t after_kb) {
+        raise(&high_water_kb_, after_kb);
+        if (after_kb > before_kb) {
+            raise(&largest_growth_kb_, after_kb - before_kb);
+        }
+    }
+
+    uint64_t high_water_kb() const { return high_water_kb_.load(); }
+    uint64_t largest_growth_kb() const { return largest_growth_kb_.load(); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // True for at most one caller per kSampleInterval.
+    bool sample_due() {
+#if defined(__EMSCRIPTEN__)
+        return true;
+#else
+        const int64_t now = Clock::now().time_since_epoch().count();
+        int64_t next = next_sample_.load(std::memory_order_relaxed);
+        return now >= next &&
+               next_sample_.compare_exchange_strong(
+                   next, now + std::chrono::duration_cast<Clock::duration>(kSampleInterval).count(),
+                   std::memory_order_relaxed);
+#endif
+    }
+
+    static void raise(std::atomic<uint64_t>* value, uint64_t candidate) {
+        uint64_t current = value->load();
+        while (candidate > current && !value->compare_exchange_weak(current, candidate)) {
+        }
+    }
+
+    std::atomic<uint64_t> high_water_kb_{0};
+    std::atomic<uint64_t> largest_growth_kb_{0};
+    std::atomic<int64_t> next_sample_{0}; // Clock ticks
+};
@@ -0,0 +1,175 @@
+// angle_translator._native: a CPython extension that runs the translator
+// in-process, for ShaderTranslator(backend="native"). Built from this file
+// and the same ANGLE sources as the WASM module by the TRANSLATOR_PYTHON_MODULE
+// CMake option; see wasm_build.md.
+//
+// translate() takes the source as str or bytes plus a registered profile id
+// and returns the output without a JSON-RPC envelope; invoke() takes a full
+// JSON-RPC request, for every other method. Both release the GIL while they
+// run, and each calling thread keeps its own compilers (as the --workers
+// threads do), so translations on separate Python threads run in parallel.
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#define SHADER_TRANSLATOR_EMBEDDED // Leaves main() out of shader_translator.cpp
+#include "shader_translator.cpp"
+
+namespace {
+
+// The calling thread's compilers, flushed first if any thread handled
+// flush_compilers or compact since this one last translated.
+CompilerCache& ThreadCompilers() {
+    thread_local CompilerCache compilers;
+    thread_local unsigned flush_generation = g_compiler_flush_generation.load();
+    const unsigned generation = g_compiler_flush_generation.load();
+    if (generation != flush_generation) {
+        compilers.flush();
+        flush_generation = generation;
+    }
+    return compilers;
+}
+
+const std::string& PayloadString(const json& object, const char* key) {
+    static const std::string empty;
+    if (object.is_object() && object.contains(key) && object[key].is_string()) {
+        return object[key].get_ref<const std::string&>();
+    }
+    return empty;
+}
+
+PyObject* StringObject(const std::string& text) {
+    return PyUnicode_DecodeUTF8(text.data(), static_cast<Py_ssize_t>(text.size()), "replace");
+}
+
+// Everything in object but the given keys, as JSON text, or None if that is nothing.
+PyObject* RemainingJson(const json& object, std::initializer_list<const char*> handled) {
+    if (!object.is_object()) {
+        Py_RETURN_NONE;
+    }
+    json rest = object;
+    for (const char* key : handled) {
+        rest.erase(key);
+    }
+    if (rest.empty()) {
+        Py_RETURN_NONE;
+    }
+    return StringObject(JsonWriter::Dump(rest));
+}
+
+// translate(source, shader_type, profile_id)
+//     -> (status, object_code, info_log, message, extra)
+//
+// status is 0 or the error code. object_code is str, or bytes for SPIR-V,
+// and None on failure. extra is JSON text of the remaining result fields
+// (active_variables, ...) or, on failure, of the error's data; or None.
+PyObject* Translate(PyObject*, PyObject* args) {
+    const char* source = nullptr;
+    Py_ssize_t source_size = 0;
+    const char* shader_type_name = nullptr;
+    unsigned long long profile_id = 0;
+    if (!PyArg_ParseTuple(args, "s#sK", &source, &source_size, &shader_type_name, &profile_id)) {
+        return nullptr;
+    }
+    const TranslationProfile* profile = g_profile_registry.find(profile_id);
+    if (!profile) {
+        PyErr_SetString(PyExc_ValueError, "Unknown profile id; register it with register_profile first.");
+        return nullptr;
+    }
+    const sh::GLenum shader_type = FindShaderTypeFromJson(shader_type_name);
+    if (shader_type == GL_NONE) {
+        PyErr_Format(PyExc_ValueError, "Unsupported shader type: %s", shader_type_name);
+        return nullptr;
+    }
+
+    json payload;
+    bool failed = false;
+    Py_BEGIN_ALLOW_THREADS
+    const auto start = std::chrono::steady_clock::now();
+    const std::string shader_source(source, static_cast<size_t>(source_size));
+    {
+        MemoryWatermark::Scope memory_scope(g_memory_watermark);
+        payload = TranslateSourceWithOptions(shader_source, shader_type, *profile, ThreadCompilers(), &g_result_cache);
+    }
+    // Counted in stats() like "translate" requests
+    failed = payload.contains("code") && payload.contains("message");
+    if (failed) {
+        g_server_stats.record_error(payload["code"].get<int>());
+    }
+    g_server_stats.record_request("translate", std::chrono::duration_cast<std::chrono::microseconds>(
+                                                   std::chrono::steady_clock::now() - start).count());
+    g_server_stats.record_translation(profile->spec_label, profile->output_label);
+    Py_END_ALLOW_THREADS
+
+    if (failed) {
+        const json& data = payload.contains("data") ? payload["data"] : json();
+        return Py_BuildValue("(iOsNN)", payload["code"].get<int>(), Py_None, "",
+                             StringObject(PayloadString(payload, "message")), RemainingJson(data, {}));
+    }
+    PyObject* object_code = nullptr;
+    if (payload.contains("object_code_base64")) {
+        std::string binary;
+        decode_into(PayloadString(payload, "object_code_base64"), binary);
+        object_code = PyBytes_FromStringAndSize(binary.data(), static_cast<Py_ssize_t>(binary.size()));
+    } else {
+        object_code = StringObject(PayloadString(payload, "object_code"));
+    }
+    return Py_BuildValue("(iNNsN)", static_cast<int>(ESuccess), object_code,
+                         StringObject(PayloadString(payload, "info_log")), "",
+                         RemainingJson(payload, {"object_code", "object_code_base64", "info_log"}));
+}
+
+// invoke(request) -> bytes: the JSON-RPC response to a JSON-RPC request.
+// The request is any bytes-like object and is read by length, so a slice of
+// a larger buffer works without a NUL terminator, as with invoke_ex().
+PyObject* Invoke(PyObject*, PyObject* args) {
+    Py_buffer request;
+    if (!PyArg_ParseTuple(args, "y*", &request)) {
+        return nullptr;
+    }
+    const char* request_data = static_cast<const char*>(request.buf);
+
+    std::string response;
+    Py_BEGIN_ALLOW_THREADS
+    json request_json = json::parse(request_data, request_data + request.len, nullptr, false);
+    json response_json_shell;
+    response_json_shell["jsonrpc"] = "2.0";
+    response_json_shell["id"] = nullptr;
+    if (request_json.is_discarded()) {
+        response_json_shell["error"] = make_json_error_payload(EFailJSONRPCParse, "Parse error: Invalid JSON format.");
+        g_server_stats.record_error(EFailJSONRPCParse);
+    } else {
+        dispatch_json_rpc_request(request_json, response_json_shell, ThreadCompilers(), nullptr);
+    }
+    JsonWriter::Dump(response_json_shell, &response);
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&request);
+
+    return PyBytes_FromStringAndSize(response.data(), static_cast<Py_ssize_t>(response.size()));
+}
+
+PyMethodDef kMethods[] = {
+    {"translate", Translate, METH_VARARGS, "translate(source, shader_type, profile_id) -> (status, object_code, info_log, message, extra)"},
+    {"invoke", Invoke, METH_VARARGS, "invoke(request) -> bytes: the JSON-RPC response to a JSON-RPC request."},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+// ANGLE is initialized once and never finalized: threads that have
+// translated may still hold compilers when the interpreter exits.
+PyModuleDef kModule = {PyModuleDef_HEAD_INIT, "_native", "In-process ANGLE shader translator.", -1, kMethods,
+                       nullptr, nullptr, nullptr, nullptr};
+
+} // namespace
+
+PyMODINIT_FUNC PyInit__native() {
+    if (!sh::Initialize()) {
+        PyErr_SetString(PyExc_ImportError, "The ANGLE library failed to initialize.");
+        return nullptr;
+    }
+    PyObject* module = PyModule_Create(&kModule);
+    if (module && PyModule_AddStringConstant(module, "angle_commit", ANGLE_COMMIT_HASH) < 0) {
+        Py_DECREF(module);
+        return nullptr;
+    }
+    return module;
+}
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "GLSLANG/ShaderLang.h"
+#include "active_variables.hpp"
+
+// Serializes a compiler's active variables into a compact binary blob, the
+// "reflection_format": "binary" alternative to the active_variables JSON.
+// Readers index straight into it; angle_translator.reflection is the Python
+// one.
+//
+// Every integer is little-endian and every section is 4-byte aligned:
+//
+//   header      magic "ANRF", u16 version, u16 header size, then u32 pairs
+//               (count, byte offset) for the variables, blocks, array sizes
+//               and strings sections, then a (first index, count) u32 pair
+//               per list in kActiveVariableListNames order. Variable lists
+//               index variables, block lists index blocks; a list the
+//               "reflect" mask left out has first index 0xffffffff.
+//   variables   kVariableSize-byte records: u32 name, u32 mapped_name,
+//               u32 struct_or_block_name, u32 type_enum, u16 precision_enum,
+//               u16 flags, i32 location, i32 binding, i32 offset,
+//               u32 first array size, u16 array size count, u16 field count,
+//               u32 first field (a variable index).
+//   blocks      kBlockSize-byte records: u32 name, u32 mapped_name,
+//               u32 instance_name, u32 layout (kLayouts index), u16 flags,
+//               u16 reserved, i32 binding, u32 array_size, u32 field count,
+//               u32 first field.
+//   array sizes u32 each; a variable's sizes are consecutive.
+//   strings     each distinct string once, as a u32 byte length then its
+//               UTF-8 bytes padded to 4 bytes. Names are byte offsets into
+//               this section.
+//
+// Fields of one struct or block, and the top-level entries of one list, are
+// consecutive records. Absent location, binding and offset are -1, as in
+// ANGLE, and absent names are the empty string.
+class ReflectionBlobWriter {
+public:
+    static constexpr char kMagic[4] = {'A', 'N', 'R', 'F'};
+    static constexpr uint16_t kVersion = 1;
+    static constexpr uint32_t kVariableSize = 44;
+    static constexpr uint32_t kBlockSize = 36;
+    static constexpr uint32_t kHeaderSize = 8 + 4 * 8 + kActiveVariableListCount * 8;
+    static constexpr uint32_t kOmittedList = 0xffffffff;
+
+    static constexpr const char* kLayouts[] = {"unknown", "shared", "packed", "std140", "std430"};
+
+    enum Flags : uint16_t {
+        kActive = 1 << 0,
+        kStaticUse = 1 << 1,
+        kRowMajor = 1 << 2,
+    };
+
+    // Returns the blob for the lists selected by mask.
+    static std::string Write(const ActiveVariableLists& lists, ActiveVariableMask mask) {
+        ReflectionBlobWriter writer;
+        for (int i = 0; i < kActiveVariableListCount; ++i) {
+            if (!(mask & (1u << i))) {
+                writer.lists_[i][0] = kOmittedList;
+            } else if (IsBlockList(i)) {
+                writer.add_blocks(i, lists.blocks[i]);
+            } else {
+                writer.add_variables(i, lists.variables[i]);
+            }
+        }
+        return writer.finish();
+    }
+
+private:
+    ReflectionBlobWriter() { intern(std::string()); }
+
+    // Adds a top-level list; null from the ANGLE API is an empty list.
+    void add_variables(size_t list, const std::vector<sh::ShaderVariable>* items) {
+        lists_[list][0] = static_cast<uint32_t>(variables_.size() / kVariableSize);
+        lists_[list][1] = items ? static_cast<uint32_t>(items->size()) : 0;
+        if (items) {
+            append_variables(*items);
+        }
+    }
+
+    void add_blocks(size_t list, const std::vector<sh::InterfaceBlock>* items) {
+        lists_[list][0] = static_cast<uint32_t>(blocks_.size() / kBlockSize);
+        lists_[list][1] = items ? static_cast<uint32_t>(items->size()) : 0;
+        if (!items) {
+            return;
+        }
+        for (const sh::InterfaceBlock& block : *items) {
+            uint32_t layout = 0;
+            switch (block.layout) {
+                case sh::BlockLayoutType::BLOCKLAYOUT_SHARED: layout = 1; break;
+                case sh::BlockLayoutType::BLOCKLAYOUT_PACKED: layout = 2; break;
+                case sh::BlockLayoutType::BLOCKLAYOUT_STD140: layout = 3; break;
+                case sh::BlockLayoutType::BLOCKLAYOUT_STD430: layout = 4; break;
+                default: break;
+            }
+            // The fields go after everything already written, so the block
+            // record can be completed in one go.
+            const uint32_t first_field = append_variables(block.fields);
+            put32(&blocks_, intern(block.name));
+            put32(&blocks_, intern(block.mappedName));
+            put32(&blocks_, intern(block.instanceName));
+            put32(&blocks_, layout);
+            put16(&blocks_, flags(block.active, block.staticUse, block.isRowMajorLayout));
+            put16(&blocks_, 0);
+            put32(&blocks_, static_cast<uint32_t>(block.binding));
+            put32(&blocks_, block.arraySize);
+            put32(&blocks_, static_cast<uint32_t>(block.fields.size()));
+            put32(&blocks_, first_field);
+        }
+    }
+
+    // Writes items as consecutive records, their fields after them, and
+    // returns the index of the first.
+    uint32_t append_variables(const std::vector<sh::ShaderVariable>& items) {
+        const uint32_t first = static_cast<uint32_t>(variables_.size() / kVariableSize);
+        variables_.resize(variables_.size() + items.size() * kVariableSize);
+        for (size_t i = 0; i < items.size(); ++i) {
+            const sh::ShaderVariable& var = items[i];
+            const uint32_t first_field = var.fields.empty() ? 0 : append_variables(var.fields);
+            const uint32_t first_array_size = static_cast<uint32_t>(array_sizes_.size() / 4);
+            for (unsigned int size : var.arraySizes) {
+                put32(&array_sizes_, size);
+            }
+
+            std::string record;
+            put32(&record, intern(var.name));
+            put32(&record, intern(var.mappedName));
+            put32(&record, intern(var.structOrBlockName));
+            put32(&record, var.type);
+            put16(&record, static_cast<uint16_t>(var.precision));
+            put16(&record, flags(var.active, var.staticUse, var.isRowMajorLayout));
+            put32(&record, static_cast<uint32_t>(var.location));
+            put32(&record, static_cast<uint32_t>(var.binding));
+            put32(&record, static_cast<uint32_t>(var.offset));
+            put32(&record, first_array_size);
+            put16(&record, static_cast<uint16_t>(var.arraySizes.size()));
+            put16(&record, static_cast<uint16_t>(var.fields.size()));
+            put32(&record, first_field);
+            // The recursion above may have grown the buffer, so index it only now.
+            memcpy(&variables_[(first + i) * kVariableSize], record.data(), kVariableSize);
+        }
+        return first;
+    }
+
+    std::string finish() const {
+        const uint32_t variables_offset = kHeaderSize;
+        const uint32_t blocks_offset = variables_offset + static_cast<uint32_t>(variables_.size());
+        const uint32_t array_sizes_offset = blocks_offset + static_cast<uint32_t>(blocks_.size());
+        const uint32_t strings_offset = array_sizes_offset + static_cast<uint32_t>(array_sizes_.size());
+
+        std::string blob(kMagic, sizeof(kMagic));
+        put16(&blob, kVersion);
+        put16(&blob, kHeaderSize);
+        put32(&blob, static_cast<uint32_t>(variables_.size() / kVariableSize));
+        put32(&blob, variables_offset);
+        put32(&blob, static_cast<uint32_t>(blocks_.size() / kBlockSize));
+        put32(&blob, blocks_offset);
+        put32(&blob, static_cast<uint32_t>(array_sizes_.size() / 4));
+        put32(&blob, array_sizes_offset);
+        put32(&blob, static_cast<uint32_t>(strings_.size()));
+        put32(&blob, strings_offset);
+        for (const auto& list : lists_) {
+            put32(&blob, list[0]);
+            put32(&blob, list[1]);
+        }
+        blob.reserve(strings_offset + strings_.size());
+        blob += variables_;
+        blob += blocks_;
+        blob += array_sizes_;
+        blob += strings_;
+        return blob;
+    }
+
+    uint32_t intern(const std::string& text) {
+        auto inserted = string_offsets_.emplace(text, static_cast<uint32_t>(strings_.size()));
+        if (inserted.second) {
+            put32(&strings_, static_cast<uint32_t>(text.size()));
+            strings_ += text;
+            strings_.append((4 - text.size() % 4) % 4, '\0');
+        }
+        return inserted.first->second;
+    }
+
+    static uint16_t flags(bool active, bool static_use, bool row_major) {
+        return static_cast<uint16_t>((active ? kActive : 0) | (static_use ? kStaticUse : 0) | (row_major ? kRowMajor : 0));
+    }
+
+    static void put16(std::string* out, uint16_t value) {
+        const char bytes[2] = {static_cast<char>(value & 0xff), static_cast<char>(value >> 8)};
+        out->append(bytes, sizeof(bytes));
+    }
+
+    static void put32(std::string* out, uint32_t value) {
+        const char bytes[4] = {static_cast<char>(value & 0xff), static_cast<char>((value >> 8) & 0xff),
+                               static_cast<char>((value >> 16) & 0xff), static_cast<char>(value >> 24)};
+        out->append(bytes, sizeof(bytes));
+    }
+
+    std::string variables_;
+    std::string blocks_;
+    std::string array_sizes_;
+    std::string strings_;
+    std::unordered_map<std::string, uint32_t> string_offsets_;
+    uint32_t lists_[kActiveVariableListCount][2] = {};
+};
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "disk_cache.hpp"
+#include "json.hpp"
+#include "json_writer.hpp"
+#include "xxhash.h"
+
+// Content-addressed cache of translate payloads ("result" or "error" objects).
+// Entries are keyed on a hash of the decoded shader source together with a hash
+// of the normalized request parameters, and the cache is bounded by the
+// serialized size of the stored payloads rather than by entry count.
+//
+// An optional DiskCache sits behind the memory: misses are looked up there
+// and inserts are written through to it.
+//
+// Another key can be made an alias of an entry, so one payload can be found
+// under several keys while the memory and the disk hold it once. Aliases live
+// in memory only and go with their entry.
+//
+// Thread-safe: one cache can be shared by every worker of the JSON-RPC server.
+class ResultCache {
+public:
+    static constexpr size_t kDefaultMaxBytes = 64 * 1024 * 1024;
+
+    struct Key {
+        XXH64_hash_t source_hash;
+        XXH64_hash_t params_hash;
+        size_t source_length;
+
+        bool operator==(const Key& other) const {
+            return source_hash == other.source_hash && params_hash == other.params_hash &&
+                   source_length == other.source_length;
+        }
+
+        // The key as a file name for DiskCache.
+        std::string name() const {
+            char text[3 * 16 + 3];
+            snprintf(text, sizeof(text), "%016llx-%016llx-%llx", static_cast<unsigned long long>(source_hash),
+                     static_cast<unsigned long long>(params_hash), static_cast<unsigned long long>(source_length));
+            return text;
+        }
+    };
+
+    // params_hash must cover every normalized parameter that affects the payload.
+    static Key make_key(const std::string& source, XXH64_hash_t params_hash) {
+        return Key{XXH64(source.data(), source.size(), 0), params_hash, source.size()};
+    }
+
+    explicit ResultCache(size_t max_bytes = kDefaultMaxBytes) : max_bytes_(max_bytes) {}
+
+    // Copies the cached payload for key into *payload. Returns false on a miss.
+    // A payload accept rejects counts as a miss and is not copied out. With
+    // count_miss false a miss is not counted, for callers that look up again
+    // under another key and count only that lookup (or call record_miss()).
+    bool lookup(const Key& key, nlohmann::json* payload, bool count_miss = true,
+                const std::function<bool(const nlohmann::json&)>& accept = nullptr) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto found = find(key);
+            if (found != entries_.end()) {
+                if (accept && !accept(found->payload)) {
+                    misses_ += count_miss ? 1 : 0;
+                    return false;
+                }
+                ++hits_;
+                entries_.splice(entries_.begin(), entries_, found); // Move to MRU position
+                *payload = found->payload;
+                return true;
+            }
+        }
+        if (disk_ && disk_->read(key.name(), payload)) {
+            const std::string text = JsonWriter::Dump(*payload);
+            std::lock_guard<std::mutex> lock(mutex_);
+            store(key, *payload, text.size() + sizeof(Entry));
+            if (!accept || accept(*payload)) {
+                ++disk_hits_;
+                return true;
+            }
+        }
+        if (count_miss) {
+            record_miss();
+        }
+        return false;
+    }
+
+    // Counts a miss for a lookup made with count_miss false.
+    void record_miss() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++misses_;
+    }
+
+    // Stores payload under key, evicting least recently used entries until the
+    // cache fits its budget. Payloads larger than the whole budget are not kept
+    // in memory. The disk cache, if any, gets a copy either way.
+    void insert(const Key& key, const nlohmann::json& payload) {
+        const std::string text = JsonWriter::Dump(payload); // Serialized outside the lock
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            store(key, payload, text.size() + sizeof(Entry));
+        }
+        if (disk_) {
+            disk_->write(key.name(), text);
+        }
+    }
+
+    // Makes alias find the entry under key until that entry is replaced or
+    // evicted. Does nothing if key has no entry in memory.
+    void alias(const Key& alias, const Key& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = index_.find(key);
+        if (found == index_.end() || alias == key) {
+            return;
+        }
+        auto entry = found->second;
+        drop(alias);
+        aliases_[alias] = key;
+        entry->aliases.push_back(alias);
+        entry->bytes += kAliasBytes;
+        bytes_ += kAliasBytes;
+        while (bytes_ > max_bytes_ && !entries_.empty()) {
+            erase(std::prev(entries_.end()));
+            ++evictions_;
+        }
+    }
+
+    // Puts a DiskCache behind the memory; it must outlive this cache. Call
+    // before the cache is shared between threads.
+    void set_disk_cache(DiskCache* disk) { disk_ = disk; }
+    const DiskCache* disk_cache() const { return disk_; }
+
+    // Drops every entry held in memory; the disk cache keeps its entries.
+    // Counters are preserved so hit rates stay meaningful.
+    size_t clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t count = entries_.size();
+        entries_.clear();
+        index_.clear();
+        aliases_.clear();
+        bytes_ = 0;
+        return count;
+    }
+
+    // Changes the byte budget, evicting as needed. 0 disables caching.
+    void set_max_bytes(size_t max_bytes) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        max_bytes_ = max_bytes;
+        while (!entries_.empty() && bytes_ > max_bytes_) {
+            erase(std::prev(entries_.end()));
+            ++evictions_;
+        }
+    }
+
+    nlohmann::json stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        nlohmann::json jstats;
+        jstats["entries"] = entries_.size();
+        jstats["bytes"] = bytes_;
+        jstats["max_bytes"] = max_bytes_;
+        jstats["hits"] = hits_;
+        jstats["misses"] = misses_;
+        jstats["evictions"] = evictions_;
+        if (disk_) {
+            jstats["disk_hits"] = disk_hits_; // Answered from disk: neither hits nor misses
+        }
+        return jstats;
+    }
+
+private:
+    struct Entry {
+        Key key;
+        nlohmann::json payload;
+        size_t bytes;
+        std::vector<Key> aliases; // Keys in aliases_ that lead here
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const { return static_cast<size_t>(key.source_hash ^ (key.params_hash * 31)); }
+    };
+    using EntryList = std::list<Entry>;
+
+    // What an alias costs against the budget: its map node and back link.
+    static constexpr size_t kAliasBytes = 3 * sizeof(Key) + 2 * sizeof(void*);
+
+    // Called with mutex_ held. Returns the entry under key or an alias of it.
+    EntryList::iterator find(const Key& key) {
+        auto found = index_.find(key);
+        if (found != index_.end()) {
+            return found->second;
+        }
+        auto aliased = aliases_.find(key);
+        return aliased == aliases_.end() ? entries_.end() : index_.at(aliased->second);
+    }
+
+    // Called with mutex_ held. Removes whatever is stored under key itself.
+    void drop(const Key& key) {
+        auto found = index_.find(key);
+        if (found != index_.end()) {
+            erase(found->second);
+            return;
+        }
+        auto aliased = aliases_.find(key);
+        if (aliased != aliases_.end()) {
+            auto entry = index_.at(aliased->second);
+            auto& links = entry->aliases;
+            links.erase(std::find(links.begin(), links.end(), key));
+            entry->bytes -= kAliasBytes;
+            bytes_ -= kAliasBytes;
+            aliases_.erase(aliased);
+        }
+    }
+
+    // Called with mutex_ held.
+    void store(const Key& key, const nlohmann::json& payload, size_t bytes) {
+        if (bytes > max_bytes_) {
+            return;
+        }
+        drop(key);
+        while (!entries_.empty() && bytes_ + bytes > max_bytes_) {
+            erase(std::prev(entries_.end()));
+            ++evictions_;
+        }
+        entries_.push_front(Entry{key, payload, bytes, {}});
+        index_[key] = entries_.begin();
+        bytes_ += bytes;
+    }
+
+    void erase(EntryList::iterator it) {
+        for (const Key& alias : it->aliases) {
+            aliases_.erase(alias);
+        }
+        bytes_ -= it->bytes;
+        index_.erase(it->key);
+        entries_.erase(it);
+    }
+
+    mutable std::mutex mutex_;
+    size_t max_bytes_;
+    size_t bytes_ = 0;
+    EntryList entries_; // Front is most recently used
+    std::unordered_map<Key, EntryList::iterator, KeyHash> index_;
+    std::unordered_map<Key, Key, KeyHash> aliases_; // Alias to the key of its entry
+    unsigned long long hits_ = 0;
+    unsigned long long misses_ = 0;
+    unsigned long long evictions_ = 0;
+    unsigned long long disk_hits_ = 0;
+    DiskCache* disk_ = nullptr;
+};
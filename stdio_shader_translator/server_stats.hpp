@@ -0,0 +1,274 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "json.hpp"
+
+// Aggregate metrics for a long-running JSON-RPC process: request counts per
+// method and per spec/output pair, error counts per code and a latency
+// histogram per method. Distinct label values are capped so a misbehaving
+// client cannot grow the maps without bound.
+//
+// Thread-safe: one instance is shared by every worker of the JSON-RPC server.
+class ServerStats {
+public:
+    // Upper bounds of the latency buckets in microseconds. A final bucket
+    // catches everything slower.
+    static constexpr std::array<uint64_t, 15> kLatencyBucketsUs = {
+        50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 5000000};
+    static constexpr size_t kMaxLabelValues = 64;
+
+    // Maps an error code to a symbolic name, or nullptr if it has none.
+    using ErrorNameFn = const char* (*)(int code);
+
+    ServerStats() : start_(std::chrono::steady_clock::now()) {}
+
+    void record_request(const std::string& method, uint64_t latency_us) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Histogram& histogram = latency_[capped(latency_, method)];
+        ++histogram.counts[bucket_index(latency_us)];
+        ++histogram.count;
+        histogram.sum_us += latency_us;
+        if (latency_us > histogram.max_us) {
+            histogram.max_us = latency_us;
+        }
+    }
+
+    void record_translation(const std::string& spec, const std::string& output) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++translations_[capped(translations_, std::make_pair(spec, output))];
+    }
+
+    void record_error(int code) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++errors_[code];
+    }
+
+    // {"uptime_seconds", "requests": {"total", "by_method", "by_spec_output",
+    //  "by_spec", "by_output"}, "errors": {"total", "by_code": [...]},
+    //  "latency_us": {method: {"count", "sum", "max", "p50", "p95", "p99", "buckets"}}}
+    nlohmann::json to_json(ErrorNameFn error_name) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        nlohmann::json jstats;
+        jstats["uptime_seconds"] =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+
+        nlohmann::json requests;
+        unsigned long long total = 0;
+        nlohmann::json by_method = nlohmann::json::object();
+        for (const auto& [method, histogram] : latency_) {
+            by_method[method] = histogram.count;
+            total += histogram.count;
+        }
+        requests["total"] = total;
+        requests["by_method"] = by_method;
+        nlohmann::json by_spec_output = nlohmann::json::array();
+        nlohmann::json by_spec = nlohmann::json::object();
+        nlohmann::json by_output = nlohmann::json::object();
+        for (const auto& [labels, count] : translations_) {
+            by_spec_output.push_back({{"spec", labels.first}, {"output", labels.second}, {"count", count}});
+            by_spec[labels.first] = by_spec.value(labels.first, 0ULL) + count;
+            by_output[labels.second] = by_output.value(labels.second, 0ULL) + count;
+        }
+        requests["by_spec_output"] = by_spec_output;
+        requests["by_spec"] = by_spec;
+        requests["by_output"] = by_output;
+        jstats["requests"] = requests;
+
+        nlohmann::json errors;
+        unsigned long long errors_total = 0;
+        nlohmann::json by_code = nlohmann::json::array();
+        for (const auto& [code, count] : errors_) {
+            nlohmann::json jerror = {{"code", code}, {"count", count}};
+            if (const char* name = error_name ? error_name(code) : nullptr) {
+                jerror["name"] = name;
+            }
+            by_code.push_back(jerror);
+            errors_total += count;
+        }
+        errors["total"] = errors_total;
+        errors["by_code"] = by_code;
+        jstats["errors"] = errors;
+
+        nlohmann::json latency = nlohmann::json::object();
+        for (const auto& [method, histogram] : latency_) {
+            nlohmann::json jhistogram;
+            jhistogram["count"] = histogram.count;
+            jhistogram["sum"] = histogram.sum_us;
+            jhistogram["max"] = histogram.max_us;
+            jhistogram["p50"] = histogram.percentile(0.50);
+            jhistogram["p95"] = histogram.percentile(0.95);
+            jhistogram["p99"] = histogram.percentile(0.99);
+            nlohmann::json buckets = nlohmann::json::array();
+            unsigned long long cumulative = 0;
+            for (size_t i = 0; i < kLatencyBucketsUs.size(); ++i) {
+                cumulative += histogram.counts[i];
+                buckets.push_back({{"le", kLatencyBucketsUs[i]}, {"count", cumulative}});
+            }
+            jhistogram["buckets"] = buckets;
+            latency[method] = jhistogram;
+        }
+        jstats["latency_us"] = latency;
+        return jstats;
+    }
+
+    // Renders a snapshot built from to_json() (optionally extended with
+    // "result_cache", "compiler_cache", "disk_cache" and "memory" objects and
+    // a "sessions" count) in the Prometheus text exposition format. Latencies
+    // are exported in seconds, per convention.
+    static std::string prometheus_text(const nlohmann::json& snapshot) {
+        std::ostringstream out;
+        auto header = [&out](const char* name, const char* type, const char* help) {
+            out << "# HELP " << name << ' ' << help << "\n# TYPE " << name << ' ' << type << '\n';
+        };
+
+        header("shader_translator_uptime_seconds", "gauge", "Seconds since the translator process started.");
+        out << "shader_translator_uptime_seconds " << snapshot["uptime_seconds"].get<double>() << '\n';
+
+        const nlohmann::json& requests = snapshot["requests"];
+        header("shader_translator_requests_total", "counter", "JSON-RPC requests handled, by method.");
+        for (const auto& [method, count] : requests["by_method"].items()) {
+            out << "shader_translator_requests_total{method=\"" << escape(method) << "\"} " << count << '\n';
+        }
+        header("shader_translator_translate_requests_total", "counter", "Translate requests, by spec and output.");
+        for (const auto& entry : requests["by_spec_output"]) {
+            out << "shader_translator_translate_requests_total{spec=\"" << escape(entry["spec"].get<std::string>()) << "\",output=\""
+                << escape(entry["output"].get<std::string>()) << "\"} " << entry["count"] << '\n';
+        }
+
+        header("shader_translator_errors_total", "counter", "Error responses, by error code.");
+        for (const auto& entry : snapshot["errors"]["by_code"]) {
+            out << "shader_translator_errors_total{code=\"" << entry["code"].get<int>() << '"';
+            if (entry.contains("name")) {
+                out << ",name=\"" << escape(entry["name"].get<std::string>()) << '"';
+            }
+            out << "} " << entry["count"] << '\n';
+        }
+
+        header("shader_translator_request_duration_seconds", "histogram", "JSON-RPC request latency, by method.");
+        for (const auto& [method, histogram] : snapshot["latency_us"].items()) {
+            const std::string labels = "method=\"" + escape(method) + "\"";
+            for (const auto& bucket : histogram["buckets"]) {
+                out << "shader_translator_request_duration_seconds_bucket{" << labels << ",le=\""
+                    << bucket["le"].get<uint64_t>() / 1e6 << "\"} " << bucket["count"] << '\n';
+            }
+            out << "shader_translator_request_duration_seconds_bucket{" << labels << ",le=\"+Inf\"} "
+                << histogram["count"] << '\n';
+            out << "shader_translator_request_duration_seconds_sum{" << labels << "} "
+                << histogram["sum"].get<uint64_t>() / 1e6 << '\n';
+            out << "shader_translator_request_duration_seconds_count{" << labels << "} " << histogram["count"] << '\n';
+        }
+
+        for (const char* cache : {"result_cache", "compiler_cache", "disk_cache"}) {
+            if (!snapshot.contains(cache)) {
+                continue;
+            }
+            for (const auto& [field, value] : snapshot[cache].items()) {
+                if (!value.is_number()) {
+                    continue;
+                }
+                const bool counter = field == "hits" || field == "misses" || field == "evictions" ||
+                                     field == "disk_hits" || field == "writes";
+                const std::string name = std::string("shader_translator_") + cache + "_" + field + (counter ? "_total" : "");
+                out << "# TYPE " << name << (counter ? " counter\n" : " gauge\n") << name << ' ' << value << '\n';
+            }
+        }
+
+        if (snapshot.contains("memory")) {
+            header("shader_translator_process_memory_bytes", "gauge",
+                   "Resident set size, or linear memory size under WASM.");
+            out << "shader_translator_process_memory_bytes "
+                << snapshot["memory"]["process_kb"].get<uint64_t>() * 1024 << '\n';
+            if (snapshot["memory"].contains("high_water_kb")) {
+                header("shader_translator_process_memory_high_water_bytes", "gauge",
+                       "Highest memory use seen at the end of a request.");
+                out << "shader_translator_process_memory_high_water_bytes "
+                    << snapshot["memory"]["high_water_kb"].get<uint64_t>() * 1024 << '\n';
+            }
+        }
+
+        if (snapshot.contains("sessions")) {
+            header("shader_translator_open_sessions", "gauge", "Live-editing sessions currently open.");
+            out << "shader_translator_open_sessions " << snapshot["sessions"] << '\n';
+        }
+        return out.str();
+    }
+
+private:
+    struct Histogram {
+        std::array<unsigned long long, kLatencyBucketsUs.size() + 1> counts{};
+        unsigned long long count = 0;
+        unsigned long long sum_us = 0;
+        unsigned long long max_us = 0;
+
+        // Estimates a quantile by interpolating inside the bucket that holds it.
+        // The overflow bucket reports the slowest request seen.
+        double percentile(double q) const {
+            if (count == 0) {
+                return 0.0;
+            }
+            const double rank = q * static_cast<double>(count);
+            unsigned long long cumulative = 0;
+            for (size_t i = 0; i < kLatencyBucketsUs.size(); ++i) {
+                if (counts[i] && static_cast<double>(cumulative + counts[i]) >= rank) {
+                    const double lower = i ? static_cast<double>(kLatencyBucketsUs[i - 1]) : 0.0;
+                    const double upper = static_cast<double>(std::min<unsigned long long>(kLatencyBucketsUs[i], max_us));
+                    const double fraction = (rank - static_cast<double>(cumulative)) / static_cast<double>(counts[i]);
+                    return lower + (std::max(upper, lower) - lower) * fraction;
+                }
+                cumulative += counts[i];
+            }
+            return static_cast<double>(max_us);
+        }
+    };
+
+    static size_t bucket_index(uint64_t latency_us) {
+        size_t i = 0;
+        while (i < kLatencyBucketsUs.size() && latency_us > kLatencyBucketsUs[i]) {
+            ++i;
+        }
+        return i;
+    }
+
+    // Returns key, or a catch-all key once the map holds kMaxLabelValues entries.
+    template <typename Map>
+    static typename Map::key_type capped(const Map& map, const typename Map::key_type& key) {
+        if (map.size() < kMaxLabelValues || map.count(key)) {
+            return key;
+        }
+        return other_key(key);
+    }
+    static std::string other_key(const std::string&) { return "other"; }
+    static std::pair<std::string, std::string> other_key(const std::pair<std::string, std::string>&) {
+        return {"other", "other"};
+    }
+
+    static std::string escape(const std::string& value) {
+        std::string escaped;
+        for (char c : value) {
+            if (c == '\\' || c == '"') {
+                escaped += '\\';
+                escaped += c;
+            } else if (c == '\n') {
+                escaped += "\\n";
+            } else {
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+
+    mutable std::mutex mutex_;
+    std::chrono::steady_clock::time_point start_;
+    std::map<std::string, Histogram> latency_;
+    std::map<std::pair<std::string, std::string>, unsigned long long> translations_;
+    std::map<int, unsigned long long> errors_;
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "GLSLANG/ShaderLang.h"
+#include "compiler/preprocessor/Preprocessor.h"
+#include "compiler/preprocessor/Token.h"
+#include "compiler/translator/Diagnostics.h"
+#include "compiler/translator/DirectiveHandler.h"
+#include "compiler/translator/ExtensionBehavior.h"
+#include "compiler/translator/InfoSink.h"
+#include "xxhash.h"
+
+// Runs only ANGLE's preprocessor over a source, set up as sh::Compile sets it
+// up (the same extension and GL_FRAGMENT_PRECISION_HIGH macros, and the
+// translator's own directive handler), and returns the token stream the
+// parser would see. Two sources with equal streams translate alike under the
+// same options, whatever their comments, whitespace or macro spellings.
+//
+// text holds the tokens separated by single spaces, with each #version,
+// #extension and #pragma (the directives that reach the compiler) on a line
+// of its own where it occurred. tokens hashes text. lines hashes the line
+// numbers of the tokens: diagnostics carry them, so a result whose info log
+// is not empty only applies to sources whose lines match as well.
+struct PreprocessedShader {
+    std::string text;
+    XXH64_hash_t tokens = 0;
+    XXH64_hash_t lines = 0;
+    size_t token_count = 0;
+    std::string info_log; // Preprocessor diagnostics, in the compiler's format
+
+    // Returns false, with the errors in info_log, if the source does not
+    // preprocess; sh::Compile would then fail too.
+    static bool Run(const std::string& source, sh::GLenum shaderType, ShShaderSpec spec,
+                    const ShBuiltInResources& resources, PreprocessedShader* out) {
+        out->text.clear();
+        out->token_count = 0;
+        thread_local std::vector<int> token_lines;
+        token_lines.clear();
+
+        sh::TInfoSinkBase info_sink;
+        sh::TDiagnostics diagnostics(info_sink);
+        sh::TExtensionBehavior extension_behavior;
+        sh::InitExtensionBehavior(resources, extension_behavior);
+        int shader_version = 100;
+        RecordingDirectiveHandler directive_handler(extension_behavior, diagnostics, shader_version, shaderType, &out->text);
+
+        angle::pp::Preprocessor preprocessor(&diagnostics, &directive_handler, angle::pp::PreprocessorSettings(spec));
+        const char* strings[] = {source.c_str()};
+        const int lengths[] = {static_cast<int>(source.size())};
+        if (!preprocessor.init(1, strings, lengths)) {
+            return false;
+        }
+        const bool webgl = spec == SH_WEBGL_SPEC || spec == SH_WEBGL2_SPEC || spec == SH_WEBGL3_SPEC;
+        for (size_t i = 0; i < static_cast<size_t>(sh::TExtension::EnumCount); ++i) {
+            const sh::TExtension extension = static_cast<sh::TExtension>(i);
+            if (extension_behavior[extension] == sh::EBhUndefined ||
+                (webgl && extension == sh::TExtension::OVR_multiview)) {
+                continue;
+            }
+            preprocessor.predefineMacro(sh::GetExtensionNameString(extension), 1);
+        }
+        if (resources.FragmentPrecisionHigh == 1) {
+            preprocessor.predefineMacro("GL_FRAGMENT_PRECISION_HIGH", 1);
+        }
+
+        angle::pp::Token token;
+        for (preprocessor.lex(&token); token.type != angle::pp::Token::LAST; preprocessor.lex(&token)) {
+            if (!out->text.empty() && out->text.back() != '\n') {
+                out->text += ' ';
+            }
+            out->text += token.text;
+            token_lines.push_back(token.location.file);
+            token_lines.push_back(token.location.line);
+            ++out->token_count;
+        }
+
+        out->info_log = info_sink.str();
+        out->tokens = XXH64(out->text.data(), out->text.size(), 0);
+        out->lines = XXH64(token_lines.data(), token_lines.size() * sizeof(token_lines[0]), 0);
+        return diagnostics.numErrors() == 0;
+    }
+
+private:
+    // The translator's directive handler, which validates #version and
+    // #extension as sh::Compile would, also writing the directives out.
+    class RecordingDirectiveHandler : public sh::TDirectiveHandler {
+    public:
+        RecordingDirectiveHandler(sh::TExtensionBehavior& extension_behavior, sh::TDiagnostics& diagnostics,
+                                  int& shader_version, sh::GLenum shaderType, std::string* text)
+            : sh::TDirectiveHandler(extension_behavior, diagnostics, shader_version, shaderType), text_(*text) {}
+
+        void handlePragma(const angle::pp::SourceLocation& loc, const std::string& name, const std::string& value,
+                          bool stdgl) override {
+            line(std::string("#pragma ") + (stdgl ? "STDGL " : "") + name + (value.empty() ? "" : "(" + value + ")"));
+            sh::TDirectiveHandler::handlePragma(loc, name, value, stdgl);
+        }
+        void handleExtension(const angle::pp::SourceLocation& loc, const std::string& name,
+                             const std::string& behavior) override {
+            line("#extension " + name + " : " + behavior);
+            sh::TDirectiveHandler::handleExtension(loc, name, behavior);
+        }
+        void handleVersion(const angle::pp::SourceLocation& loc, int version, ShShaderSpec spec,
+                           angle::pp::MacroSet* macro_set) override {
+            line("#version " + std::to_string(version));
+            sh::TDirectiveHandler::handleVersion(loc, version, spec, macro_set);
+        }
+
+    private:
+        void line(const std::string& directive) {
+            if (!text_.empty() && text_.back() != '\n') {
+                text_ += '\n';
+            }
+            text_ += directive;
+            text_ += '\n';
+        }
+
+        std::string& text_;
+    };
+};
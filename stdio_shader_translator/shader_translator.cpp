@@ -11,17 +11,47 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
 #include <sstream>
 #include <vector>
 #include "angle_gl.h"
 
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#if !defined(__EMSCRIPTEN__)
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <thread>
+#endif
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#include "active_variables.hpp"
 #include "base64.hpp"
+#include "common/system_utils.h"
+#include "compiler_cache.hpp"
 #include "json.hpp"
+#include "json_rpc_stream.hpp"
+#include "json_writer.hpp"
+#include "memory_watermark.hpp"
+#include "reflection_blob.hpp"
+#include "result_cache.hpp"
+#include "server_stats.hpp"
+#include "shader_preprocessor.hpp"
+#include "source_fingerprint.hpp"
+#include "varying_pruner.hpp"
 using json = nlohmann::json;
 using namespace base64;
 
-#if defined(ANGLE_ENABLE_VULKAN)
+#if defined(ANGLE_ENABLE_VULKAN) && defined(ANGLE_TRANSLATOR_SPIRV_TOOLS)
 // SPIR-V tools include for disassembly.
 #    include <spirv-tools/libspirv.hpp>
 #endif
@@ -40,6 +70,9 @@ enum TFailCode
     EFailJSONRPCMethodNotFound = -32601,
     EFailJSONRPCInvalidParams = -32602,
     EFailJSONRPCInternalError = -32603,
+    EFailJSONRPCRequestTimeout = -32001,   // Server-defined; see JsonRpcWorkerPool
+    EFailJSONRPCBackendUnavailable = -32002, // Server-defined; see OutputBackendBuiltIn
+    EFailJSONRPCRequestCancelled = -32800, // As in the Language Server Protocol
 };
 
 static void usage();
@@ -54,8 +87,7 @@ static sh::GLenum FindShaderTypeFromJson(const std::string &typeName);
 static bool ParseGLSLOutputVersion(const std::string &num, ShShaderOutput *outResult); // From original
 static bool ParseIntValue(const std::string &num, int emptyDefault, int *outValue); // From original
 static void PrintSpirvToBuffer(const sh::BinaryBlob &blob, std::string& out_buffer); // Modified for string output
-static json SerializeShaderVariable(const sh::ShaderVariable &var);
-static json SerializeActiveVariablesToJson(ShHandle compiler);
+static json SerializeActiveVariablesToJson(const ActiveVariableLists& lists, ActiveVariableMask mask);
 
 // jl - a simple null hash function to disable name mangling
 const khronos_uint64_t FNV_PRIME = 1099511628211ULL; // 2^40 + 2^8 + 0xB3
@@ -70,7 +102,7 @@ static khronos_uint64_t FNVHashFunction(const char *str, size_t len) {
 }
 
 // Modified version of PrintSpirv
-#if defined(ANGLE_ENABLE_VULKAN)
+#if defined(ANGLE_ENABLE_VULKAN) && defined(ANGLE_TRANSLATOR_SPIRV_TOOLS)
 #    include <spirv-tools/libspirv.hpp>
 void PrintSpirvToBuffer(const sh::BinaryBlob &blob, std::string& out_buffer) {
     spvtools::SpirvTools spirvTools(SPV_ENV_VULKAN_1_1);
@@ -80,7 +112,7 @@ void PrintSpirvToBuffer(const sh::BinaryBlob &blob, std::string& out_buffer) {
 }
 #else
 void PrintSpirvToBuffer(const sh::BinaryBlob &blob, std::string& out_buffer) {
-    out_buffer = "SPIR-V disassembly not available (ANGLE_ENABLE_VULKAN not defined).";
+    out_buffer = "SPIR-V disassembly not available (built without SPIRV-Tools).";
 }
 #endif
 
@@ -95,148 +127,141 @@ static sh::GLenum FindShaderTypeFromJson(const std::string &typeName) {
     return GL_NONE; // Indicate error or unknown
 }
 
-static json SerializeShaderVariable(const sh::ShaderVariable &var) {
-    json jvar;
-    jvar["name"] = var.name;
-    jvar["mapped_name"] = var.mappedName;
-    jvar["type_enum"] = var.type; // Consider mapping to string for readability
-    jvar["precision_enum"] = var.precision; // Consider mapping to string
-
-    // Add other relevant fields from sh::ShaderVariable
-    // For example, check ANGLE's sh_structs.h for exact field names like:
-    jvar["static_use"] = var.staticUse;
-    jvar["active"] = var.active;
-    if (var.location != -1) { // -1 often indicates no explicit location
-        jvar["location"] = var.location;
+// The writers below emit keys in sorted order, so the text is exactly what
+// dumping the equivalent nlohmann::json tree would produce.
+static void WriteShaderVariable(JsonWriter& writer, const sh::ShaderVariable &var) {
+    writer.begin_object();
+    writer.key("active");
+    writer.value(var.active);
+    if (!var.arraySizes.empty()) {
+        writer.key("array_sizes");
+        writer.array(var.arraySizes);
     }
     if (var.binding != -1) { // For samplers, images, UBO members with binding
-        jvar["binding"] = var.binding;
+        writer.key("binding");
+        writer.value(var.binding);
     }
-    if (var.offset != -1) { // For UBO members with offset
-        jvar["offset"] = var.offset;
+    if (!var.fields.empty()) { // If the ShaderVariable itself is a struct
+        writer.key("fields");
+        writer.begin_array();
+        for (const auto& field : var.fields) {
+            WriteShaderVariable(writer, field); // Recursive call
+        }
+        writer.end_array();
     }
-     jvar["is_row_major"] = var.isRowMajorLayout;
-
-
-    if (!var.arraySizes.empty()) {
-        jvar["array_sizes"] = var.arraySizes;
+    writer.key("is_row_major");
+    writer.value(var.isRowMajorLayout);
+    if (var.location != -1) { // -1 often indicates no explicit location
+        writer.key("location");
+        writer.value(var.location);
+    }
+    writer.key("mapped_name");
+    writer.value(var.mappedName);
+    writer.key("name");
+    writer.value(var.name);
+    if (var.offset != -1) { // For UBO members with offset
+        writer.key("offset");
+        writer.value(var.offset);
     }
+    writer.key("precision_enum");
+    writer.value(var.precision); // Consider mapping to string
+    writer.key("static_use");
+    writer.value(var.staticUse);
     // Use structOrBlockName (structName is deprecated in some ANGLE versions)
     if (!var.structOrBlockName.empty()) {
-        jvar["struct_or_block_name"] = var.structOrBlockName;
-    }
-
-    if (!var.fields.empty()) { // If the ShaderVariable itself is a struct
-        json jfields = json::array();
-        for (const auto& field : var.fields) {
-            jfields.push_back(SerializeShaderVariable(field)); // Recursive call
-        }
-        jvar["fields"] = jfields;
+        writer.key("struct_or_block_name");
+        writer.value(var.structOrBlockName);
     }
-    return jvar;
+    writer.key("type_enum");
+    writer.value(var.type); // Consider mapping to string for readability
+    writer.end_object();
 }
 
-// New helper function to serialize an sh::InterfaceBlock
+// Writes an sh::InterfaceBlock
 // (also usable for UniformBlocks and ShaderStorageBufferBlocks as they are typedefs)
-static json SerializeInterfaceBlock(const sh::InterfaceBlock& block) {
-    json jBlock;
-    jBlock["name"] = block.name;                 // e.g., "MyUniforms"
-    jBlock["mapped_name"] = block.mappedName;
-    if (!block.instanceName.empty()) {           // e.g., "myUniformsInstance" (if an instance is named)
-        jBlock["instance_name"] = block.instanceName;
-    }
-    // arraySize for blocks (0 or 1 typically means not an array of blocks, or an implicit array of size 1)
-    // Check sh_structs.h for how arraySize is used for blocks. If it's an array of blocks, this will be > 0.
-    if (block.arraySize > 0) { // Or block.arraySize > 1 depending on convention
-        jBlock["array_size"] = block.arraySize;
-    }
-
-    // Layout: sh::BlockLayoutType (enum class: kShared, kPacked, kStd140, kStd430)
-    // You'll want to convert this enum to a string or use its integer value.
-    // Example: static_cast<int>(block.layout)
-    std::string layoutStr = "unknown";
+static void WriteInterfaceBlock(JsonWriter& writer, const sh::InterfaceBlock& block) {
+    const char* layout = "unknown";
     switch (block.layout) {
-        case sh::BlockLayoutType::BLOCKLAYOUT_SHARED: layoutStr = "shared"; break;
-        case sh::BlockLayoutType::BLOCKLAYOUT_PACKED: layoutStr = "packed"; break;
-        case sh::BlockLayoutType::BLOCKLAYOUT_STD140: layoutStr = "std140"; break;
-        case sh::BlockLayoutType::BLOCKLAYOUT_STD430: layoutStr = "std430"; break;
+        case sh::BlockLayoutType::BLOCKLAYOUT_SHARED: layout = "shared"; break;
+        case sh::BlockLayoutType::BLOCKLAYOUT_PACKED: layout = "packed"; break;
+        case sh::BlockLayoutType::BLOCKLAYOUT_STD140: layout = "std140"; break;
+        case sh::BlockLayoutType::BLOCKLAYOUT_STD430: layout = "std430"; break;
         default: break;
     }
-    jBlock["layout"] = layoutStr;
 
+    writer.begin_object();
+    writer.key("active");
+    writer.value(block.active);
+    // arraySize for blocks (0 or 1 typically means not an array of blocks, or an implicit array of size 1)
+    if (block.arraySize > 0) {
+        writer.key("array_size");
+        writer.value(block.arraySize);
+    }
     if (block.binding != -1) { // -1 means no explicit binding
-        jBlock["binding"] = block.binding;
+        writer.key("binding");
+        writer.value(block.binding);
     }
-    jBlock["static_use"] = block.staticUse;
-    jBlock["active"] = block.active;
-    jBlock["is_row_major_layout"] = block.isRowMajorLayout; // For matrix packing within the block
-
-    // Serialize the member variables (fields) of the block
-    json jfields = json::array();
+    // The member variables (fields) of the block
+    writer.key("fields");
+    writer.begin_array();
     for (const auto& field_var : block.fields) {
-        jfields.push_back(SerializeShaderVariable(field_var)); // Use the existing variable serializer
+        WriteShaderVariable(writer, field_var);
     }
-    jBlock["fields"] = jfields;
-
-    return jBlock;
+    writer.end_array();
+    if (!block.instanceName.empty()) { // e.g., "myUniformsInstance" (if an instance is named)
+        writer.key("instance_name");
+        writer.value(block.instanceName);
+    }
+    writer.key("is_row_major_layout");
+    writer.value(block.isRowMajorLayout); // For matrix packing within the block
+    writer.key("layout");
+    writer.value(layout);
+    writer.key("mapped_name");
+    writer.value(block.mappedName);
+    writer.key("name");
+    writer.value(block.name); // e.g., "MyUniforms"
+    writer.key("static_use");
+    writer.value(block.staticUse);
+    writer.end_object();
 }
 
-// Updated definition for SerializeActiveVariablesToJson
-static json SerializeActiveVariablesToJson(ShHandle compiler) {
-    json jroot;
-
-    // Lambda for processing lists of simple sh::ShaderVariable (attributes, varyings, standalone uniforms)
-    auto process_shader_variable_list = [&](const std::string& key, const std::vector<sh::ShaderVariable>* vars_vec) {
-        if (vars_vec != nullptr) { // Always check for nullptr from ANGLE API
-            json jlist = json::array();
-            for (const auto& var : *vars_vec) {
-                jlist.push_back(SerializeShaderVariable(var));
-            }
-            jroot[key] = jlist;
-        } else {
-            jroot[key] = json::array(); // Represent as empty list if ANGLE returns null
+template <typename Item, typename WriteItem>
+static void WriteActiveVariableList(JsonWriter& writer, const char* key, const std::vector<Item>* items,
+                                    WriteItem write_item) {
+    writer.key(key);
+    writer.begin_array();
+    if (items != nullptr) { // Always check for nullptr from ANGLE API; null is written as an empty list
+        for (const auto& item : *items) {
+            write_item(writer, item);
         }
-    };
+    }
+    writer.end_array();
+}
 
-    // Lambda for processing lists of sh::InterfaceBlock (used for UBOs, SSBOs)
-    auto process_interface_block_list = [&](const std::string& key, const std::vector<sh::InterfaceBlock>* blocks_vec) {
-        if (blocks_vec != nullptr) { // Always check for nullptr
-            json jlist = json::array();
-            for (const auto& block : *blocks_vec) {
-                jlist.push_back(SerializeInterfaceBlock(block));
-            }
-            jroot[key] = jlist;
+// Serializes the lists selected by mask straight to JSON text, without
+// building an nlohmann::json node per field. The text is reused through a
+// per-thread buffer and returned wrapped by JsonWriter::RawJson(), so the
+// payload it ends up in must be written with JsonWriter::Dump().
+static json SerializeActiveVariablesToJson(const ActiveVariableLists& lists, ActiveVariableMask mask) {
+    thread_local std::string buffer;
+    buffer.clear();
+    JsonWriter writer(&buffer);
+
+    writer.begin_object();
+    // The names are sorted, so the keys come out in order.
+    for (int i = 0; i < kActiveVariableListCount; ++i) {
+        if (!(mask & (1u << i))) {
+            continue;
+        }
+        if (IsBlockList(i)) {
+            WriteActiveVariableList(writer, kActiveVariableListNames[i], lists.blocks[i], WriteInterfaceBlock);
         } else {
-            jroot[key] = json::array();
+            WriteActiveVariableList(writer, kActiveVariableListNames[i], lists.variables[i], WriteShaderVariable);
         }
-    };
-
-    process_shader_variable_list("attributes", sh::GetAttributes(compiler));
-    process_shader_variable_list("input_varyings", sh::GetInputVaryings(compiler));
-    process_shader_variable_list("output_varyings", sh::GetOutputVaryings(compiler));
-    process_shader_variable_list("output_variables", sh::GetOutputVariables(compiler)); // For fragment shader outputs
-    process_shader_variable_list("uniforms", sh::GetUniforms(compiler)); // These are standalone uniforms (samplers, basic types not in blocks)
-
-    // Uniform Blocks (UBOs) are sh::InterfaceBlock
-    process_interface_block_list("uniform_blocks", sh::GetUniformBlocks(compiler));
-
-    // Shader Storage Buffer Blocks (SSBOs) are also sh::InterfaceBlock
-    process_interface_block_list("shader_storage_buffer_blocks", sh::GetShaderStorageBlocks(compiler));
-
-    // sh::GetInterfaceBlocks(compiler) can sometimes be a more generic list or include
-    // other types of interface blocks if ANGLE's API distinguishes them further.
-    // If it's redundant with UBOs/SSBOs and they are already covered, you might not need this,
-    // or you might want to see what it contains. For now, let's include it.
-    // If it's the same underlying type (sh::InterfaceBlock), this lambda is appropriate.
-    process_interface_block_list("generic_interface_blocks", sh::GetInterfaceBlocks(compiler));
-
-
-    // Example: If ANGLE provides separate atomic counter buffer info (if not already in uniforms)
-    // const std::vector<sh::AtomicCounterBuffer>* atomic_counters = sh::GetAtomicCounterBuffers(compiler);
-    // if (atomic_counters) { ... serialize them ... }
-
+    }
+    writer.end_object();
 
-    return jroot;
+    return JsonWriter::RawJson(buffer);
 }
 
 // Helper to create a JSON RPC error object for our return values
@@ -251,34 +276,81 @@ static json make_json_error_payload(int code, const std::string& message, const
     return error_payload;
 }
 
-// Modified handle_translate_request
-// Returns:
-// - On success: a json object representing the "result" field of the JSON-RPC response.
-// - On failure: a json object representing the "error" field (with "code", "message").
-json handle_translate_request(const json& params) {
-    ShCompileOptions compileOptions = {};
+// Translation settings that apply to every source compiled with them:
+// everything in a translate request apart from the source and shader type.
+struct TranslateOptions {
+    ShShaderSpec spec;
+    ShShaderOutput output;
+    ShCompileOptions compileOptions;
     ShBuiltInResources resources;
-    GenerateResources(&resources); // Initialize with defaults
-
-    sh::GLenum shaderType = GL_NONE;
-    ShShaderSpec spec = SH_GLES2_SPEC;
-    ShShaderOutput output = SH_ESSL_OUTPUT;
-    std::string shader_source_decoded;
-    bool print_active_vars = false;
+    bool printActiveVariables;
+    bool binaryReflection; // 'reflection_format': "binary"; see ReflectionBlobWriter
+    ActiveVariableMask reflectLists; // 'reflect': the lists active_variables includes
+    bool keepReflection;   // 'keep_reflection': snapshot the lists for get_reflection
+    int optimizeLevel;
+    uint32_t optimizePasses; // Bit i set if kOptimizationPasses[i] was applied
+    ShCompileOptions unoptimizedCompileOptions; // compileOptions before the 'optimize' passes
+};
 
-    // --- Parameter Extraction and Validation ---
+// The passes behind the 'optimize' level, in the order they are applied. Each
+// turns on ANGLE's own transformations through ShCompileOptions, so the
+// object code stays what sh::Compile produces. A pass whose compile option
+// the request sets explicitly in 'compile_options' leaves it alone.
+struct OptimizationPass {
+    const char* name;
+    int level;                 // Lowest 'optimize' level that runs the pass
+    const char* compile_option; // Key in 'compile_options' that overrides it, or nullptr
+    void (*apply)(ShCompileOptions* compileOptions);
+};
 
-    // 1. Shader Code Base64
-    if (!params.contains("shader_code_base64")) {
-        return make_json_error_payload(EFailJSONRPCInvalidParams, "Missing 'shader_code_base64' parameter.");
+static const OptimizationPass kOptimizationPasses[] = {
+    // Drops declarations of uniforms, varyings and blocks no code path uses
+    {"remove_inactive_variables", 1, nullptr, [](ShCompileOptions* o) { o->removeInactiveVariables = true; }},
+};
+// Only passes that keep WebGL's guarantees belong here, so e.g.
+// initializeUninitializedLocals stays as the request set it. A level is
+// accepted once it has a pass of its own.
+static constexpr int kMaxOptimizeLevel = 1;
+
+// Parses the shader source: 'shader_code', or 'shader_code_base64' for clients
+// that need an ASCII-safe transport.
+// *shader_source points either into params or into *decoded_storage, so params
+// must outlive it. Returns a null json on success, or an "error" payload.
+static json ParseShaderCode(const json& params, std::string* decoded_storage, const std::string** shader_source) {
+    // 1. Shader Code (plain UTF-8) or Shader Code Base64
+    const bool has_plain = params.contains("shader_code");
+    const bool has_base64 = params.contains("shader_code_base64");
+    if (has_plain == has_base64) {
+        return make_json_error_payload(EFailJSONRPCInvalidParams, has_plain
+            ? "Specify only one of 'shader_code' and 'shader_code_base64'."
+            : "Missing 'shader_code' or 'shader_code_base64' parameter.");
     }
-    if (!params["shader_code_base64"].is_string()) {
-        return make_json_error_payload(EFailJSONRPCInvalidParams, "'shader_code_base64' parameter must be a string.");
+    if (has_plain) {
+        if (!params["shader_code"].is_string()) {
+            return make_json_error_payload(EFailJSONRPCInvalidParams, "'shader_code' parameter must be a string.");
+        }
+        // JSON strings are already unescaped UTF-8, so use the parsed string in place.
+        *shader_source = &params["shader_code"].get_ref<const std::string&>();
+    } else {
+        if (!params["shader_code_base64"].is_string()) {
+            return make_json_error_payload(EFailJSONRPCInvalidParams, "'shader_code_base64' parameter must be a string.");
+        }
+        const std::string& shader_source_base64_str = params["shader_code_base64"].get_ref<const std::string&>();
+        decode_into(shader_source_base64_str, *decoded_storage);
+        if (decoded_storage->empty() && !shader_source_base64_str.empty()) {
+            return make_json_error_payload(EFailJSONRPCInvalidParams, "Failed to decode 'shader_code_base64'.");
+        }
+        *shader_source = decoded_storage;
     }
-    std::string shader_source_base64_str = params["shader_code_base64"].get<std::string>();
-    shader_source_decoded = base64_decode_to_string(shader_source_base64_str);
-    if (shader_source_decoded.empty() && !shader_source_base64_str.empty()) {
-        return make_json_error_payload(EFailJSONRPCInvalidParams, "Failed to decode 'shader_code_base64'.");
+    return nullptr;
+}
+
+// Parses the shader source as ParseShaderCode does, and 'shader_type'.
+static json ParseTranslateSource(const json& params, std::string* decoded_storage, const std::string** shader_source,
+                                 sh::GLenum* shaderType) {
+    json error_payload = ParseShaderCode(params, decoded_storage, shader_source);
+    if (!error_payload.is_null()) {
+        return error_payload;
     }
 
     // 2. Shader Type
@@ -289,10 +361,86 @@ json handle_translate_request(const json& params) {
         return make_json_error_payload(EFailJSONRPCInvalidParams, "'shader_type' parameter must be a string.");
     }
     std::string shader_type_str = params["shader_type"].get<std::string>();
-    shaderType = FindShaderTypeFromJson(shader_type_str);
-    if (shaderType == GL_NONE) {
+    *shaderType = FindShaderTypeFromJson(shader_type_str);
+    if (*shaderType == GL_NONE) {
         return make_json_error_payload(EFailJSONRPCInvalidParams, "Unsupported 'shader_type': " + shader_type_str);
     }
+    return nullptr;
+}
+
+// Parses the optional 'spec', 'output', 'compile_options', 'optimize',
+// 'resources', 'print_active_variables', 'reflection_format', 'reflect' and
+// 'keep_reflection' parameters into options.
+// Returns a null json on success, or an "error" payload.
+// The CMake build makes one module per group of backends (see
+// add_translator_variant), so an output may be valid and still missing here.
+static bool OutputBackendBuiltIn(ShShaderOutput output) {
+    switch (output) {
+        case SH_ESSL_OUTPUT:
+#if defined(ANGLE_ENABLE_ESSL)
+            return true;
+#else
+            return false;
+#endif
+        case SH_SPIRV_VULKAN_OUTPUT:
+#if defined(ANGLE_ENABLE_VULKAN)
+            return true;
+#else
+            return false;
+#endif
+        case SH_HLSL_3_0_OUTPUT:
+        case SH_HLSL_4_1_OUTPUT:
+#if defined(ANGLE_ENABLE_HLSL)
+            return true;
+#else
+            return false;
+#endif
+        case SH_MSL_METAL_OUTPUT:
+#if defined(ANGLE_ENABLE_METAL)
+            return true;
+#else
+            return false;
+#endif
+        default: // The GLSL versions
+#if defined(ANGLE_ENABLE_GLSL)
+            return true;
+#else
+            return false;
+#endif
+    }
+}
+
+// Parses a list name or array of list names (kActiveVariableListNames) into *mask.
+static json ParseReflectMask(const json& names, const char* key, ActiveVariableMask* mask) {
+    const json list = names.is_string() ? json::array({names}) : names;
+    if (!list.is_array()) {
+        return make_json_error_payload(EFailJSONRPCInvalidParams, std::string("'") + key + "' must be a list name or an array of them.");
+    }
+    *mask = 0;
+    for (const auto& name : list) {
+        const int index = name.is_string() ? FindActiveVariableList(name.get_ref<const std::string&>()) : -1;
+        if (index < 0) {
+            return make_json_error_payload(EFailJSONRPCInvalidParams,
+                                           std::string("Unknown active variable list in '") + key + "': " + name.dump());
+        }
+        *mask |= static_cast<ActiveVariableMask>(1u << index);
+    }
+    return nullptr;
+}
+
+static json ParseTranslateOptions(const json& params, TranslateOptions* options) {
+    memset(options, 0, sizeof(*options)); // Padding must be deterministic for result cache hashing
+    ShCompileOptions& compileOptions = options->compileOptions;
+    ShBuiltInResources& resources = options->resources;
+    ShShaderSpec& spec = options->spec;
+    ShShaderOutput& output = options->output;
+    bool& print_active_vars = options->printActiveVariables;
+
+    GenerateResources(&resources); // Initialize with defaults
+    spec = SH_GLES2_SPEC;
+    output = SH_ESSL_OUTPUT;
+    print_active_vars = false;
+    options->reflectLists = kDefaultActiveVariableLists;
 
     // 3. Spec (Optional, defaults to GLES2_SPEC)
     if (params.contains("spec")) {
@@ -360,6 +508,12 @@ json handle_translate_request(const json& params) {
         } else if (output_type_str == "msl") output = SH_MSL_METAL_OUTPUT;
         else return make_json_error_payload(EFailJSONRPCInvalidParams, "Unsupported 'output' type: " + output_type_str);
     }
+    if (!OutputBackendBuiltIn(output)) {
+        const std::string output_name = params.contains("output") ? params["output"].get<std::string>() : "essl";
+        return make_json_error_payload(EFailJSONRPCBackendUnavailable,
+                                       "Output '" + output_name + "' is not built into this translator module.",
+                                       json{{"output", output_name}});
+    }
     
     // 5. Compile Options (Optional)
     if (params.contains("compile_options")) {
@@ -377,6 +531,25 @@ json handle_translate_request(const json& params) {
          compileOptions.initializeUninitializedLocals = true;
     }
 
+    // 5b. Optimize level (Optional, defaults to 0: no passes)
+    options->unoptimizedCompileOptions = compileOptions;
+    if (params.contains("optimize")) {
+        if (!params["optimize"].is_number_unsigned() || params["optimize"].get<unsigned long long>() > kMaxOptimizeLevel) {
+            return make_json_error_payload(EFailJSONRPCInvalidParams,
+                                           "'optimize' must be an integer from 0 to " + std::to_string(kMaxOptimizeLevel) + ".");
+        }
+        options->optimizeLevel = params["optimize"].get<int>();
+        for (size_t i = 0; i < std::size(kOptimizationPasses); ++i) {
+            const OptimizationPass& pass = kOptimizationPasses[i];
+            const bool overridden = pass.compile_option && params.contains("compile_options") &&
+                                    params["compile_options"].contains(pass.compile_option);
+            if (pass.level <= options->optimizeLevel && !overridden) {
+                pass.apply(&compileOptions);
+                options->optimizePasses |= 1u << i;
+            }
+        }
+    }
+
     // 6. Resources (Optional)
     if (params.contains("resources")) {
         if (!params["resources"].is_object()) {
@@ -472,98 +645,2115 @@ json handle_translate_request(const json& params) {
     // }
 
 
-    // 7. print_active_variables (Optional)
-    if (params.contains("print_active_variables")) {
-        if(!params["print_active_variables"].is_boolean()){
-            return make_json_error_payload(EFailJSONRPCInvalidParams, "'print_active_variables' must be a boolean.");
+    // 7. print_active_variables (Optional)
+    if (params.contains("print_active_variables")) {
+        if(!params["print_active_variables"].is_boolean()){
+            return make_json_error_payload(EFailJSONRPCInvalidParams, "'print_active_variables' must be a boolean.");
+        }
+        print_active_vars = params["print_active_variables"].get<bool>();
+    }
+
+    // 8. reflection_format (Optional): how active variables are returned
+    if (params.contains("reflection_format")) {
+        const json& format = params["reflection_format"];
+        if (format == "binary") {
+            options->binaryReflection = true;
+        } else if (format != "json") {
+            return make_json_error_payload(EFailJSONRPCInvalidParams, "'reflection_format' must be \"json\" or \"binary\".");
+        }
+    }
+
+    // 9. reflect (Optional): names of the lists to return; implies print_active_variables
+    if (params.contains("reflect")) {
+        json error_payload = ParseReflectMask(params["reflect"], "reflect", &options->reflectLists);
+        if (!error_payload.is_null()) {
+            return error_payload;
+        }
+        if (!params.contains("print_active_variables")) {
+            print_active_vars = true;
+        }
+    }
+
+    // 10. keep_reflection (Optional)
+    if (params.contains("keep_reflection")) {
+        if (!params["keep_reflection"].is_boolean()) {
+            return make_json_error_payload(EFailJSONRPCInvalidParams, "'keep_reflection' must be a boolean.");
+        }
+        options->keepReflection = params["keep_reflection"].get<bool>();
+    }
+    return nullptr;
+}
+
+// Records wall-clock time per phase, in microseconds, into a "timings" object
+// when a request asks for "profile": true. Without a target it never reads the clock.
+class PhaseTimer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit PhaseTimer(json* timings) : timings_(timings) {
+        if (timings_) {
+            start_ = lap_start_ = Clock::now();
+        }
+    }
+
+    // Stores the time since the previous lap (or construction) under name.
+    void lap(const char* name) {
+        if (timings_) {
+            Clock::time_point now = Clock::now();
+            (*timings_)[name] = std::chrono::duration_cast<std::chrono::microseconds>(now - lap_start_).count();
+            lap_start_ = now;
+        }
+    }
+
+    // Stores the time since construction under name.
+    void total(const char* name) {
+        if (timings_) {
+            (*timings_)[name] = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start_).count();
+        }
+    }
+
+    json* timings() const { return timings_; }
+
+private:
+    json* timings_;
+    Clock::time_point start_;
+    Clock::time_point lap_start_;
+};
+
+// Whether ParseTranslateOptions accepts value, spelled this way, as "spec"
+// or "output". Only the canonical spellings count ("glsl330", not
+// "glsl0330"), so the set of labels stays fixed.
+static bool IsStatsLabelValue(const char* key, const std::string& value) {
+    if (strcmp(key, "spec") == 0) {
+        for (const char* spec : {"gles2", "gles3", "gles31", "gles32", "webgl", "webgl2", "webgl3", "webgln"}) {
+            if (value == spec) {
+                return true;
+            }
+        }
+        return false;
+    }
+    if (value == "essl" || value == "glsl" || value == "spirv" || value == "hlsl9" || value == "hlsl11" ||
+        value == "msl") {
+        return true;
+    }
+    ShShaderOutput output;
+    return value.size() == 7 && value.compare(0, 4, "glsl") == 0 && value[4] >= '1' && value[4] <= '9' &&
+           value.find_first_not_of("0123456789", 4) == std::string::npos &&
+           ParseGLSLOutputVersion(value.substr(4), &output);
+}
+
+// The translate methods take spec/output from params; label requests with
+// the values ParseTranslateOptions would use. A value it would reject is
+// labeled "invalid", so clients cannot add labels to the stats.
+static std::string StatsLabel(const json& params, const char* key, const char* default_value) {
+    if (!params.is_object() || !params.contains(key)) {
+        return default_value;
+    }
+    if (params[key].is_string() && IsStatsLabelValue(key, params[key].get_ref<const std::string&>())) {
+        return params[key].get<std::string>();
+    }
+    return "invalid";
+}
+
+// Validated options together with what can be derived from them up front:
+// the hash the result cache keys on and, for registered profiles, the id the
+// compiler cache keys on.
+//
+// options_hash covers the raw bytes of options, padding included, so copies
+// copy those bytes as they are; a member-wise copy of options may leave its
+// padding undefined, and a profile rehashed after one would miss the cache.
+struct TranslationProfile {
+    TranslateOptions options;
+    XXH64_hash_t options_hash;
+    uint32_t id;              // 0 unless registered with "register_profile"
+    std::string spec_label;   // Request labels for g_server_stats
+    std::string output_label;
+
+    TranslationProfile() = default;
+    TranslationProfile(const TranslationProfile& other) { *this = other; }
+    TranslationProfile& operator=(const TranslationProfile& other) {
+        memcpy(&options, &other.options, sizeof(options));
+        options_hash = other.options_hash;
+        id = other.id;
+        spec_label = other.spec_label;
+        output_label = other.output_label;
+        return *this;
+    }
+};
+
+static void HashTranslationProfile(TranslationProfile* profile) {
+    // The disk cache shares keys between processes, where the name hashing
+    // function has another address, so only hash whether one is set.
+    TranslateOptions options;
+    memcpy(&options, &profile->options, sizeof(options)); // Keeps padding
+    const bool hashes_names = options.resources.HashFunction != nullptr;
+    options.resources.HashFunction = nullptr;
+    profile->options_hash = XXH64(&options, sizeof(options), hashes_names ? 1 : 0);
+}
+
+// Profiles added by "register_profile". They are never removed, so the
+// pointers find() hands out stay valid for the life of the process, and
+// registering identical options twice returns the same id.
+//
+// Thread-safe: the registry is shared by every worker of the JSON-RPC server.
+class ProfileRegistry {
+public:
+    static constexpr size_t kMaxProfiles = 1024;
+
+    // Returns the profile's id, or 0 if the registry is full.
+    uint32_t add(const TranslationProfile& profile) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& existing : profiles_) {
+            if (existing->options_hash == profile.options_hash &&
+                memcmp(&existing->options, &profile.options, sizeof(TranslateOptions)) == 0) {
+                return existing->id;
+            }
+        }
+        if (profiles_.size() >= kMaxProfiles) {
+            return 0;
+        }
+        profiles_.push_back(std::make_unique<TranslationProfile>(profile));
+        profiles_.back()->id = static_cast<uint32_t>(profiles_.size());
+        return profiles_.back()->id;
+    }
+
+    const TranslationProfile* find(unsigned long long id) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return id >= 1 && id <= profiles_.size() ? profiles_[id - 1].get() : nullptr;
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return profiles_.size();
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<TranslationProfile>> profiles_;
+};
+
+static ProfileRegistry g_profile_registry;
+static ReflectionStore g_reflection_store;
+
+// Sets profile from a registered 'profile_id', or else parses the option keys
+// of params with ParseTranslateOptions. A registered profile may only be
+// combined with 'print_active_variables' and 'keep_reflection'. Returns a null json on success, or
+// an "error" payload.
+static json ResolveTranslateOptions(const json& params, TranslationProfile* profile) {
+    if (!params.contains("profile_id")) {
+        json error_payload = ParseTranslateOptions(params, &profile->options);
+        if (!error_payload.is_null()) {
+            return error_payload;
+        }
+        HashTranslationProfile(profile);
+        profile->id = 0;
+        return nullptr;
+    }
+
+    if (!params["profile_id"].is_number_unsigned()) {
+        return make_json_error_payload(EFailJSONRPCInvalidParams, "'profile_id' must be a non-negative integer.");
+    }
+    const TranslationProfile* registered = g_profile_registry.find(params["profile_id"].get<unsigned long long>());
+    if (!registered) {
+        return make_json_error_payload(EFailJSONRPCInvalidParams, "Unknown 'profile_id'; register it with register_profile first.");
+    }
+    for (const char* key : {"spec", "output", "compile_options", "resources", "optimize", "reflection_format", "reflect"}) {
+        if (params.contains(key)) {
+            return make_json_error_payload(EFailJSONRPCInvalidParams,
+                                           std::string("'profile_id' cannot be combined with '") + key + "'.");
+        }
+    }
+    *profile = *registered;
+    if (params.contains("print_active_variables")) {
+        if (!params["print_active_variables"].is_boolean()) {
+            return make_json_error_payload(EFailJSONRPCInvalidParams, "'print_active_variables' must be a boolean.");
+        }
+        const bool print_active_vars = params["print_active_variables"].get<bool>();
+        if (print_active_vars != profile->options.printActiveVariables) {
+            profile->options.printActiveVariables = print_active_vars;
+            HashTranslationProfile(profile); // The result payload differs, so must its cache key
+        }
+    }
+    if (params.contains("keep_reflection")) {
+        if (!params["keep_reflection"].is_boolean()) {
+            return make_json_error_payload(EFailJSONRPCInvalidParams, "'keep_reflection' must be a boolean.");
+        }
+        const bool keep_reflection = params["keep_reflection"].get<bool>();
+        if (keep_reflection != profile->options.keepReflection) {
+            profile->options.keepReflection = keep_reflection;
+            HashTranslationProfile(profile);
+        }
+    }
+    return nullptr;
+}
+
+// Handles "register_profile": takes the option keys of "translate" and
+// returns {"profile_id": N} for use in later translate requests.
+static json handle_register_profile_request(const json& params) {
+    if (params.contains("profile_id")) {
+        return make_json_error_payload(EFailJSONRPCInvalidParams, "register_profile does not take 'profile_id'.");
+    }
+    TranslationProfile profile;
+    json error_payload = ResolveTranslateOptions(params, &profile);
+    if (!error_payload.is_null()) {
+        return error_payload;
+    }
+    profile.spec_label = StatsLabel(params, "spec", "gles2");
+    profile.output_label = StatsLabel(params, "output", "essl");
+    const uint32_t id = g_profile_registry.add(profile);
+    if (id == 0) {
+        return make_json_error_payload(EFailJSONRPCInvalidParams, "Too many registered profiles.");
+    }
+    json result;
+    result["profile_id"] = id;
+    return result;
+}
+
+// Handles "get_reflection": {"handle": N} from a translate request with
+// "keep_reflection": true, plus an optional "kind" (a list name or array of
+// them, defaulting to every list) and "reflection_format". Returns
+// {"active_variables": {...}} or {"active_variables_base64": ...} with just
+// those lists, as the translate result would have held them.
+static json handle_get_reflection_request(const json& params) {
+    if (!params.contains("handle") || !params["handle"].is_number_unsigned()) {
+        return make_json_error_payload(EFailJSONRPCInvalidParams, "Missing 'handle' parameter or it is not a non-negative integer.");
+    }
+    ActiveVariableMask mask = kAllActiveVariableLists;
+    if (params.contains("kind")) {
+        json error_payload = ParseReflectMask(params["kind"], "kind", &mask);
+        if (!error_payload.is_null()) {
+            return error_payload;
+        }
+    }
+    std::string format = "json";
+    if (params.contains("reflection_format")) {
+        format = params["reflection_format"].is_string() ? params["reflection_format"].get<std::string>() : "";
+    }
+    if (format != "json" && format != "binary") {
+        return make_json_error_payload(EFailJSONRPCInvalidParams, "'reflection_format' must be \"json\" or \"binary\".");
+    }
+    const auto snapshot = g_reflection_store.find(params["handle"].get<uint64_t>());
+    if (!snapshot) {
+        return make_json_error_payload(EFailJSONRPCInvalidParams,
+                                       "Unknown or expired reflection 'handle'; translate again with 'keep_reflection'.");
+    }
+    json result;
+    if (format == "binary") {
+        result["active_variables_base64"] = base64_encode(ReflectionBlobWriter::Write(snapshot->lists(), mask));
+    } else {
+        result["active_variables"] = SerializeActiveVariablesToJson(snapshot->lists(), mask);
+    }
+    return result;
+}
+
+// Handles "preprocess": takes the params of "translate" and runs only the
+// preprocessor. Returns {"tokens": normalized token stream, "hash": its
+// 64-bit hash as 16 hex digits, "token_count": N, "info_log": diagnostics},
+// or an EFailCompile "error" payload with the info log if preprocessing fails.
+// Only 'spec' and 'resources' affect the result, but the hash is a key for
+// external caches only together with every option of the translation.
+static json handle_preprocess_request(const json& params) {
+    std::string decoded_storage;
+    const std::string* shader_source = nullptr;
+    sh::GLenum shaderType = GL_NONE;
+    json error_payload = ParseTranslateSource(params, &decoded_storage, &shader_source, &shaderType);
+    if (!error_payload.is_null()) {
+        return error_payload;
+    }
+    TranslationProfile profile;
+    error_payload = ResolveTranslateOptions(params, &profile);
+    if (!error_payload.is_null()) {
+        return error_payload;
+    }
+
+    PreprocessedShader preprocessed;
+    if (!PreprocessedShader::Run(*shader_source, shaderType, profile.options.spec, profile.options.resources, &preprocessed)) {
+        json error_data;
+        error_data["info_log"] = preprocessed.info_log;
+        return make_json_error_payload(EFailCompile, "Shader preprocessing failed.", error_data);
+    }
+    char hash_hex[17];
+    snprintf(hash_hex, sizeof(hash_hex), "%016llx", static_cast<unsigned long long>(preprocessed.tokens));
+    json result;
+    result["tokens"] = preprocessed.text;
+    result["hash"] = hash_hex;
+    result["token_count"] = preprocessed.token_count;
+    result["info_log"] = preprocessed.info_log;
+    return result;
+}
+
+static ResultCache::Key MakeResultCacheKey(const std::string& source, sh::GLenum shaderType, const TranslationProfile& profile) {
+    return ResultCache::make_key(source, XXH64(&shaderType, sizeof(shaderType), profile.options_hash));
+}
+
+// Key of a source by its preprocessed token stream, so sources that differ
+// only in comments, whitespace or macro spelling share an entry. Such entries
+// hold {"lines": PreprocessedShader::lines, "payload": ...}: a payload with a
+// non-empty info log is only reused when the token lines match too.
+static ResultCache::Key MakeCanonicalResultCacheKey(const PreprocessedShader& preprocessed, sh::GLenum shaderType,
+                                                    const TranslationProfile& profile) {
+    static const char kCanonicalKeySalt[] = "preprocessed";
+    const XXH64_hash_t params_hash = XXH64(kCanonicalKeySalt, sizeof(kCanonicalKeySalt),
+                                           XXH64(&shaderType, sizeof(shaderType), profile.options_hash));
+    return ResultCache::Key{preprocessed.tokens, params_hash, preprocessed.token_count};
+}
+
+// Compiles one source with already-validated options.
+// Compilers are taken from (and left in) the given cache instead of being
+// constructed and destroyed for every request. If a result cache is given,
+// identical requests are answered from it without calling sh::Compile. On a
+// miss the source is preprocessed and looked up again by its token stream
+// (see MakeCanonicalResultCacheKey), which costs a fraction of a compile.
+// If out_compiler is given it receives the compiler that still holds this
+// compile's output, or nullptr when the payload came from the result cache.
+// If timer has a target, per-phase timings and memory use are added to it.
+// Returns the "result" payload on success or the "error" payload on failure.
+static json TranslateSourceWithOptions(const std::string& shader_source_decoded, sh::GLenum shaderType,
+                                       const TranslationProfile& profile, CompilerCache& compilers, ResultCache* results,
+                                       ShHandle* out_compiler = nullptr, PhaseTimer* timer = nullptr) {
+    const TranslateOptions& options = profile.options;
+    PhaseTimer no_timer(nullptr);
+    if (!timer) {
+        timer = &no_timer;
+    }
+    if (out_compiler) {
+        *out_compiler = nullptr;
+    }
+    const ShShaderSpec spec = options.spec;
+    const ShShaderOutput output = options.output;
+    const ShCompileOptions& compileOptions = options.compileOptions;
+    const bool print_active_vars = options.printActiveVariables;
+
+    // --- Result Cache ---
+    // Entries are {"lines": ..., "payload": ...} under the canonical key, with
+    // the source's own key as an alias of it, or just {"payload": ...} under
+    // the source's key when there is no canonical entry to share.
+    ResultCache::Key cache_key = MakeResultCacheKey(shader_source_decoded, shaderType, profile);
+    PreprocessedShader preprocessed;
+    bool preprocessed_ok = false;
+    bool canonical_taken = false; // By a source whose info log does not fit this one's lines
+    if (results) {
+        // With keep_reflection a hit needs the snapshot of the compile that
+        // produced it; once that has expired, compile again. A canonical hit
+        // would have no snapshot to hand out either, so it is not looked for.
+        const uint64_t kept_handle = options.keepReflection ? g_reflection_store.find_key(cache_key) : 0;
+        json cached_entry;
+        const bool hit = results->lookup(cache_key, &cached_entry, /*count_miss=*/options.keepReflection,
+                                         [&](const json& entry) {
+            return entry.contains("payload") &&
+                   (!options.keepReflection || kept_handle || entry["payload"].contains("code"));
+        });
+        timer->lap("result_cache_lookup_us");
+        if (hit) {
+            if (timer->timings()) {
+                (*timer->timings())["result_cache_hit"] = true;
+            }
+            json cached_payload = std::move(cached_entry["payload"]);
+            if (kept_handle) {
+                cached_payload["reflection_handle"] = kept_handle;
+            }
+            return cached_payload;
+        }
+
+        if (!options.keepReflection) {
+            preprocessed_ok = PreprocessedShader::Run(shader_source_decoded, shaderType, spec, options.resources, &preprocessed);
+            if (!preprocessed_ok) {
+                results->record_miss();
+            }
+        }
+        if (preprocessed_ok) {
+            const ResultCache::Key canonical_key = MakeCanonicalResultCacheKey(preprocessed, shaderType, profile);
+            const bool canonical_hit = results->lookup(canonical_key, &cached_entry, true, [&](const json& entry) {
+                if (!entry.contains("payload")) {
+                    return false;
+                }
+                const json& payload = entry["payload"];
+                const json& log_holder = payload.contains("data") ? payload["data"] : payload; // Compile errors keep it in "data"
+                canonical_taken = entry.value("lines", json()) != preprocessed.lines &&
+                                  !log_holder.value("info_log", std::string()).empty();
+                return !canonical_taken;
+            });
+            if (canonical_hit) {
+                timer->lap("preprocess_us");
+                if (timer->timings()) {
+                    (*timer->timings())["result_cache_hit"] = true;
+                }
+                results->alias(cache_key, canonical_key);
+                return std::move(cached_entry["payload"]);
+            }
+        }
+        timer->lap("preprocess_us");
+    }
+
+    // --- Perform Compilation ---
+    const unsigned long long compiler_misses = compilers.misses();
+    ShHandle compiler = compilers.acquire(shaderType, spec, output, options.resources, profile.id);
+    timer->lap("construct_compiler_us");
+    if (!compiler) {
+        return make_json_error_payload(EFailCompilerCreate, "Failed to construct compiler.");
+    }
+
+    const uint64_t memory_before_compile_kb = timer->timings() ? angle::GetProcessMemoryUsageKB() : 0;
+    const char* shader_strings[] = { shader_source_decoded.c_str() };
+    bool compile_success = sh::Compile(compiler, shader_strings, 1, compileOptions);
+    timer->lap("compile_us");
+    if (json* timings = timer->timings()) {
+        // The pool allocator's pages come from the heap, so process growth
+        // across sh::Compile is what a compile's pool usage costs in practice.
+        // WASM linear memory never shrinks; growth there is the new high-water mark.
+        const uint64_t memory_after_compile_kb = angle::GetProcessMemoryUsageKB();
+        (*timings)["result_cache_hit"] = false;
+        (*timings)["compiler_cached"] = compilers.misses() == compiler_misses;
+        (*timings)["process_memory_kb"] = memory_after_compile_kb;
+        (*timings)["compile_memory_growth_kb"] =
+            memory_after_compile_kb > memory_before_compile_kb ? memory_after_compile_kb - memory_before_compile_kb : 0;
+    }
+    if (out_compiler) {
+        *out_compiler = compiler;
+    }
+
+    json result_payload; // This is the "result" field on success
+    result_payload["info_log"] = sh::GetInfoLog(compiler);
+    uint64_t reflection_handle = 0;
+
+    if (compile_success) {
+        if (compileOptions.objectCode) {
+            // Correctly handle binary vs. text output
+            if (output == SH_SPIRV_VULKAN_OUTPUT)
+            {
+                // For binary output, base64 encode it
+                const sh::BinaryBlob& blob = sh::GetObjectBinaryBlob(compiler);
+                // BinaryBlob is a vector of 32-bit words; encode all of its bytes.
+                result_payload["object_code_base64"] = (blob.data() && blob.size() > 0) ?
+                    base64_encode(reinterpret_cast<const unsigned char*>(blob.data()), blob.size() * sizeof(blob[0])) : "";
+            }
+            else
+            {
+                // For text output (ESSL, GLSL, HLSL), return the string directly
+                result_payload["object_code"] = sh::GetObjectCode(compiler);
+            }
+            timer->lap("get_object_code_us");
+        }
+        const ActiveVariableLists active_lists = ActiveVariableLists::FromCompiler(compiler);
+        if (print_active_vars && options.binaryReflection) {
+            const std::string blob = ReflectionBlobWriter::Write(active_lists, options.reflectLists);
+            result_payload["active_variables_base64"] = base64_encode(blob);
+            timer->lap("serialize_active_variables_us");
+        } else if (print_active_vars) {
+            result_payload["active_variables"] = SerializeActiveVariablesToJson(active_lists, options.reflectLists); // Ensure this doesn't throw
+            timer->lap("serialize_active_variables_us");
+        }
+        if (options.keepReflection) {
+            reflection_handle = g_reflection_store.add(cache_key, active_lists);
+        }
+    } else {
+        // Compilation failed
+        json error_data;
+        error_data["info_log"] = result_payload["info_log"]; // Reuse info_log
+        result_payload = make_json_error_payload(EFailCompile, "Shader compilation failed.", error_data);
+    }
+
+    // Compile failures are just as deterministic as successes, so cache both.
+    if (results) {
+        json entry;
+        entry["payload"] = result_payload;
+        if (preprocessed_ok && !canonical_taken) {
+            const ResultCache::Key canonical_key = MakeCanonicalResultCacheKey(preprocessed, shaderType, profile);
+            entry["lines"] = preprocessed.lines;
+            results->insert(canonical_key, entry);
+            results->alias(cache_key, canonical_key);
+        } else {
+            results->insert(cache_key, entry);
+        }
+    }
+    if (reflection_handle) {
+        result_payload["reflection_handle"] = reflection_handle; // Not cached: the snapshot may expire first
+    }
+    return result_payload;
+}
+
+// For "profile": true with an 'optimize' level: compiles the source again
+// with the level's passes added one at a time, and returns
+// [{"pass": name, "object_code_bytes": size after it, "bytes_delta": change}, ...]
+// starting from {"pass": "none"} for no passes. These compiles bypass the
+// result cache.
+static json MeasureOptimizationPasses(const std::string& source, sh::GLenum shaderType, const TranslationProfile& profile,
+                                      CompilerCache& compilers) {
+    TranslationProfile stage = profile;
+    ShCompileOptions& compileOptions = stage.options.compileOptions;
+    compileOptions = profile.options.unoptimizedCompileOptions;
+    json passes = json::array();
+    long long previous_bytes = -1;
+    auto measure = [&](const char* name) {
+        json payload = TranslateSourceWithOptions(source, shaderType, stage, compilers, nullptr);
+        const long long bytes = payload.contains("object_code")
+                                    ? static_cast<long long>(payload["object_code"].get_ref<const std::string&>().size())
+                                    : -1;
+        json jpass;
+        jpass["pass"] = name;
+        jpass["object_code_bytes"] = bytes;
+        jpass["bytes_delta"] = previous_bytes >= 0 && bytes >= 0 ? bytes - previous_bytes : 0;
+        passes.push_back(jpass);
+        previous_bytes = bytes;
+    };
+    measure("none");
+    for (size_t i = 0; i < std::size(kOptimizationPasses); ++i) {
+        if (profile.options.optimizePasses & (1u << i)) {
+            kOptimizationPasses[i].apply(&compileOptions);
+            measure(kOptimizationPasses[i].name);
+        }
+    }
+    return passes;
+}
+
+// Modified handle_translate_request
+// Returns:
+// - On success: a json object representing the "result" field of the JSON-RPC response.
+// - On failure: a json object representing the "error" field (with "code", "message").
+// With "profile": true the payload also carries a "timings" object (in
+// "data" for compile errors) breaking the request down into phases.
+json handle_translate_request(const json& params, CompilerCache& compilers, ResultCache* results) {
+    bool profile = false;
+    if (params.contains("profile")) {
+        if (!params["profile"].is_boolean()) {
+            return make_json_error_payload(EFailJSONRPCInvalidParams, "'profile' must be a boolean.");
+        }
+        profile = params["profile"].get<bool>();
+    }
+    json timings = json::object();
+    PhaseTimer timer(profile ? &timings : nullptr);
+
+    std::string decoded_storage;
+    const std::string* shader_source = nullptr;
+    sh::GLenum shaderType = GL_NONE;
+    json error_payload = ParseTranslateSource(params, &decoded_storage, &shader_source, &shaderType);
+    if (!error_payload.is_null()) {
+        return error_payload;
+    }
+    timer.lap("decode_us");
+
+    TranslationProfile options;
+    error_payload = ResolveTranslateOptions(params, &options);
+    if (!error_payload.is_null()) {
+        return error_payload;
+    }
+    timer.lap("parse_params_us");
+
+    json payload = TranslateSourceWithOptions(*shader_source, shaderType, options, compilers, results, nullptr, &timer);
+    if (profile && options.options.optimizePasses && payload.contains("object_code")) {
+        timings["optimize_passes"] = MeasureOptimizationPasses(*shader_source, shaderType, options, compilers);
+        timer.lap("optimize_passes_us");
+    }
+    if (profile) {
+        // The caller serializes the response after this returns, so time an
+        // identical dump of the payload to show what that step costs.
+        JsonWriter::Dump(payload);
+        timer.lap("json_dump_us");
+        timer.total("total_us");
+        if (payload.contains("code") && payload.contains("message")) {
+            payload["data"]["timings"] = timings;
+        } else {
+            payload["timings"] = timings;
+        }
+    }
+    return payload;
+}
+
+// Handles "translate_many": params carry an "items" array of translate params
+// plus optional top-level spec/output/compile_options/optimize/resources/print_active_variables
+// that are parsed once and shared by every item. An item may override any of
+// those keys, in which case its options are parsed again for that item only.
+// Returns {"results": [...]} where each element is {"result": ...} or {"error": ...},
+// or an "error" payload if the request itself is malformed.
+json handle_translate_many_request(const json& params, CompilerCache& compilers, ResultCache* results) {
+    static const char* const kOptionKeys[] = {"spec", "output", "compile_options", "resources", "print_active_variables",
+                                              "optimize", "reflection_format", "reflect", "keep_reflection", "profile_id"};
+
+    if (!params.contains("items") || !params["items"].is_array()) {
+        return make_json_error_payload(EFailJSONRPCInvalidParams, "Missing 'items' parameter or it is not an array.");
+    }
+
+    TranslationProfile shared_options;
+    json error_payload = ResolveTranslateOptions(params, &shared_options);
+    if (!error_payload.is_null()) {
+        return error_payload;
+    }
+
+    json jresults = json::array();
+    for (const auto& item : params["items"]) {
+        json jitem;
+        if (!item.is_object()) {
+            jitem["error"] = make_json_error_payload(EFailJSONRPCInvalidParams, "Each entry of 'items' must be an object.");
+            jresults.push_back(jitem);
+            continue;
+        }
+
+        std::string decoded_storage;
+        const std::string* shader_source = nullptr;
+        sh::GLenum shaderType = GL_NONE;
+        error_payload = ParseTranslateSource(item, &decoded_storage, &shader_source, &shaderType);
+
+        TranslationProfile item_options = shared_options;
+        if (error_payload.is_null()) {
+            bool overrides_options = false;
+            for (const char* key : kOptionKeys) {
+                overrides_options = overrides_options || item.contains(key);
+            }
+            if (overrides_options) {
+                // Merge only the option keys; the item's source is never copied.
+                // An item's own profile_id replaces every shared option.
+                const bool own_profile = item.contains("profile_id");
+                json merged_params = json::object();
+                for (const char* key : kOptionKeys) {
+                    if (item.contains(key)) {
+                        merged_params[key] = item[key];
+                    } else if (params.contains(key) && !own_profile) {
+                        merged_params[key] = params[key];
+                    }
+                }
+                error_payload = ResolveTranslateOptions(merged_params, &item_options);
+            }
+        }
+
+        json payload = error_payload.is_null()
+                           ? TranslateSourceWithOptions(*shader_source, shaderType, item_options, compilers, results)
+                           : error_payload;
+        if (payload.contains("code") && payload.contains("message")) {
+            jitem["error"] = payload;
+        } else {
+            jitem["result"] = payload;
+        }
+        jresults.push_back(jitem);
+    }
+
+    json result;
+    result["results"] = jresults;
+    return result;
+}
+
+// Marks an error payload from one stage of translate_program with the stage's name.
+static json ProgramStageError(json payload, const char* stage) {
+    payload["data"]["stage"] = stage;
+    return payload;
+}
+
+// Handles "translate_program": params carry "vertex" and "fragment" objects,
+// each with 'shader_code' or 'shader_code_base64', plus the option keys of
+// "translate" (or a 'profile_id') shared by both stages.
+// The fragment stage is compiled first. Unless 'prune_varyings' is false, the
+// vertex stage is then compiled with every output the fragment stage does not
+// statically use demoted to a private global (see varying_pruner.hpp), so it
+// leaves the interface and its computation becomes dead code.
+// Returns {"vertex": ..., "fragment": ..., "linked_varyings": [...],
+// "pruned_varyings": [...]} where the stages are "translate" results, or the
+// first failing stage's "error" payload with "stage" added to its "data".
+// The whole result is cached under both sources, except with
+// "keep_reflection": its handles expire, so each request compiles again.
+json handle_translate_program_request(const json& params, CompilerCache& compilers, ResultCache* results) {
+    const std::string* sources[2] = {nullptr, nullptr};
+    std::string decoded_storage[2];
+    const char* const kStages[2] = {"vertex", "fragment"};
+    for (int stage = 0; stage < 2; ++stage) {
+        if (!params.contains(kStages[stage]) || !params[kStages[stage]].is_object()) {
+            return make_json_error_payload(EFailJSONRPCInvalidParams,
+                                           std::string("Missing '") + kStages[stage] + "' parameter or it is not an object.");
+        }
+        json error_payload = ParseShaderCode(params[kStages[stage]], &decoded_storage[stage], &sources[stage]);
+        if (!error_payload.is_null()) {
+            return ProgramStageError(error_payload, kStages[stage]);
+        }
+    }
+    bool prune_varyings = true;
+    if (params.contains("prune_varyings")) {
+        if (!params["prune_varyings"].is_boolean()) {
+            return make_json_error_payload(EFailJSONRPCInvalidParams, "'prune_varyings' must be a boolean.");
+        }
+        prune_varyings = params["prune_varyings"].get<bool>();
+    }
+    TranslationProfile profile;
+    json error_payload = ResolveTranslateOptions(params, &profile);
+    if (!error_payload.is_null()) {
+        return error_payload;
+    }
+    if (profile.options.keepReflection) {
+        results = nullptr;
+    }
+
+    const std::string& vertex_source = *sources[0];
+    const std::string& fragment_source = *sources[1];
+    static const char kProgramKeySalt[] = "translate_program";
+    const XXH64_hash_t program_hash = XXH64(&prune_varyings, sizeof(prune_varyings),
+                                            XXH64(kProgramKeySalt, sizeof(kProgramKeySalt), profile.options_hash));
+    const ResultCache::Key cache_key{XXH64(vertex_source.data(), vertex_source.size(),
+                                           XXH64(fragment_source.data(), fragment_source.size(), 0)),
+                                     program_hash, vertex_source.size() + fragment_source.size()};
+    json program_payload;
+    if (results && results->lookup(cache_key, &program_payload)) {
+        return program_payload;
+    }
+
+    // The stages are compiled past the result cache: the fragment stage needs
+    // its compiler's varyings, and the program's result is cached as a whole.
+    ShHandle fragment_compiler = nullptr;
+    json fragment_payload =
+        TranslateSourceWithOptions(fragment_source, GL_FRAGMENT_SHADER, profile, compilers, nullptr, &fragment_compiler);
+    if (fragment_payload.contains("code") && fragment_payload.contains("message")) {
+        program_payload = ProgramStageError(fragment_payload, "fragment");
+    } else {
+        std::unordered_set<std::string> fragment_inputs;
+        if (const std::vector<sh::ShaderVariable>* varyings = sh::GetInputVaryings(fragment_compiler)) {
+            for (const sh::ShaderVariable& varying : *varyings) {
+                if (varying.staticUse) {
+                    fragment_inputs.insert(varying.name);
+                }
+            }
+        }
+
+        std::string pruned_source;
+        std::vector<std::string> pruned;
+        if (prune_varyings) {
+            VaryingPruner::Prune(vertex_source, fragment_inputs, &pruned_source, &pruned);
+        }
+        ShHandle vertex_compiler = nullptr;
+        json vertex_payload = TranslateSourceWithOptions(pruned.empty() ? vertex_source : pruned_source,
+                                                         GL_VERTEX_SHADER, profile, compilers, nullptr, &vertex_compiler);
+        if (!pruned.empty() && vertex_payload.contains("code") && vertex_payload.contains("message")) {
+            // A rewrite the compiler rejects is the pruner's fault, not the shader's
+            pruned.clear();
+            vertex_payload = TranslateSourceWithOptions(vertex_source, GL_VERTEX_SHADER, profile, compilers, nullptr,
+                                                        &vertex_compiler);
+        }
+
+        if (vertex_payload.contains("code") && vertex_payload.contains("message")) {
+            program_payload = ProgramStageError(vertex_payload, "vertex");
+        } else {
+            json linked = json::array();
+            if (const std::vector<sh::ShaderVariable>* varyings = sh::GetOutputVaryings(vertex_compiler)) {
+                for (const sh::ShaderVariable& varying : *varyings) {
+                    if (fragment_inputs.count(varying.name)) {
+                        linked.push_back(varying.name);
+                    }
+                }
+            }
+            program_payload["vertex"] = vertex_payload;
+            program_payload["fragment"] = fragment_payload;
+            program_payload["linked_varyings"] = linked;
+            program_payload["pruned_varyings"] = pruned;
+        }
+    }
+
+    if (results) {
+        results->insert(cache_key, program_payload);
+    }
+    return program_payload;
+}
+
+// Compilers and translation results shared by the stdio loop and the WASM invoke() export.
+// With --workers each worker thread owns its own CompilerCache instead; the
+// result cache is always shared.
+static CompilerCache g_compiler_cache;
+static ResultCache g_result_cache;
+static std::unique_ptr<DiskCache> g_disk_cache; // Behind g_result_cache with --disk-cache
+
+// Bumped by flush_compilers so every worker flushes its own compilers before
+// handling its next request.
+static std::atomic<unsigned> g_compiler_flush_generation{0};
+
+// The "compiler_cache" object of "stats" and "cache_stats": totals over every
+// worker's cache, and the capacity of each.
+static json CompilerCacheStats(const CompilerCache& compilers) {
+    const CompilerCache::Totals totals = CompilerCache::GetTotals();
+    json jcompilers;
+    jcompilers["entries"] = totals.entries;
+    jcompilers["caches"] = totals.caches;
+    jcompilers["capacity"] = compilers.capacity();
+    jcompilers["hits"] = totals.hits;
+    jcompilers["misses"] = totals.misses;
+    return jcompilers;
+}
+
+// Request/error/latency counters reported by the "stats" method.
+static ServerStats g_server_stats;
+
+// Memory high-water mark across requests, reported by "stats" and "compact".
+static MemoryWatermark g_memory_watermark;
+
+static json MemorySnapshot() {
+    const uint64_t process_kb = angle::GetProcessMemoryUsageKB();
+    g_memory_watermark.observe(process_kb, process_kb); // Count the request asking, too
+    json jmemory;
+    jmemory["process_kb"] = process_kb;
+    jmemory["high_water_kb"] = g_memory_watermark.high_water_kb();
+    jmemory["largest_request_growth_kb"] = g_memory_watermark.largest_growth_kb();
+    return jmemory;
+}
+
+// One live-editing session: a shader whose source is revised in place, with a
+// compiler of its own and the outcome of its last compile.
+// Edits only take source_mutex, so they never wait for a compile in progress.
+struct TranslationSession {
+    TranslationProfile profile;
+    sh::GLenum shaderType = GL_NONE;
+
+    std::mutex source_mutex; // Guards source and revision
+    std::string source;
+    unsigned long long revision = 0; // Revision of source; bumped by every edit
+
+    std::mutex compile_mutex; // Guards the rest; held while compiling
+    CompilerCache compilers{1}; // The session's compiler, kept until the session closes or a flush
+    unsigned flush_generation = g_compiler_flush_generation.load(); // Latest flush compilers has caught up with
+    bool compiled = false;
+    unsigned long long compiled_revision = 0;
+    SourceFingerprint compiled_fingerprint;
+    json compiled_payload; // "result" or "error" payload of that compile
+
+    // Guarded by the registry's mutex
+    bool closed = false;
+    unsigned queued_updates = 0; // See SessionRegistry::retain()
+
+    // Flushes the compiler if flush_compilers or compact ran since the last
+    // call. The caller holds compile_mutex.
+    void catch_up_flush() {
+        const unsigned generation = g_compiler_flush_generation.load();
+        if (generation != flush_generation) {
+            compilers.flush();
+            flush_generation = generation;
+        }
+    }
+};
+
+// Sessions created by "open_session". Handlers hold a shared_ptr while they
+// work, so a session closed mid-compile is freed once that compile finishes.
+// close_all() must run before sh::Finalize(), since sessions own compilers.
+//
+// With --workers, updates are checked against the registry when they are read
+// and retain() their session until a worker has handled them. A session closed
+// in the meantime stays findable for those updates only; the reader rejects
+// anything sent after the close.
+//
+// Thread-safe: the registry is shared by every worker of the JSON-RPC server.
+class SessionRegistry {
+public:
+    static constexpr size_t kMaxSessions = 256;
+
+    // Returns the new session's id, or 0 if too many sessions are open.
+    unsigned long long open(const TranslationProfile& profile, sh::GLenum shaderType) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (sessions_.size() >= kMaxSessions) {
+            return 0;
+        }
+        auto session = std::make_shared<TranslationSession>();
+        session->profile = profile;
+        session->shaderType = shaderType;
+        sessions_[++last_id_] = std::move(session);
+        return last_id_;
+    }
+
+    std::shared_ptr<TranslationSession> find(unsigned long long id) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = sessions_.find(id);
+        return found == sessions_.end() ? nullptr : found->second;
+    }
+
+    // Returns false if the session is unknown or already closed.
+    bool close(unsigned long long id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = sessions_.find(id);
+        if (found == sessions_.end() || found->second->closed) {
+            return false;
+        }
+        found->second->closed = true;
+        if (found->second->queued_updates == 0) {
+            sessions_.erase(found);
+        }
+        return true;
+    }
+
+    // Like find(), but only for open sessions, and keeps the session in the
+    // registry until a matching release() even if it is closed meanwhile.
+    std::shared_ptr<TranslationSession> retain(unsigned long long id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = sessions_.find(id);
+        if (found == sessions_.end() || found->second->closed) {
+            return nullptr;
+        }
+        ++found->second->queued_updates;
+        return found->second;
+    }
+
+    void release(unsigned long long id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = sessions_.find(id);
+        if (found != sessions_.end() && --found->second->queued_updates == 0 && found->second->closed) {
+            sessions_.erase(found);
+        }
+    }
+
+    void close_all() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sessions_.clear();
+    }
+
+    // Catches up every session that is not compiling with the latest flush;
+    // the others catch up when their compile is done.
+    void flush_idle_compilers() {
+        std::vector<std::shared_ptr<TranslationSession>> sessions;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& entry : sessions_) {
+                sessions.push_back(entry.second);
+            }
+        }
+        for (const auto& session : sessions) {
+            std::unique_lock<std::mutex> compile_lock(session->compile_mutex, std::try_to_lock);
+            if (compile_lock.owns_lock()) {
+                session->catch_up_flush();
+            }
+        }
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return sessions_.size();
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::unordered_map<unsigned long long, std::shared_ptr<TranslationSession>> sessions_;
+    unsigned long long last_id_ = 0;
+};
+
+static SessionRegistry g_session_registry;
+
+// Flushes the caller's compilers and those of idle sessions, and has every
+// other thread and session flush its own: idle pool workers wake up for it,
+// busy ones and compiling sessions flush once they are done. Returns how many
+// compilers that releases in all.
+static size_t FlushAllCompilers(CompilerCache& compilers) {
+    const size_t entries = CompilerCache::GetTotals().entries; // Before anyone starts flushing
+    ++g_compiler_flush_generation;
+    compilers.flush();
+    g_session_registry.flush_idle_compilers();
+    return entries;
+}
+
+// Looks up params["session_id"] into *session, with SessionRegistry::retain()
+// if retain is set. Returns a null json on success, or an "error" payload.
+static json FindSession(const json& params, std::shared_ptr<TranslationSession>* session, bool retain = false) {
+    if (!params.contains("session_id") || !params["session_id"].is_number_unsigned()) {
+        return make_json_error_payload(EFailJSONRPCInvalidParams, "Missing 'session_id' parameter or it is not a non-negative integer.");
+    }
+    const unsigned long long id = params["session_id"].get<unsigned long long>();
+    *session = retain ? g_session_registry.retain(id) : g_session_registry.find(id);
+    if (!*session) {
+        return make_json_error_payload(EFailJSONRPCInvalidParams, "Unknown 'session_id'; it was never opened or is already closed.");
+    }
+    return nullptr;
+}
+
+// Handles "open_session": takes 'shader_type' and the option keys of
+// "translate" (or a 'profile_id'), which stay fixed for the session's life.
+// Returns {"session_id": N, "revision": 0}; the source starts out empty.
+static json handle_open_session_request(const json& params) {
+    if (!params.contains("shader_type") || !params["shader_type"].is_string()) {
+        return make_json_error_payload(EFailJSONRPCInvalidParams, "Missing 'shader_type' parameter or it is not a string.");
+    }
+    const std::string& shader_type_str = params["shader_type"].get_ref<const std::string&>();
+    const sh::GLenum shaderType = FindShaderTypeFromJson(shader_type_str);
+    if (shaderType == GL_NONE) {
+        return make_json_error_payload(EFailJSONRPCInvalidParams, "Unsupported 'shader_type': " + shader_type_str);
+    }
+    TranslationProfile profile;
+    json error_payload = ResolveTranslateOptions(params, &profile);
+    if (!error_payload.is_null()) {
+        return error_payload;
+    }
+    const unsigned long long id = g_session_registry.open(profile, shaderType);
+    if (id == 0) {
+        return make_json_error_payload(EFailJSONRPCInvalidParams, "Too many open sessions.");
+    }
+    json result;
+    result["session_id"] = id;
+    result["revision"] = 0;
+    return result;
+}
+
+// Applies the 'shader_code' or 'edits' of an update_session request to the
+// session's source; the caller holds source_mutex. Edits are {"start", "end",
+// "text"} objects replacing the bytes [start, end) of the source, applied in
+// order so each one's offsets refer to the source as left by the previous
+// one. A new source gets 'revision' if given (it must exceed the current
+// one), else the next number. Returns a null json on success, or an "error"
+// payload, in which case the source is unchanged.
+static json ApplySessionEdits(const json& params, TranslationSession& session) {
+    unsigned long long revision = session.revision + 1;
+    if (params.contains("revision")) {
+        if (!params["revision"].is_number_unsigned() || params["revision"].get<unsigned long long>() <= session.revision) {
+            return make_json_error_payload(EFailJSONRPCInvalidParams,
+                                           "'revision' must be an integer greater than the session's current revision (" +
+                                               std::to_string(session.revision) + ").");
+        }
+        revision = params["revision"].get<unsigned long long>();
+    }
+
+    if (params.contains("shader_code")) {
+        if (!params["shader_code"].is_string()) {
+            return make_json_error_payload(EFailJSONRPCInvalidParams, "'shader_code' parameter must be a string.");
+        }
+        session.source = params["shader_code"].get<std::string>();
+    } else {
+        const json& edits = params["edits"];
+        if (!edits.is_array()) {
+            return make_json_error_payload(EFailJSONRPCInvalidParams, "'edits' must be an array.");
+        }
+        std::string edited = session.source;
+        for (const json& edit : edits) {
+            if (!edit.is_object() || !edit.contains("start") || !edit["start"].is_number_unsigned() ||
+                !edit.contains("end") || !edit["end"].is_number_unsigned() ||
+                !edit.contains("text") || !edit["text"].is_string()) {
+                return make_json_error_payload(EFailJSONRPCInvalidParams,
+                                               "Each edit must be an object with integer 'start' and 'end' and a string 'text'.");
+            }
+            const size_t start = edit["start"].get<size_t>();
+            const size_t end = edit["end"].get<size_t>();
+            if (start > end || end > edited.size()) {
+                return make_json_error_payload(EFailJSONRPCInvalidParams, "Edit range is outside the session's source.");
+            }
+            edited.replace(start, end - start, edit["text"].get_ref<const std::string&>());
+        }
+        session.source.swap(edited);
+    }
+    session.revision = revision;
+    return nullptr;
+}
+
+// Adds the session's revision bookkeeping to a translate payload.
+static void AnnotateSessionPayload(json* payload, unsigned long long revision, unsigned long long latest_revision,
+                                   bool reused) {
+    json& target = payload->contains("code") && payload->contains("message") ? (*payload)["data"] : *payload;
+    target["revision"] = revision;
+    target["latest_revision"] = latest_revision;
+    target["reused"] = reused;
+}
+
+// Compiles the session's current source, unless revision names an older one:
+// such a request was overtaken by a newer edit, so it answers
+// {"superseded": true} straight away. An edit that lands while the compile
+// runs cannot interrupt it; the payload then shows a "latest_revision" past
+// its "revision". If the source differs from
+// the last compiled one only in comments and whitespace the last payload is
+// returned as is ("reused": true); line moves count as changes when the
+// payload has a log, which cites line numbers, or when the source uses
+// __LINE__. (Translate requests cannot turn on ANGLE's line directives.)
+static json CompileSession(TranslationSession& session, unsigned long long revision) {
+    std::lock_guard<std::mutex> compile_lock(session.compile_mutex);
+    std::string source;
+    {
+        std::lock_guard<std::mutex> source_lock(session.source_mutex);
+        if (revision < session.revision) {
+            json result;
+            result["superseded"] = true;
+            result["revision"] = revision;
+            result["latest_revision"] = session.revision;
+            return result;
+        }
+        source = session.source;
+        revision = session.revision;
+    }
+    auto latest_revision = [&session] {
+        std::lock_guard<std::mutex> source_lock(session.source_mutex);
+        return session.revision;
+    };
+
+    const SourceFingerprint fingerprint = SourceFingerprint::Of(source);
+    if (session.compiled && fingerprint.tokens == session.compiled_fingerprint.tokens) {
+        const json& payload = session.compiled_payload;
+        const json& log_holder = payload.contains("code") && payload.contains("message") ? payload["data"] : payload;
+        const bool line_sensitive = fingerprint.uses_line_macro || !log_holder.value("info_log", std::string()).empty();
+        if (!line_sensitive || fingerprint.lines == session.compiled_fingerprint.lines) {
+            json reused_payload = payload;
+            AnnotateSessionPayload(&reused_payload, revision, latest_revision(), true);
+            session.compiled_revision = revision;
+            session.compiled_fingerprint = fingerprint;
+            return reused_payload;
+        }
+    }
+
+    session.catch_up_flush();
+    json payload = TranslateSourceWithOptions(source, session.shaderType, session.profile, session.compilers,
+                                              &g_result_cache);
+    session.catch_up_flush(); // For a flush that came in while compiling
+    session.compiled = true;
+    session.compiled_revision = revision;
+    session.compiled_fingerprint = fingerprint;
+    session.compiled_payload = payload;
+    AnnotateSessionPayload(&payload, revision, latest_revision(), false);
+    return payload;
+}
+
+// Handles "update_session": params carry 'session_id' and optionally a new
+// source, as 'shader_code' or as 'edits' (see ApplySessionEdits), then the
+// session is compiled (see CompileSession). Without a new source, 'revision'
+// names the revision the caller wants compiled, defaulting to the latest.
+// Returns the translate payload with "revision", "latest_revision" and
+// "reused" added (in "data" for compile errors).
+static json handle_update_session_request(const json& params) {
+    std::shared_ptr<TranslationSession> session;
+    json error_payload = FindSession(params, &session);
+    if (!error_payload.is_null()) {
+        return error_payload;
+    }
+    if (params.contains("shader_code") && params.contains("edits")) {
+        return make_json_error_payload(EFailJSONRPCInvalidParams, "Specify only one of 'shader_code' and 'edits'.");
+    }
+
+    unsigned long long revision = 0;
+    if (params.contains("shader_code") || params.contains("edits")) {
+        std::lock_guard<std::mutex> lock(session->source_mutex);
+        error_payload = ApplySessionEdits(params, *session);
+        if (!error_payload.is_null()) {
+            return error_payload;
+        }
+        revision = session->revision;
+    } else if (params.contains("revision")) {
+        if (!params["revision"].is_number_unsigned()) {
+            return make_json_error_payload(EFailJSONRPCInvalidParams, "'revision' must be a non-negative integer.");
+        }
+        revision = params["revision"].get<unsigned long long>();
+    } else {
+        std::lock_guard<std::mutex> lock(session->source_mutex);
+        revision = session->revision;
+    }
+    return CompileSession(*session, revision);
+}
+
+// Handles "close_session". Returns {"closed": true}.
+static json handle_close_session_request(const json& params) {
+    if (!params.contains("session_id") || !params["session_id"].is_number_unsigned()) {
+        return make_json_error_payload(EFailJSONRPCInvalidParams, "Missing 'session_id' parameter or it is not a non-negative integer.");
+    }
+    if (!g_session_registry.close(params["session_id"].get<unsigned long long>())) {
+        return make_json_error_payload(EFailJSONRPCInvalidParams, "Unknown 'session_id'; it was never opened or is already closed.");
+    }
+    json result;
+    result["closed"] = true;
+    return result;
+}
+
+static const char* FailCodeName(int code) {
+    switch (code) {
+        case ESuccess: return "ESuccess";
+        case EFailUsage: return "EFailUsage";
+        case EFailCompile: return "EFailCompile";
+        case EFailCompilerCreate: return "EFailCompilerCreate";
+        case EFailJSONRPCParse: return "EFailJSONRPCParse";
+        case EFailJSONRPCInvalidRequest: return "EFailJSONRPCInvalidRequest";
+        case EFailJSONRPCMethodNotFound: return "EFailJSONRPCMethodNotFound";
+        case EFailJSONRPCInvalidParams: return "EFailJSONRPCInvalidParams";
+        case EFailJSONRPCInternalError: return "EFailJSONRPCInternalError";
+        case EFailJSONRPCRequestTimeout: return "EFailJSONRPCRequestTimeout";
+        case EFailJSONRPCBackendUnavailable: return "EFailJSONRPCBackendUnavailable";
+        case EFailJSONRPCRequestCancelled: return "EFailJSONRPCRequestCancelled";
+        default: return nullptr;
+    }
+}
+
+static double HitRate(unsigned long long hits, unsigned long long misses) {
+    return hits + misses ? static_cast<double>(hits) / static_cast<double>(hits + misses) : 0.0;
+}
+
+// Method dispatch for dispatch_json_rpc_request below.
+static void dispatch_json_rpc_method(const json& request_json, json& response_json_shell, CompilerCache& compilers,
+                                     bool* shutdown_requested) {
+    if (request_json.contains("id")) {
+        response_json_shell["id"] = request_json["id"];
+    }
+
+    if (!request_json.contains("method") || !request_json["method"].is_string()) {
+        response_json_shell["error"] = make_json_error_payload(EFailJSONRPCInvalidRequest, "Invalid Request: 'method' is missing or not a string.");
+        return;
+    }
+    std::string method = request_json["method"].get<std::string>();
+
+    if (method == "translate") {
+        if (!request_json.contains("params") || !request_json["params"].is_object()) {
+            response_json_shell["error"] = make_json_error_payload(EFailJSONRPCInvalidParams, "Invalid Params: 'params' is missing or not an object for 'translate' method.");
+        } else {
+            json result_or_error_payload = handle_translate_request(request_json["params"], compilers, &g_result_cache);
+
+            if (result_or_error_payload.contains("code") && result_or_error_payload.contains("message") && result_or_error_payload.is_object()) {
+                response_json_shell["error"] = result_or_error_payload;
+            } else {
+                response_json_shell["result"] = result_or_error_payload;
+            }
+        }
+    } else if (method == "translate_many") {
+        if (!request_json.contains("params") || !request_json["params"].is_object()) {
+            response_json_shell["error"] = make_json_error_payload(EFailJSONRPCInvalidParams, "Invalid Params: 'params' is missing or not an object for 'translate_many' method.");
+        } else {
+            json result_or_error_payload = handle_translate_many_request(request_json["params"], compilers, &g_result_cache);
+
+            if (result_or_error_payload.contains("code") && result_or_error_payload.contains("message")) {
+                response_json_shell["error"] = result_or_error_payload;
+            } else {
+                response_json_shell["result"] = result_or_error_payload;
+            }
+        }
+    } else if (method == "translate_program") {
+        if (!request_json.contains("params") || !request_json["params"].is_object()) {
+            response_json_shell["error"] = make_json_error_payload(EFailJSONRPCInvalidParams, "Invalid Params: 'params' is missing or not an object for 'translate_program' method.");
+        } else {
+            json result_or_error_payload = handle_translate_program_request(request_json["params"], compilers, &g_result_cache);
+            if (result_or_error_payload.contains("code") && result_or_error_payload.contains("message")) {
+                response_json_shell["error"] = result_or_error_payload;
+            } else {
+                response_json_shell["result"] = result_or_error_payload;
+            }
+        }
+    } else if (method == "preprocess") {
+        if (!request_json.contains("params") || !request_json["params"].is_object()) {
+            response_json_shell["error"] = make_json_error_payload(EFailJSONRPCInvalidParams, "Invalid Params: 'params' is missing or not an object for 'preprocess' method.");
+        } else {
+            json result_or_error_payload = handle_preprocess_request(request_json["params"]);
+            if (result_or_error_payload.contains("code") && result_or_error_payload.contains("message")) {
+                response_json_shell["error"] = result_or_error_payload;
+            } else {
+                response_json_shell["result"] = result_or_error_payload;
+            }
+        }
+    } else if (method == "register_profile") {
+        if (!request_json.contains("params") || !request_json["params"].is_object()) {
+            response_json_shell["error"] = make_json_error_payload(EFailJSONRPCInvalidParams, "Invalid Params: 'params' is missing or not an object for 'register_profile' method.");
+        } else {
+            json result_or_error_payload = handle_register_profile_request(request_json["params"]);
+            if (result_or_error_payload.contains("code") && result_or_error_payload.contains("message")) {
+                response_json_shell["error"] = result_or_error_payload;
+            } else {
+                response_json_shell["result"] = result_or_error_payload;
+            }
+        }
+    } else if (method == "get_reflection") {
+        if (!request_json.contains("params") || !request_json["params"].is_object()) {
+            response_json_shell["error"] = make_json_error_payload(EFailJSONRPCInvalidParams, "Invalid Params: 'params' is missing or not an object for 'get_reflection' method.");
+        } else {
+            json result_or_error_payload = handle_get_reflection_request(request_json["params"]);
+            if (result_or_error_payload.contains("code") && result_or_error_payload.contains("message")) {
+                response_json_shell["error"] = result_or_error_payload;
+            } else {
+                response_json_shell["result"] = result_or_error_payload;
+            }
+        }
+    } else if (method == "open_session" || method == "update_session" || method == "close_session") {
+        if (!request_json.contains("params") || !request_json["params"].is_object()) {
+            response_json_shell["error"] = make_json_error_payload(EFailJSONRPCInvalidParams, "Invalid Params: 'params' is missing or not an object for '" + method + "' method.");
+        } else {
+            const json& params = request_json["params"];
+            json result_or_error_payload = method == "open_session"     ? handle_open_session_request(params)
+                                           : method == "update_session" ? handle_update_session_request(params)
+                                                                        : handle_close_session_request(params);
+            if (result_or_error_payload.contains("code") && result_or_error_payload.contains("message")) {
+                response_json_shell["error"] = result_or_error_payload;
+            } else {
+                response_json_shell["result"] = result_or_error_payload;
+            }
+        }
+    } else if (method == "flush_compilers") {
+        json result;
+        result["flushed"] = FlushAllCompilers(compilers);
+        response_json_shell["result"] = result;
+    } else if (method == "cache_stats") {
+        json result;
+        result["result_cache"] = g_result_cache.stats();
+        result["compiler_cache"] = CompilerCacheStats(compilers);
+        response_json_shell["result"] = result;
+    } else if (method == "stats") {
+        // Optional params: {"format": "json" (default) | "prometheus"}.
+        const json params = request_json.value("params", json::object());
+        std::string format = "json";
+        if (params.contains("format")) {
+            format = params["format"].is_string() ? params["format"].get<std::string>() : "";
+        }
+        if (format != "json" && format != "prometheus") {
+            response_json_shell["error"] = make_json_error_payload(EFailJSONRPCInvalidParams, "'format' must be \"json\" or \"prometheus\".");
+        } else {
+            json snapshot = g_server_stats.to_json(FailCodeName);
+            json jresults = g_result_cache.stats();
+            jresults["hit_rate"] = HitRate(jresults["hits"].get<unsigned long long>(), jresults["misses"].get<unsigned long long>());
+            snapshot["result_cache"] = jresults;
+            if (g_disk_cache) {
+                snapshot["disk_cache"] = g_disk_cache->stats();
+            }
+            json jcompilers = CompilerCacheStats(compilers);
+            jcompilers["hit_rate"] = HitRate(jcompilers["hits"].get<unsigned long long>(), jcompilers["misses"].get<unsigned long long>());
+            snapshot["compiler_cache"] = jcompilers;
+            snapshot["memory"] = MemorySnapshot();
+            snapshot["sessions"] = g_session_registry.size();
+            if (format == "prometheus") {
+                json result;
+                result["text"] = ServerStats::prometheus_text(snapshot);
+                response_json_shell["result"] = result;
+            } else {
+                response_json_shell["result"] = snapshot;
+            }
+        }
+    } else if (method == "compact") {
+        // Releases memory retained between requests. Each cached compiler's
+        // pool allocator keeps the pages of the largest compile it has done
+        // until the compiler is destroyed, so the compilers are flushed (on
+        // every worker, as with flush_compilers). Optional params:
+        // {"result_cache": true} also drops every cached translation.
+        const json params = request_json.value("params", json::object());
+        if (params.contains("result_cache") && !params["result_cache"].is_boolean()) {
+            response_json_shell["error"] = make_json_error_payload(EFailJSONRPCInvalidParams, "'result_cache' must be a boolean.");
+        } else {
+            json result;
+            const uint64_t process_kb_before = angle::GetProcessMemoryUsageKB();
+            result["compilers_released"] = FlushAllCompilers(compilers);
+            result["results_released"] = params.value("result_cache", false) ? g_result_cache.clear() : 0;
+#if defined(__GLIBC__)
+            malloc_trim(0); // Return freed heap pages to the OS
+#endif
+            result["process_kb_before"] = process_kb_before;
+            result["memory"] = MemorySnapshot();
+            response_json_shell["result"] = result;
+        }
+    } else if (method == "cache_clear") {
+        // Optional params: {"max_bytes": N} also changes the budget (0 disables the cache).
+        const json params = request_json.value("params", json::object());
+        if (params.contains("max_bytes") && !params["max_bytes"].is_number_unsigned()) {
+            response_json_shell["error"] = make_json_error_payload(EFailJSONRPCInvalidParams, "'max_bytes' must be a non-negative integer.");
+        } else {
+            json result;
+            result["cleared"] = g_result_cache.clear();
+            if (params.contains("max_bytes")) {
+                g_result_cache.set_max_bytes(params["max_bytes"].get<size_t>());
+            }
+            response_json_shell["result"] = result;
+        }
+    } else if (method == "cancel") {
+        // Worker pools intercept "cancel" before dispatch. Anywhere else requests
+        // are answered one at a time, so the one named is already done.
+        json result;
+        result["cancelled"] = false;
+        response_json_shell["result"] = result;
+    } else if (method == "shutdown" && shutdown_requested) {
+        response_json_shell["result"] = "Shutdown acknowledged.";
+        *shutdown_requested = true;
+    } else {
+        response_json_shell["error"] = make_json_error_payload(EFailJSONRPCMethodNotFound, "Method not found: " + method);
+    }
+
+    // Ensure "result" is not present if "error" is present
+    if (response_json_shell.contains("error") && response_json_shell.contains("result")) {
+        response_json_shell.erase("result");
+    }
+}
+
+// Shared JSON-RPC dispatch for the stdio loop, the worker pool and the WASM
+// invoke() export. compilers is the calling thread's compiler cache.
+// Fills in "id" and either "result" or "error" on response_json_shell, and
+// records the request in g_server_stats.
+// "shutdown" is only honoured when shutdown_requested is non-null; the caller
+// is responsible for actually exiting.
+static void dispatch_json_rpc_request(const json& request_json, json& response_json_shell, CompilerCache& compilers,
+                                      bool* shutdown_requested) {
+    const auto request_start = std::chrono::steady_clock::now();
+    {
+        MemoryWatermark::Scope memory_scope(g_memory_watermark);
+        dispatch_json_rpc_method(request_json, response_json_shell, compilers, shutdown_requested);
+    }
+    const uint64_t latency_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - request_start).count();
+
+    std::string method = "invalid";
+    if (request_json.is_object() && request_json.contains("method") && request_json["method"].is_string()) {
+        method = request_json["method"].get<std::string>();
+    }
+    if (response_json_shell.contains("error")) {
+        const json& error = response_json_shell["error"];
+        g_server_stats.record_error(error.contains("code") && error["code"].is_number_integer()
+                                        ? error["code"].get<int>() : EFailJSONRPCInternalError);
+        if (error.value("code", 0) == EFailJSONRPCMethodNotFound) {
+            method = "unknown"; // Don't let arbitrary method names become labels
+        }
+    }
+    g_server_stats.record_request(method, latency_us);
+
+    if ((method == "translate" || method == "translate_many" || method == "translate_program") &&
+        request_json.contains("params")) {
+        const json& params = request_json["params"];
+        const TranslationProfile* profile = params.is_object() && params.contains("profile_id") &&
+                                                    params["profile_id"].is_number_unsigned()
+                                                ? g_profile_registry.find(params["profile_id"].get<unsigned long long>())
+                                                : nullptr;
+        if (profile) {
+            g_server_stats.record_translation(profile->spec_label, profile->output_label);
+        } else {
+            g_server_stats.record_translation(StatsLabel(params, "spec", "gles2"), StatsLabel(params, "output", "essl"));
+        }
+    }
+    if (method == "translate_many" && response_json_shell.contains("result")) {
+        for (const json& item : response_json_shell["result"]["results"]) {
+            if (item.contains("error")) {
+                g_server_stats.record_error(item["error"]["code"].get<int>());
+            }
+        }
+    }
+}
+
+// If NUM_SOURCE_STRINGS is set to a value > 1, the input file data is
+// broken into that many chunks. This will affect file/line numbering in
+// the preprocessor.
+const unsigned int NUM_SOURCE_STRINGS = 1;
+typedef std::vector<char *> ShaderSource;
+static bool ReadShaderSource(const char *fileName, ShaderSource &source);
+static void FreeShaderSource(ShaderSource &source);
+
+static bool ParseGLSLOutputVersion(const std::string &, ShShaderOutput *outResult);
+static bool ParseIntValue(const std::string &, int emptyDefault, int *outValue);
+
+static void PrintSpirv(const sh::BinaryBlob &blob);
+
+//
+// Set up the per compile resources
+//
+void GenerateResources(ShBuiltInResources *resources)
+{
+    sh::InitBuiltInResources(resources);
+
+    resources->MaxVertexAttribs             = 8;
+    resources->MaxVertexUniformVectors      = 128;
+    resources->MaxVaryingVectors            = 8;
+    resources->MaxVertexTextureImageUnits   = 0;
+    resources->MaxCombinedTextureImageUnits = 8;
+    resources->MaxTextureImageUnits         = 8;
+    resources->MaxFragmentUniformVectors    = 16;
+    resources->MaxDrawBuffers               = 1;
+    resources->MaxDualSourceDrawBuffers     = 1;
+
+    resources->OES_standard_derivatives  = 0;
+    resources->OES_EGL_image_external    = 0;
+    resources->EXT_geometry_shader       = 1;
+    resources->ANGLE_texture_multisample = 0;
+    resources->APPLE_clip_distance       = 0;
+}
+
+// Response to a Content-Length frame that cannot be parsed. The stream cannot
+// be resynchronized after one, so the server stops reading.
+static json MakeFrameErrorResponse() {
+    json response_json_shell;
+    response_json_shell["jsonrpc"] = "2.0";
+    response_json_shell["id"] = nullptr;
+    response_json_shell["error"] = make_json_error_payload(EFailJSONRPCParse, "Parse error: Invalid frame header.");
+    g_server_stats.record_error(EFailJSONRPCParse);
+    return response_json_shell;
+}
+
+#if !defined(__EMSCRIPTEN__)
+// --workers mode: the main thread reads and parses requests, a pool of
+// worker threads handles them, and each response is written as soon as it is
+// ready. Responses can therefore arrive out of order; clients match them up by
+// "id". Each worker owns its own CompilerCache, the result cache is shared.
+// Output is flushed whenever the queue runs empty (or per the stream's batch size).
+//
+// A request may carry a time budget ('timeout_ms' in its params, or the
+// server's --timeout-ms), and "cancel" names a request by its "id". A watchdog
+// thread answers requests whose budget runs out, whether still queued or
+// running. sh::Compile cannot be interrupted, so a running request is
+// abandoned rather than stopped: its worker is replaced at once, finishes the
+// compile in the background, drops the response and exits.
+//
+// At most as many workers as the pool has may be abandoned at a time. Past
+// that, an abandoned worker is not replaced until one of them returns, which
+// then takes over the missing worker's place; requests queue meanwhile, and
+// their own budgets keep running. Workers that exited are joined as new
+// requests arrive.
+class JsonRpcWorkerPool {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    JsonRpcWorkerPool(size_t num_workers, JsonRpcStream& stream) : stream_(stream), max_abandoned_(num_workers) {
+        for (size_t i = 0; i < num_workers; ++i) {
+            workers_.emplace_back([this] { run(); });
+        }
+        watchdog_ = std::thread([this] { watch(); });
+    }
+    ~JsonRpcWorkerPool() { drain(); }
+
+    // Queues a request. A non-zero timeout_ms is measured from now.
+    void submit(json request, uint64_t timeout_ms) {
+        reap();
+        auto job = std::make_shared<Job>();
+        if (request.is_object() && request.contains("id") && !request["id"].is_null()) {
+            job->id_key = JsonWriter::Dump(request["id"]);
+        }
+        job->request = std::move(request);
+        job->timeout_ms = timeout_ms;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            if (!job->id_key.empty()) {
+                jobs_by_id_[job->id_key] = job; // With duplicate ids, cancel hits the latest
+            }
+            if (timeout_ms) {
+                job->deadline = deadlines_.emplace(Clock::now() + std::chrono::milliseconds(timeout_ms), job);
+                watchdog_cv_.notify_one();
+            }
+            queue_.push_back(job);
+        }
+        queue_cv_.notify_one();
+    }
+
+    // Answers the queued or running request with this id with a cancellation
+    // error. Returns false if no such request is outstanding.
+    bool cancel(const json& id) {
+        std::shared_ptr<Job> job;
+        json response;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            auto found = jobs_by_id_.find(JsonWriter::Dump(id));
+            if (found == jobs_by_id_.end()) {
+                return false;
+            }
+            job = found->second;
+            response = abandon(job, make_json_error_payload(EFailJSONRPCRequestCancelled, "Request cancelled."));
+        }
+        write(response);
+        return true;
+    }
+
+    // Lets the workers finish every queued request, then joins them. Their
+    // compilers are destroyed on the way out, so this must run before sh::Finalize().
+    void drain() {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            stopping_ = true;
+        }
+        queue_cv_.notify_all();
+        // The watchdog keeps running meanwhile, and may add replacement workers.
+        for (size_t i = 0;; ++i) {
+            std::thread worker;
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex_);
+                if (i >= workers_.size()) {
+                    break;
+                }
+                worker = std::move(workers_[i]);
+            }
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            watchdog_stopping_ = true;
+            workers_.clear();
+        }
+        watchdog_cv_.notify_all();
+        if (watchdog_.joinable()) {
+            watchdog_.join();
+        }
+    }
+
+    // Writes one response; the mutex keeps concurrent messages whole. It is
+    // flushed unless a queued request is still to be answered.
+    void write(const json& response) {
+        std::string message = JsonWriter::Dump(response);
+        bool more_pending;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            more_pending = !queue_.empty();
+        }
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        stream_.write(message, more_pending);
+    }
+
+private:
+    struct Job;
+    using Deadlines = std::multimap<Clock::time_point, std::shared_ptr<Job>>;
+
+    struct Job {
+        json request;
+        std::string id_key; // Serialized "id", or empty for notifications
+        uint64_t timeout_ms = 0;
+        // Guarded by queue_mutex_
+        Deadlines::iterator deadline; // Valid while timeout_ms is set and the job is outstanding
+        bool running = false;
+        bool answered = false; // Set by whoever writes the response first
+    };
+
+    void run() {
+        CompilerCache compilers;
+        unsigned flush_generation = g_compiler_flush_generation.load();
+        for (;;) {
+            std::shared_ptr<Job> job;
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                queue_cv_.wait(lock, [&] {
+                    return stopping_ || !queue_.empty() || g_compiler_flush_generation.load() != flush_generation;
+                });
+                if (queue_.empty() && stopping_) {
+                    return;
+                }
+                if (!queue_.empty()) {
+                    job = std::move(queue_.front());
+                    queue_.pop_front();
+                    if (job->answered) {
+                        continue; // Timed out or cancelled while queued
+                    }
+                    job->running = true;
+                }
+            }
+
+            // Catch up with flush_compilers requests handled by other workers;
+            // an idle worker is woken just for this.
+            unsigned generation = g_compiler_flush_generation.load();
+            if (generation != flush_generation) {
+                compilers.flush();
+                flush_generation = generation;
+            }
+            if (!job) {
+                continue;
+            }
+
+            const json& request = job->request;
+            json response_json_shell;
+            response_json_shell["jsonrpc"] = "2.0";
+            response_json_shell["id"] = nullptr; // Default
+            dispatch_json_rpc_request(request, response_json_shell, compilers, nullptr);
+            if (request.is_object() && request.contains("method") && request["method"] == "update_session") {
+                g_session_registry.release(request["params"]["session_id"].get<unsigned long long>()); // Staged by the reader
+            }
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex_);
+                if (g_compiler_flush_generation.load() != flush_generation) {
+                    queue_cv_.notify_all(); // This request flushed; wake the idle workers to flush theirs
+                }
+                if (job->answered) {
+                    // Abandoned mid-request. Take back the place of a worker
+                    // that was not replaced, or else leave it to the replacement.
+                    --abandoned_;
+                    if (unreplaced_ > 0) {
+                        --unreplaced_;
+                        continue;
+                    }
+                    exited_.push_back(std::this_thread::get_id());
+                    return;
+                }
+                job->answered = true;
+                forget(job);
+            }
+            write(response_json_shell);
+        }
+    }
+
+    // Answers requests whose time budget has run out.
+    void watch() {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        while (!watchdog_stopping_) {
+            if (deadlines_.empty()) {
+                watchdog_cv_.wait(lock);
+                continue;
+            }
+            auto first = deadlines_.begin();
+            if (first->first > Clock::now()) {
+                watchdog_cv_.wait_until(lock, first->first);
+                continue;
+            }
+            std::shared_ptr<Job> job = first->second;
+            json response = abandon(job, make_json_error_payload(
+                                             EFailJSONRPCRequestTimeout,
+                                             "Request exceeded its time budget of " + std::to_string(job->timeout_ms) + " ms."));
+            lock.unlock();
+            write(response);
+            lock.lock();
+        }
+    }
+
+    // Marks job answered and returns the error response for it; the caller
+    // holds queue_mutex_ and writes the response after releasing it. A running
+    // job's worker is replaced, since it stays busy until its compile
+    // returns, unless max_abandoned_ workers are already busy that way.
+    json abandon(const std::shared_ptr<Job>& job, const json& error_payload) {
+        job->answered = true;
+        forget(job);
+        if (!job->running) {
+            // Leaves queue_ holding only requests still to be answered, which
+            // write() relies on to decide when to flush.
+            queue_.erase(std::find(queue_.begin(), queue_.end(), job));
+        } else {
+            if (++abandoned_ <= max_abandoned_) {
+                workers_.emplace_back([this] { run(); });
+            } else {
+                ++unreplaced_;
+            }
+        }
+        g_server_stats.record_error(error_payload["code"].get<int>());
+        json response_json_shell;
+        response_json_shell["jsonrpc"] = "2.0";
+        response_json_shell["id"] = job->request.is_object() && job->request.contains("id") ? job->request["id"] : json(nullptr);
+        response_json_shell["error"] = error_payload;
+        return response_json_shell;
+    }
+
+    // Joins the abandoned workers that have exited since the last call.
+    void reap() {
+        std::vector<std::thread> exited;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            for (const std::thread::id id : exited_) {
+                auto found = std::find_if(workers_.begin(), workers_.end(),
+                                          [id](const std::thread& worker) { return worker.get_id() == id; });
+                if (found != workers_.end()) {
+                    exited.push_back(std::move(*found));
+                    workers_.erase(found);
+                }
+            }
+            exited_.clear();
+        }
+        for (std::thread& worker : exited) {
+            worker.join();
         }
-        print_active_vars = params["print_active_variables"].get<bool>();
     }
 
+    // Drops the bookkeeping that lets job be cancelled or time out.
+    void forget(const std::shared_ptr<Job>& job) {
+        if (!job->id_key.empty()) {
+            auto found = jobs_by_id_.find(job->id_key);
+            if (found != jobs_by_id_.end() && found->second == job) {
+                jobs_by_id_.erase(found);
+            }
+        }
+        if (job->timeout_ms) {
+            deadlines_.erase(job->deadline);
+        }
+    }
 
-    // --- Perform Compilation ---
-    ShHandle compiler = sh::ConstructCompiler(shaderType, spec, output, &resources);
-    int cr = (int)compiler;
-    if (!compiler) {
-        return make_json_error_payload(EFailCompilerCreate, "Failed to construct compiler.");
+    JsonRpcStream& stream_;
+    std::vector<std::thread> workers_; // Guarded by queue_mutex_ once the pool is running
+    const size_t max_abandoned_;
+    size_t abandoned_ = 0;   // Workers still compiling an abandoned request
+    size_t unreplaced_ = 0;  // Of those, the ones past max_abandoned_ that were not replaced
+    std::vector<std::thread::id> exited_; // Abandoned workers that returned, for reap()
+    std::mutex queue_mutex_;
+    std::condition_variable queue_cv_;
+    std::deque<std::shared_ptr<Job>> queue_;
+    std::unordered_map<std::string, std::shared_ptr<Job>> jobs_by_id_; // Queued or running
+    Deadlines deadlines_;
+    bool stopping_ = false;
+    std::thread watchdog_;
+    std::condition_variable watchdog_cv_;
+    bool watchdog_stopping_ = false;
+    std::mutex write_mutex_;
+};
+
+// Checks an update_session request on the reader thread and applies its new
+// source there, so a session's edits land in arrival order however the
+// workers interleave, then rewrites the request to compile just that
+// revision. A worker that picks it up after a newer revision has been read
+// skips the stale compile. On success the session is retained until the
+// worker is done; otherwise returns the "error" payload to answer with, and
+// the session is unchanged.
+static json StageSessionUpdate(json& request_json) {
+    if (!request_json.contains("params") || !request_json["params"].is_object()) {
+        return make_json_error_payload(EFailJSONRPCInvalidParams, "Invalid Params: 'params' is missing or not an object for 'update_session' method.");
+    }
+    json& params = request_json["params"];
+    std::shared_ptr<TranslationSession> session;
+    json error_payload = FindSession(params, &session, true);
+    if (!error_payload.is_null()) {
+        return error_payload;
+    }
+    if (params.contains("shader_code") && params.contains("edits")) {
+        error_payload = make_json_error_payload(EFailJSONRPCInvalidParams, "Specify only one of 'shader_code' and 'edits'.");
+    } else if (params.contains("shader_code") || params.contains("edits")) {
+        std::lock_guard<std::mutex> lock(session->source_mutex);
+        error_payload = ApplySessionEdits(params, *session);
+        if (error_payload.is_null()) {
+            params.erase("shader_code");
+            params.erase("edits");
+            params["revision"] = session->revision;
+        }
+    } else if (params.contains("revision") && !params["revision"].is_number_unsigned()) {
+        error_payload = make_json_error_payload(EFailJSONRPCInvalidParams, "'revision' must be a non-negative integer.");
+    }
+    if (!error_payload.is_null()) {
+        g_session_registry.release(params["session_id"].get<unsigned long long>());
     }
+    return error_payload;
+}
 
-    const char* shader_strings[] = { shader_source_decoded.c_str() };
-    bool compile_success = sh::Compile(compiler, shader_strings, 1, compileOptions);
+// Reads requests from the stream until EOF or "shutdown" and hands them to the pool.
+// "shutdown" waits for every request before it to be answered, then acknowledges.
+// Session requests are staged here so their order is the order they were sent:
+// open_session and close_session are handled inline, update_session edits are
+// applied before the compile is queued. A non-null first_message is handled
+// before anything is read.
+static void RunJsonRpcWorkerLoop(size_t num_workers, uint64_t default_timeout_ms, JsonRpcStream& stream,
+                                 const std::string* first_message = nullptr) {
+    JsonRpcWorkerPool pool(num_workers, stream);
+    std::string line;
+    if (first_message) {
+        line = *first_message;
+    }
+    while (first_message || stream.read(&line)) {
+        first_message = nullptr;
+        json request_json = json::parse(line, nullptr, false); // Non-throwing parse
+        if (request_json.is_discarded()) {
+            json response_json_shell;
+            response_json_shell["jsonrpc"] = "2.0";
+            response_json_shell["id"] = nullptr;
+            response_json_shell["error"] = make_json_error_payload(EFailJSONRPCParse, "Parse error: Invalid JSON format.");
+            g_server_stats.record_error(EFailJSONRPCParse);
+            pool.write(response_json_shell);
+            continue;
+        }
 
-    json result_payload; // This is the "result" field on success
-    result_payload["info_log"] = sh::GetInfoLog(compiler);
+        if (request_json.is_object() && request_json.contains("method") && request_json["method"].is_string() &&
+            request_json["method"].get_ref<const std::string&>() == "shutdown") {
+            pool.drain();
+            json response_json_shell;
+            response_json_shell["jsonrpc"] = "2.0";
+            response_json_shell["id"] = nullptr;
+            bool shutdown_requested = false;
+            dispatch_json_rpc_request(request_json, response_json_shell, g_compiler_cache, &shutdown_requested);
+            pool.write(response_json_shell);
+            return;
+        }
 
-    if (compile_success) {
-        if (compileOptions.objectCode) {
-            // Correctly handle binary vs. text output
-            if (output == SH_SPIRV_VULKAN_OUTPUT)
-            {
-                // For binary output, base64 encode it
-                const sh::BinaryBlob& blob = sh::GetObjectBinaryBlob(compiler);
-                result_payload["object_code_base64"] = (blob.data() && blob.size() > 0) ?
-                    base64_encode(reinterpret_cast<const unsigned char*>(blob.data()), (unsigned int)blob.size()) : "";
-            }
-            else
-            {
-                // For text output (ESSL, GLSL, HLSL), return the string directly
-                result_payload["object_code"] = sh::GetObjectCode(compiler);
+        const std::string method = request_json.is_object() && request_json.contains("method") &&
+                                           request_json["method"].is_string()
+                                       ? request_json["method"].get<std::string>()
+                                       : std::string();
+        if (method == "open_session" || method == "close_session") {
+            json response_json_shell;
+            response_json_shell["jsonrpc"] = "2.0";
+            response_json_shell["id"] = nullptr;
+            dispatch_json_rpc_request(request_json, response_json_shell, g_compiler_cache, nullptr);
+            pool.write(response_json_shell);
+            continue;
+        }
+
+        // "cancel" takes {"id": <id of an earlier request>}.
+        const json* params = request_json.is_object() && request_json.contains("params") && request_json["params"].is_object()
+                                 ? &request_json["params"]
+                                 : nullptr;
+        json error_payload;
+        json result;
+        if (method == "cancel") {
+            if (!params || !params->contains("id")) {
+                error_payload = make_json_error_payload(EFailJSONRPCInvalidParams, "Missing 'id' parameter for 'cancel' method.");
+            } else {
+                result["cancelled"] = pool.cancel((*params)["id"]);
             }
+        } else if (params && params->contains("timeout_ms") && !(*params)["timeout_ms"].is_number_unsigned()) {
+            error_payload = make_json_error_payload(EFailJSONRPCInvalidParams, "'timeout_ms' must be a non-negative integer.");
+        } else if (method == "update_session") {
+            error_payload = StageSessionUpdate(request_json);
         }
-        if (print_active_vars) {
-            result_payload["active_variables"] = SerializeActiveVariablesToJson(compiler); // Ensure this doesn't throw
+        if (method == "cancel" || !error_payload.is_null()) {
+            json response_json_shell;
+            response_json_shell["jsonrpc"] = "2.0";
+            response_json_shell["id"] = request_json.contains("id") ? request_json["id"] : json(nullptr);
+            if (error_payload.is_null()) {
+                response_json_shell["result"] = result;
+            } else {
+                response_json_shell["error"] = error_payload;
+                g_server_stats.record_error(error_payload["code"].get<int>());
+            }
+            g_server_stats.record_request(method, 0);
+            pool.write(response_json_shell);
+            continue;
         }
-        sh::Destruct(compiler);
-        return result_payload; // Success!
-    } else {
-        // Compilation failed
-        sh::Destruct(compiler);
-        json error_data;
-        error_data["info_log"] = result_payload["info_log"]; // Reuse info_log
-        return make_json_error_payload(EFailCompile, "Shader compilation failed.", error_data);
+
+        const uint64_t timeout_ms = params && params->contains("timeout_ms")
+                                        ? (*params)["timeout_ms"].get<uint64_t>()
+                                        : default_timeout_ms;
+        pool.submit(std::move(request_json), timeout_ms);
+    }
+    if (stream.malformed()) {
+        pool.write(MakeFrameErrorResponse());
     }
 }
+#endif
 
-// If NUM_SOURCE_STRINGS is set to a value > 1, the input file data is
-// broken into that many chunks. This will affect file/line numbering in
-// the preprocessor.
-const unsigned int NUM_SOURCE_STRINGS = 1;
-typedef std::vector<char *> ShaderSource;
-static bool ReadShaderSource(const char *fileName, ShaderSource &source);
-static void FreeShaderSource(ShaderSource &source);
+// Nearest-rank percentile of an ascending-sorted, non-empty sample.
+static double Percentile(const std::vector<double>& sorted, double q) {
+    size_t rank = static_cast<size_t>(q * static_cast<double>(sorted.size()) + 0.999999);
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
 
-static bool ParseGLSLOutputVersion(const std::string &, ShShaderOutput *outResult);
-static bool ParseIntValue(const std::string &, int emptyDefault, int *outValue);
+// --bench mode: translates every shader of a corpus manifest (see
+// bench/corpus/manifest.json) for each spec x output combination and prints
+// throughput, latency percentiles and peak memory as JSON. Each combination
+// is warmed up once so compilers are already constructed, and the result
+// cache is bypassed, so the numbers measure sh::Compile plus building and
+// dumping the response payload.
+static int RunBenchmark(const std::string& manifest_path, int iterations, bool print_active_variables) {
+    std::ifstream manifest_file(manifest_path);
+    json manifest = manifest_file ? json::parse(manifest_file, nullptr, false) : json();
+    if (manifest.is_discarded() || !manifest.is_object() || !manifest.contains("shaders") || !manifest["shaders"].is_array()) {
+        fprintf(stderr, "Cannot read benchmark manifest '%s'.\n", manifest_path.c_str());
+        return EFailUsage;
+    }
+    const std::string base_dir = manifest_path.substr(0, manifest_path.find_last_of("/\\") + 1);
 
-static void PrintSpirv(const sh::BinaryBlob &blob);
+    struct BenchShader {
+        std::string file;
+        sh::GLenum type;
+        std::string source;
+        json specs;
+    };
+    std::vector<BenchShader> shaders;
+    std::vector<std::string> specs; // In order of first appearance
+    for (const json& entry : manifest["shaders"]) {
+        BenchShader shader;
+        shader.file = entry.value("file", "");
+        shader.type = FindShaderTypeFromJson(entry.value("shader_type", ""));
+        shader.specs = entry.value("specs", json::array({"webgl"}));
+        std::ifstream source_file(base_dir + shader.file, std::ios::binary);
+        if (shader.type == GL_NONE || !source_file) {
+            fprintf(stderr, "Bad benchmark shader entry '%s'.\n", shader.file.c_str());
+            return EFailUsage;
+        }
+        std::ostringstream source;
+        source << source_file.rdbuf();
+        shader.source = source.str();
+        for (const json& spec : shader.specs) {
+            if (std::find(specs.begin(), specs.end(), spec.get<std::string>()) == specs.end()) {
+                specs.push_back(spec.get<std::string>());
+            }
+        }
+        shaders.push_back(std::move(shader));
+    }
+    const json outputs = manifest.value("outputs", json::array({"essl"}));
+
+    using Clock = std::chrono::steady_clock;
+    CompilerCache compilers;
+    uint64_t overall_peak_kb = angle::GetProcessMemoryUsageKB();
+    json results = json::array();
+    for (const std::string& spec : specs) {
+        for (const json& output : outputs) {
+            json combination;
+            combination["spec"] = spec;
+            combination["output"] = output;
+
+            json params;
+            params["spec"] = spec;
+            params["output"] = output;
+            params["compile_options"] = {{"object_code", true}};
+            params["print_active_variables"] = print_active_variables;
+            TranslationProfile options;
+            json error_payload = ResolveTranslateOptions(params, &options);
+            if (!error_payload.is_null()) {
+                combination["error"] = error_payload;
+                results.push_back(combination);
+                continue;
+            }
 
-//
-// Set up the per compile resources
-//
-void GenerateResources(ShBuiltInResources *resources)
-{
-    sh::InitBuiltInResources(resources);
+            std::vector<const BenchShader*> selected;
+            for (const BenchShader& shader : shaders) {
+                if (std::find(shader.specs.begin(), shader.specs.end(), spec) != shader.specs.end()) {
+                    selected.push_back(&shader);
+                }
+            }
 
-    resources->MaxVertexAttribs             = 8;
-    resources->MaxVertexUniformVectors      = 128;
-    resources->MaxVaryingVectors            = 8;
-    resources->MaxVertexTextureImageUnits   = 0;
-    resources->MaxCombinedTextureImageUnits = 8;
-    resources->MaxTextureImageUnits         = 8;
-    resources->MaxFragmentUniformVectors    = 16;
-    resources->MaxDrawBuffers               = 1;
-    resources->MaxDualSourceDrawBuffers     = 1;
+            json per_shader = json::array();
+            unsigned failures = 0;
+            for (const BenchShader* shader : selected) {
+                json payload = TranslateSourceWithOptions(shader->source, shader->type, options, compilers, nullptr);
+                const bool failed = payload.contains("code") && payload.contains("message");
+                failures += failed ? 1 : 0;
+                per_shader.push_back({{"file", shader->file}, {"failed", failed}});
+            }
 
-    resources->OES_standard_derivatives  = 0;
-    resources->OES_EGL_image_external    = 0;
-    resources->EXT_geometry_shader       = 1;
-    resources->ANGLE_texture_multisample = 0;
-    resources->APPLE_clip_distance       = 0;
+            std::vector<std::vector<double>> shader_latencies(selected.size());
+            std::vector<double> latencies;
+            latencies.reserve(selected.size() * static_cast<size_t>(iterations));
+            uint64_t peak_kb = angle::GetProcessMemoryUsageKB();
+            double total_us = 0.0;
+            for (int iteration = 0; iteration < iterations; ++iteration) {
+                for (size_t i = 0; i < selected.size(); ++i) {
+                    Clock::time_point start = Clock::now();
+                    json payload = TranslateSourceWithOptions(selected[i]->source, selected[i]->type, options, compilers, nullptr);
+                    JsonWriter::Dump(payload);
+                    const double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+                    latencies.push_back(us);
+                    shader_latencies[i].push_back(us);
+                    total_us += us;
+                }
+                peak_kb = std::max(peak_kb, angle::GetProcessMemoryUsageKB());
+            }
+            overall_peak_kb = std::max(overall_peak_kb, peak_kb);
+
+            combination["shaders"] = selected.size();
+            combination["translations"] = latencies.size();
+            combination["failures"] = failures;
+            if (!latencies.empty()) {
+                std::sort(latencies.begin(), latencies.end());
+                combination["shaders_per_sec"] = total_us > 0.0 ? latencies.size() * 1e6 / total_us : 0.0;
+                combination["mean_us"] = total_us / latencies.size();
+                combination["p50_us"] = Percentile(latencies, 0.50);
+                combination["p99_us"] = Percentile(latencies, 0.99);
+                for (size_t i = 0; i < selected.size(); ++i) {
+                    std::sort(shader_latencies[i].begin(), shader_latencies[i].end());
+                    per_shader[i]["p50_us"] = Percentile(shader_latencies[i], 0.50);
+                }
+            }
+            combination["peak_rss_kb"] = peak_kb;
+            combination["per_shader"] = per_shader;
+            results.push_back(combination);
+        }
+    }
+
+    json report;
+    report["backend"] = "native";
+    report["corpus"] = manifest_path;
+    report["iterations"] = iterations;
+    report["print_active_variables"] = print_active_variables;
+    report["peak_rss_kb"] = overall_peak_kb;
+    report["results"] = results;
+    std::cout << report.dump(2) << std::endl;
+    return ESuccess;
+}
+
+// Parses a non-negative byte count that may exceed the range of int.
+static bool ParseByteCount(const std::string& num, uint64_t* out_value) {
+    if (num.empty() || num.find_first_not_of("0123456789") != std::string::npos || num.size() > 19) {
+        return false;
+    }
+    *out_value = std::stoull(num);
+    return true;
 }
 
+#if !defined(SHADER_TRANSLATOR_EMBEDDED) // Defined by python_module.cpp, which includes this file
 int main(int argc, char *argv[]) {
     sh::Initialize(); // Initialize ANGLE once at the start
 
+    // Benchmark mode: --bench=MANIFEST [--iterations=NUM] [--active-variables]
+    if (argc > 1 && argv[1] != nullptr && std::string(argv[1]).rfind("--bench=", 0) == 0) {
+        int iterations = 20;
+        bool print_active_variables = false;
+        int bench_return_code = ESuccess;
+        for (int i = 2; i < argc && bench_return_code == ESuccess; ++i) {
+            std::string arg = argv[i];
+            if (arg.rfind("--iterations=", 0) == 0 &&
+                ParseIntValue(arg.substr(sizeof("--iterations=") - 1), 0, &iterations) && iterations > 0) {
+                continue;
+            } else if (arg == "--active-variables") {
+                print_active_variables = true;
+            } else {
+                usage();
+                bench_return_code = EFailUsage;
+            }
+        }
+        if (bench_return_code == ESuccess) {
+            bench_return_code = RunBenchmark(std::string(argv[1]).substr(sizeof("--bench=") - 1), iterations,
+                                             print_active_variables);
+        }
+        sh::Finalize();
+        return bench_return_code;
+    }
+
     bool json_rpc_mode = false;
     // Check if the first argument is --json-rpc
     if (argc > 1 && argv[1] != nullptr && std::string(argv[1]) == "--json-rpc") {
@@ -573,14 +2763,80 @@ int main(int argc, char *argv[]) {
     int main_return_code = ESuccess; // Default success
 
     if (json_rpc_mode) {
+        // Remaining arguments are JSON-RPC server options of the form --name=value
+        JsonRpcStream::Framing framing = JsonRpcStream::Framing::kLines;
+        int flush_batch = 64;
+        uint64_t max_message_bytes = JsonRpcStream::kDefaultMaxMessageBytes;
+#if !defined(__EMSCRIPTEN__)
+        size_t num_workers = 1;
+        uint64_t default_timeout_ms = 0;
+        std::string disk_cache_dir;
+        uint64_t disk_cache_bytes = DiskCache::kDefaultMaxBytes;
+#endif
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            int value = 0;
+            if (arg.rfind("--result-cache-bytes=", 0) == 0 &&
+                ParseIntValue(arg.substr(sizeof("--result-cache-bytes=") - 1), 0, &value) && value >= 0) {
+                g_result_cache.set_max_bytes(static_cast<size_t>(value));
+            } else if (arg == "--framing=lines") {
+                framing = JsonRpcStream::Framing::kLines;
+            } else if (arg == "--framing=content-length") {
+                framing = JsonRpcStream::Framing::kContentLength;
+            } else if (arg.rfind("--flush-batch=", 0) == 0 &&
+                       ParseIntValue(arg.substr(sizeof("--flush-batch=") - 1), 0, &value) && value >= 1) {
+                flush_batch = value;
+            } else if (arg.rfind("--max-message-bytes=", 0) == 0 &&
+                       ParseByteCount(arg.substr(sizeof("--max-message-bytes=") - 1), &max_message_bytes)) {
+#if !defined(__EMSCRIPTEN__)
+            } else if (arg.rfind("--workers=", 0) == 0 &&
+                       ParseIntValue(arg.substr(sizeof("--workers=") - 1), 0, &value) && value >= 1) {
+                num_workers = static_cast<size_t>(value);
+            } else if (arg.rfind("--timeout-ms=", 0) == 0 &&
+                       ParseIntValue(arg.substr(sizeof("--timeout-ms=") - 1), 0, &value) && value >= 0) {
+                default_timeout_ms = static_cast<uint64_t>(value);
+            } else if (arg.rfind("--disk-cache=", 0) == 0 && arg.size() > sizeof("--disk-cache=") - 1) {
+                disk_cache_dir = arg.substr(sizeof("--disk-cache=") - 1);
+            } else if (arg.rfind("--disk-cache-bytes=", 0) == 0 &&
+                       ParseByteCount(arg.substr(sizeof("--disk-cache-bytes=") - 1), &disk_cache_bytes)) {
+#endif
+            } else {
+                usage();
+                sh::Finalize();
+                return EFailUsage;
+            }
+        }
+
+#if !defined(__EMSCRIPTEN__)
+        if (!disk_cache_dir.empty()) {
+            g_disk_cache = std::make_unique<DiskCache>(disk_cache_dir, disk_cache_bytes);
+            if (g_disk_cache->usable()) {
+                g_result_cache.set_disk_cache(g_disk_cache.get());
+            } else {
+                std::cerr << "Cannot create the disk cache in " << disk_cache_dir << "; continuing without it.\n";
+                g_disk_cache.reset();
+            }
+        }
+#endif
+
         // JSON RPC Mode Logic
         std::string line;
-        // Ensure std::cout is not buffered in a way that prevents timely responses
-        std::ios_base::sync_with_stdio(false); // Can sometimes help, but endl flushes cout
+        // Unsynchronized streams buffer stdin, which lets JsonRpcStream see whether
+        // more requests are already waiting before it decides to flush.
+        std::ios_base::sync_with_stdio(false);
         std::cin.tie(nullptr);
+        JsonRpcStream stream(std::cin, std::cout, framing, static_cast<size_t>(flush_batch), max_message_bytes);
+
+#if !defined(__EMSCRIPTEN__)
+        // Time budgets need a thread to watch the one compiling, so they imply the pool.
+        if (num_workers > 1 || default_timeout_ms) {
+            RunJsonRpcWorkerLoop(num_workers, default_timeout_ms, stream);
+            stream.flush();
+            goto finalize_and_exit_success;
+        }
+#endif
 
-
-        while (std::getline(std::cin, line)) {
+        while (stream.read(&line)) {
             json request_json;
             json response_json_shell;
             response_json_shell["jsonrpc"] = "2.0";
@@ -588,46 +2844,38 @@ int main(int argc, char *argv[]) {
 
             request_json = json::parse(line, nullptr, false); // Non-throwing parse
 
+#if !defined(__EMSCRIPTEN__)
+            // The first request with a time budget, or a "cancel", moves the
+            // server onto a one-worker pool, which can honor them; every
+            // earlier request has been answered by now.
+            if (request_json.is_object() &&
+                (request_json.value("method", json()) == "cancel" ||
+                 (request_json.contains("params") && request_json["params"].is_object() &&
+                  request_json["params"].contains("timeout_ms")))) {
+                RunJsonRpcWorkerLoop(1, 0, stream, &line);
+                stream.flush();
+                goto finalize_and_exit_success;
+            }
+#endif
+
             if (request_json.is_discarded()) {
                 response_json_shell["error"] = make_json_error_payload(EFailJSONRPCParse, "Parse error: Invalid JSON format.");
+                g_server_stats.record_error(EFailJSONRPCParse);
             } else {
-                if (request_json.contains("id")) {
-                    response_json_shell["id"] = request_json["id"];
-                }
-
-                if (!request_json.contains("method") || !request_json["method"].is_string()) {
-                    response_json_shell["error"] = make_json_error_payload(EFailJSONRPCInvalidRequest, "Invalid Request: 'method' is missing or not a string.");
-                } else {
-                    std::string method = request_json["method"].get<std::string>();
-
-                    if (method == "translate") {
-                        if (!request_json.contains("params") || !request_json["params"].is_object()) {
-                            response_json_shell["error"] = make_json_error_payload(EFailJSONRPCInvalidParams, "Invalid Params: 'params' is missing or not an object for 'translate' method.");
-                        } else {
-                            json params = request_json["params"];
-                            json result_or_error_payload = handle_translate_request(params);
-
-                            if (result_or_error_payload.contains("code") && result_or_error_payload.contains("message") && result_or_error_payload.is_object()) {
-                                response_json_shell["error"] = result_or_error_payload;
-                            } else {
-                                response_json_shell["result"] = result_or_error_payload;
-                            }
-                        }
-                    } else if (method == "shutdown") {
-                        response_json_shell["result"] = "Shutdown acknowledged.";
-                        std::cout << response_json_shell.dump() << std::endl; // Ensure this flushes
-                        goto finalize_and_exit_success; // Use goto for clean exit path
-                    } else {
-                        response_json_shell["error"] = make_json_error_payload(EFailJSONRPCMethodNotFound, "Method not found: " + method);
-                    }
+                bool shutdown_requested = false;
+                dispatch_json_rpc_request(request_json, response_json_shell, g_compiler_cache, &shutdown_requested);
+                if (shutdown_requested) {
+                    stream.write(JsonWriter::Dump(response_json_shell), false); // Flushes everything queued
+                    goto finalize_and_exit_success; // Use goto for clean exit path
                 }
             }
-            // Ensure "result" is not present if "error" is present
-            if (response_json_shell.contains("error") && response_json_shell.contains("result")) {
-                response_json_shell.erase("result");
-            }
-            std::cout << response_json_shell.dump() << std::endl; // std::endl flushes
+            // Responses are flushed once stdin has no further request buffered.
+            stream.write(JsonWriter::Dump(response_json_shell), stream.input_pending());
         }
+        if (stream.malformed()) {
+            stream.write(MakeFrameErrorResponse().dump(), false);
+        }
+        stream.flush();
         // If loop exits due to EOF on stdin
         main_return_code = ESuccess;
 
@@ -887,9 +3135,12 @@ finalize_and_exit_success: // Label for successful exit path from JSON RPC shutd
         // If the goto was used, main_return_code is already ESuccess implicitly.
     }
 
+    g_compiler_cache.flush(); // Compilers must be destroyed before ANGLE is finalized
+    g_session_registry.close_all();
     sh::Finalize(); // Finalize ANGLE once at the end
     return main_return_code;
 }
+#endif // !SHADER_TRANSLATOR_EMBEDDED
 
 //
 //   print usage to stdout
@@ -931,7 +3182,16 @@ void usage()
         "       -x=m     : enable OVR_multiview\n"
         "       -x=y     : enable YUV_target\n"
         "       -x=s     : enable OES_sample_variables\n"
-        "       --json-rpc : run in JSON-RPC mode\n");
+        "       --json-rpc : run in JSON-RPC mode (must be the first argument)\n"
+        "       --result-cache-bytes=NUM : JSON-RPC translation cache budget in bytes (0 disables)\n"
+        "       --framing=lines|content-length : JSON-RPC message framing (default lines)\n"
+        "       --flush-batch=NUM : flush after at most NUM pipelined JSON-RPC responses (default 64)\n"
+        "       --max-message-bytes=NUM : largest Content-Length accepted (default 64 MiB)\n"
+        "       --workers=NUM : handle JSON-RPC requests on NUM threads (responses may be out of order)\n"
+        "       --timeout-ms=NUM : default JSON-RPC request time budget, enforced on worker threads (0: none)\n"
+        "       --disk-cache=DIR : also keep JSON-RPC translations in DIR, shared with other processes\n"
+        "       --disk-cache-bytes=NUM : disk cache budget in bytes (default 1 GiB)\n"
+        "       --bench=MANIFEST [--iterations=NUM] [--active-variables] : benchmark a corpus, print JSON\n");
     // clang-format on
 }
 
@@ -1375,7 +3635,7 @@ static bool ParseIntValue(const std::string &num, int emptyDefault, int *outValu
 
 static void PrintSpirv(const sh::BinaryBlob &blob)
 {
-#if defined(ANGLE_ENABLE_VULKAN)
+#if defined(ANGLE_ENABLE_VULKAN) && defined(ANGLE_TRANSLATOR_SPIRV_TOOLS)
     spvtools::SpirvTools spirvTools(SPV_ENV_VULKAN_1_1);
 
     std::string readableSpirv;
@@ -1391,17 +3651,78 @@ static void PrintSpirv(const sh::BinaryBlob &blob)
 // This manually provides a stub for a memory management function that
 // Emscripten requires when memory growth is enabled.
 extern "C" {
-    void emscripten_notify_memory_growth(int memory_index) {}
+    void emscripten_notify_memory_growth(int) {}
 }
 
 #include <emscripten.h>
 
 // This global string will hold the last result. It's a simple approach
-// for a single-threaded WASM environment.
+// for a single-threaded WASM environment. Its capacity is kept between calls,
+// as is input_buffer's, so steady-state requests don't churn linear memory.
 static std::string last_result_json;
+static std::string input_buffer;
 
 extern "C"
 {
+    /**
+     * @brief Returns a module-owned buffer of at least size bytes for the next request.
+     * * Hosts copy a request here instead of calling malloc()/free() per call,
+     * then pass the pointer to invoke_ex() or translate(). The buffer only
+     * ever grows, and does so geometrically; the pointer stays valid until
+     * the next call to get_input_buffer() with a larger size.
+     * * @param size Number of bytes the caller is about to write.
+     * @return A pointer to the buffer.
+     */
+    EMSCRIPTEN_KEEPALIVE
+    char *get_input_buffer(size_t size)
+    {
+        if (input_buffer.size() < size)
+        {
+            input_buffer.reserve(std::max(size, input_buffer.capacity() * 2));
+            input_buffer.resize(input_buffer.capacity());
+        }
+        return &input_buffer[0];
+    }
+
+    /**
+     * @brief Length-delimited entry point for the WASM module.
+     * * Takes a full JSON-RPC request as length bytes (no NUL terminator
+     * required), processes it, and returns the full JSON-RPC response. The
+     * response length in bytes is written to *out_length when it is non-null,
+     * so hosts can read exactly that many bytes instead of scanning for NUL.
+     * The returned pointer is valid until the next call to invoke()/invoke_ex().
+     * * @param request_json_str The JSON request bytes.
+     * @param length Number of bytes in request_json_str.
+     * @param out_length Receives the response length (excluding the NUL that
+     * is still appended for C callers).
+     * @return A pointer to the JSON response.
+     */
+    EMSCRIPTEN_KEEPALIVE
+    const char *invoke_ex(const char *request_json_str, size_t length, size_t *out_length)
+    {
+        json request_json = json::parse(request_json_str, request_json_str + length, nullptr, false);
+        json response_json_shell;
+        response_json_shell["jsonrpc"] = "2.0";
+        response_json_shell["id"] = nullptr;
+
+        if (request_json.is_discarded())
+        {
+            response_json_shell["error"] = make_json_error_payload(EFailJSONRPCParse, "Parse error: Invalid JSON format.");
+            g_server_stats.record_error(EFailJSONRPCParse);
+        }
+        else
+        {
+            dispatch_json_rpc_request(request_json, response_json_shell, g_compiler_cache, nullptr);
+        }
+
+        JsonWriter::Dump(response_json_shell, &last_result_json);
+        if (out_length)
+        {
+            *out_length = last_result_json.size();
+        }
+        return last_result_json.c_str();
+    }
+
     /**
      * @brief The main entry point for the WASM module.
      * * Takes a full JSON-RPC request as a string, processes it, and returns
@@ -1413,61 +3734,142 @@ extern "C"
     EMSCRIPTEN_KEEPALIVE
     const char *invoke(const char *request_json_str)
     {
-        json request_json = json::parse(request_json_str, nullptr, false);
-        json response_json_shell;
-        response_json_shell["jsonrpc"] = "2.0";
-        response_json_shell["id"] = nullptr;
+        return invoke_ex(request_json_str, strlen(request_json_str), nullptr);
+    }
 
-        if (request_json.is_discarded())
+    // --- Typed result API ---
+    // translate() runs a translation without building or serializing a JSON
+    // response; the get_* accessors then expose the output in place. Output
+    // views point into the compiler's own buffers (or into a copy of the cached
+    // payload on a result cache hit) and are valid until the next call into
+    // the module.
+    static struct {
+        ShHandle compiler = nullptr; // Holds the output when translate() compiled
+        json payload;                // "result" or "error" payload of the last translate()
+        std::string binary;          // object_code_base64 decoded on demand for cache hits
+        bool binary_decoded = false;
+    } typed_result;
+
+    static const std::string &TypedPayloadString(const json &object, const char *key)
+    {
+        static const std::string empty;
+        if (object.is_object() && object.contains(key) && object[key].is_string())
         {
-            response_json_shell["error"] = make_json_error_payload(EFailJSONRPCParse, "Parse error: Invalid JSON format.");
+            return object[key].get_ref<const std::string &>();
         }
-        else
+        return empty;
+    }
+
+    /**
+     * @brief Translates a shader and reports only a status code.
+     * * Accepts the same params object as the "translate" JSON-RPC method
+     * (print_active_variables is ignored). Use the get_* exports to read the
+     * output.
+     * * @param params_json The params object as JSON bytes.
+     * @param length Number of bytes in params_json.
+     * @return ESuccess (0), EFailCompile, EFailCompilerCreate, or a JSON-RPC
+     * error code for malformed params.
+     */
+    EMSCRIPTEN_KEEPALIVE
+    int translate(const char *params_json, size_t length)
+    {
+        typed_result.compiler = nullptr;
+        typed_result.binary.clear();
+        typed_result.binary_decoded = false;
+
+        json params = json::parse(params_json, params_json + length, nullptr, false);
+        if (params.is_discarded())
         {
-            if (request_json.contains("id"))
-            {
-                response_json_shell["id"] = request_json["id"];
-            }
+            typed_result.payload = make_json_error_payload(EFailJSONRPCParse, "Parse error: Invalid JSON format.");
+            return EFailJSONRPCParse;
+        }
+        if (!params.is_object())
+        {
+            typed_result.payload = make_json_error_payload(EFailJSONRPCInvalidParams, "Invalid Params: params must be an object.");
+            return EFailJSONRPCInvalidParams;
+        }
 
-            if (!request_json.contains("method") || !request_json["method"].is_string())
-            {
-                response_json_shell["error"] = make_json_error_payload(EFailJSONRPCInvalidRequest, "Invalid Request: 'method' is missing or not a string.");
-            }
-            else
-            {
-                std::string method = request_json["method"].get<std::string>();
-                if (method == "translate")
-                {
-                    if (!request_json.contains("params") || !request_json["params"].is_object())
-                    {
-                        response_json_shell["error"] = make_json_error_payload(EFailJSONRPCInvalidParams, "Invalid Params: 'params' is missing or not an object for 'translate' method.");
-                    }
-                    else
-                    {
-                        json result_or_error_payload = handle_translate_request(request_json["params"]);
-                        if (result_or_error_payload.contains("code") && result_or_error_payload.contains("message"))
-                        {
-                            response_json_shell["error"] = result_or_error_payload;
-                        }
-                        else
-                        {
-                            response_json_shell["result"] = result_or_error_payload;
-                        }
-                    }
-                }
-                else
-                {
-                    response_json_shell["error"] = make_json_error_payload(EFailJSONRPCMethodNotFound, "Method not found: " + method);
-                }
-            }
+        std::string decoded_storage;
+        const std::string *shader_source = nullptr;
+        sh::GLenum shaderType = GL_NONE;
+        TranslationProfile profile;
+        json error_payload = ParseTranslateSource(params, &decoded_storage, &shader_source, &shaderType);
+        if (error_payload.is_null())
+        {
+            error_payload = ResolveTranslateOptions(params, &profile);
         }
-        
-        if (response_json_shell.contains("error") && response_json_shell.contains("result")) {
-            response_json_shell.erase("result");
+        if (!error_payload.is_null())
+        {
+            typed_result.payload = error_payload;
+            return error_payload["code"].get<int>();
+        }
+        if (profile.options.printActiveVariables)
+        {
+            profile.options.printActiveVariables = false;
+            HashTranslationProfile(&profile);
         }
 
-        last_result_json = response_json_shell.dump();
-        return last_result_json.c_str();
+        MemoryWatermark::Scope memory_scope(g_memory_watermark);
+        typed_result.payload = TranslateSourceWithOptions(*shader_source, shaderType, profile, g_compiler_cache,
+                                                          &g_result_cache, &typed_result.compiler);
+        if (typed_result.payload.contains("code") && typed_result.payload.contains("message"))
+        {
+            return typed_result.payload["code"].get<int>();
+        }
+        return ESuccess;
+    }
+
+    EMSCRIPTEN_KEEPALIVE
+    const char *get_object_code(size_t *out_length)
+    {
+        const std::string &code = typed_result.compiler ? sh::GetObjectCode(typed_result.compiler)
+                                                        : TypedPayloadString(typed_result.payload, "object_code");
+        *out_length = code.size();
+        return code.data();
+    }
+
+    EMSCRIPTEN_KEEPALIVE
+    const char *get_info_log(size_t *out_length)
+    {
+        const std::string *log = &TypedPayloadString(typed_result.payload, "info_log");
+        if (typed_result.compiler)
+        {
+            log = &sh::GetInfoLog(typed_result.compiler);
+        }
+        else if (typed_result.payload.contains("data"))
+        {
+            log = &TypedPayloadString(typed_result.payload["data"], "info_log"); // Cached compile failure
+        }
+        *out_length = log->size();
+        return log->data();
+    }
+
+    // Binary object code (SPIR-V) as raw bytes, without base64.
+    EMSCRIPTEN_KEEPALIVE
+    const unsigned char *get_object_binary(size_t *out_length)
+    {
+        if (typed_result.compiler)
+        {
+            const sh::BinaryBlob &blob = sh::GetObjectBinaryBlob(typed_result.compiler);
+            *out_length = blob.size() * sizeof(blob[0]);
+            return reinterpret_cast<const unsigned char *>(blob.data());
+        }
+        if (!typed_result.binary_decoded)
+        {
+            decode_into(TypedPayloadString(typed_result.payload, "object_code_base64"), typed_result.binary);
+            typed_result.binary_decoded = true;
+        }
+        *out_length = typed_result.binary.size();
+        return reinterpret_cast<const unsigned char *>(typed_result.binary.data());
+    }
+
+    // Message of the last translate() failure, or an empty string on success.
+    EMSCRIPTEN_KEEPALIVE
+    const char *get_error_message(size_t *out_length)
+    {
+        const std::string &message = TypedPayloadString(typed_result.payload, "message");
+        *out_length = message.size();
+        return message.data();
     }
 
     // Return an int to signal success/failure to Python
@@ -1479,6 +3881,8 @@ extern "C"
     }
 
     void finalize() {
+        g_compiler_cache.flush();
+        g_session_registry.close_all();
         sh::Finalize();
     }
 }
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "xxhash.h"
+
+// Summarizes what of a GLSL source the compiler can observe, so an edit that
+// only touches comments or whitespace can be recognized without compiling.
+//
+// tokens hashes the source with line continuations joined, then comments
+// removed (in that order, as in the preprocessor, so a "//" comment ending in
+// a backslash also comments out the next line) and every other run of
+// whitespace collapsed to one space. Newlines are kept
+// only where they end a preprocessor directive, and whitespace at the start
+// and end of a line is dropped. Spacing between tokens is preserved rather
+// than inferred ("a+b" and "a + b" differ), which keeps the comparison safe
+// without a full lexer.
+//
+// lines hashes where the source's line breaks fall relative to that text.
+// Diagnostics carry line numbers, so a result whose info log is not empty
+// can only be reused when lines match as well.
+struct SourceFingerprint {
+    XXH64_hash_t tokens = 0;
+    XXH64_hash_t lines = 0;
+    bool uses_line_macro = false; // __LINE__ expands differently once lines move
+
+    static SourceFingerprint Of(const std::string& original) {
+        thread_local std::string spliced;
+        thread_local std::vector<uint32_t> splices; // Offsets in spliced where a continuation was joined
+        thread_local std::string text;
+        thread_local std::vector<uint32_t> line_breaks; // Length of text at each line break
+        splices.clear();
+        text.clear();
+        line_breaks.clear();
+
+        const std::string& source = Splice(original, &spliced, &splices) ? spliced : original;
+        size_t next_splice = 0;
+
+        bool pending_space = false; // Whitespace or a comment since the last character kept
+        bool line_start = true;     // Only whitespace so far on this line
+        bool in_directive = false;
+        const size_t size = source.size();
+        for (size_t i = 0; i < size; ++i) {
+            // A joined line still moves what follows it down a line. Comments
+            // add no text, so breaks they skipped over are recorded here too.
+            for (; next_splice < splices.size() && splices[next_splice] <= i; ++next_splice) {
+                line_breaks.push_back(static_cast<uint32_t>(text.size()));
+            }
+            const char c = source[i];
+            if (c == '\n') {
+                line_breaks.push_back(static_cast<uint32_t>(text.size()));
+                if (in_directive) {
+                    text += '\n';
+                    in_directive = false;
+                }
+                pending_space = false;
+                line_start = true;
+                continue;
+            }
+            if (c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f') {
+                pending_space = true;
+                continue;
+            }
+            if (c == '/' && i + 1 < size && source[i + 1] == '/') {
+                while (i + 1 < size && source[i + 1] != '\n') {
+                    ++i;
+                }
+                pending_space = true;
+                continue;
+            }
+            if (c == '/' && i + 1 < size && source[i + 1] == '*') {
+                i += 2;
+                while (i < size && !(source[i] == '*' && i + 1 < size && source[i + 1] == '/')) {
+                    if (source[i] == '\n') {
+                        line_breaks.push_back(static_cast<uint32_t>(text.size()));
+                    }
+                    ++i;
+                }
+                ++i; // Skip the closing '/'
+                pending_space = true;
+                continue;
+            }
+
+            if (line_start) {
+                in_directive = c == '#';
+                if (!text.empty() && text.back() != '\n') {
+                    text += ' '; // Outside directives a newline is just whitespace
+                }
+            } else if (pending_space) {
+                text += ' ';
+            }
+            text += c;
+            pending_space = false;
+            line_start = false;
+        }
+
+        for (; next_splice < splices.size(); ++next_splice) {
+            line_breaks.push_back(static_cast<uint32_t>(text.size()));
+        }
+
+        SourceFingerprint fingerprint;
+        fingerprint.tokens = XXH64(text.data(), text.size(), 0);
+        fingerprint.lines = XXH64(line_breaks.data(), line_breaks.size() * sizeof(line_breaks[0]), 0);
+        fingerprint.uses_line_macro = text.find("__LINE__") != std::string::npos;
+        return fingerprint;
+    }
+
+private:
+    // Writes source with every backslash-newline removed to *out, and where
+    // each was to *splices. Returns false, leaving *out alone, if there is none.
+    static bool Splice(const std::string& source, std::string* out, std::vector<uint32_t>* splices) {
+        const size_t size = source.size();
+        size_t i = source.find('\\');
+        bool found = false;
+        for (; i != std::string::npos && i < size; i = source.find('\\', i + 1)) {
+            if (i + 1 < size && (source[i + 1] == '\n' || source[i + 1] == '\r')) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            return false;
+        }
+        out->assign(source, 0, i);
+        for (; i < size; ++i) {
+            const char c = source[i];
+            if (c == '\\' && i + 1 < size && (source[i + 1] == '\n' || source[i + 1] == '\r')) {
+                i += (source[i + 1] == '\r' && i + 2 < size && source[i + 2] == '\n') ? 2 : 1;
+                splices->push_back(static_cast<uint32_t>(out->size()));
+                continue;
+            }
+            *out += c;
+        }
+        return true;
+    }
+};
@@ -538,6 +538,8 @@ uint64_t GetProcessMemoryUsageKB()
     // fclose(file);
 
     // return kb;
-    return 0;
+
+    // There is no RSS under WASM; the linear memory size is the footprint.
+    return static_cast<uint64_t>(__builtin_wasm_memory_size(0)) * 64;  // 64 KiB pages
 }
 }  // namespace angle
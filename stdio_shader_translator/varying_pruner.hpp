@@ -0,0 +1,278 @@
+#pragma once
+
+#include <cctype>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Rewrites a vertex shader so that outputs the next stage never reads are
+// plain private globals instead of varyings. The stage interface then only
+// carries what is used, and since writes to a private global nobody reads
+// are dead stores, the driver's compiler drops the code computing them.
+//
+// Declarations are recognized at the token level: a top-level statement of
+// optional qualifiers (layout(...), flat, smooth, noperspective, centroid,
+// invariant), then 'varying' or 'out', an optional precision, a type and a
+// list of names. A declaration that mixes pruned and kept names is split,
+// and 'invariant name;' statements for pruned names are dropped. Anything
+// else is left alone: output blocks, struct definitions inside the
+// declaration and declarations spelled through macros are never pruned. A
+// rewritten statement keeps its line breaks, so diagnostics keep their line
+// numbers.
+class VaryingPruner {
+public:
+    // Writes the rewritten source to *out and appends the names that were
+    // demoted to *pruned. Outputs whose name is in keep are left as they are.
+    static void Prune(const std::string& source, const std::unordered_set<std::string>& keep, std::string* out,
+                      std::vector<std::string>* pruned) {
+        VaryingPruner pruner(source, keep);
+        pruner.tokenize();
+        pruner.rewrite(out, pruned);
+    }
+
+private:
+    struct Token {
+        size_t begin, end;
+    };
+
+    VaryingPruner(const std::string& source, const std::unordered_set<std::string>& keep)
+        : source_(source), keep_(keep) {}
+
+    std::string text(const Token& token) const { return source_.substr(token.begin, token.end - token.begin); }
+    bool is(const Token& token, const char* word) const {
+        return source_.compare(token.begin, token.end - token.begin, word) == 0;
+    }
+    bool is_identifier(const Token& token) const {
+        const char c = source_[token.begin];
+        return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+    }
+
+    // Splits the source into identifiers, numbers and single punctuation
+    // characters, skipping comments and preprocessor directives.
+    void tokenize() {
+        const size_t size = source_.size();
+        bool line_start = true;
+        size_t i = 0;
+        while (i < size) {
+            const char c = source_[i];
+            if (c == '\n') {
+                line_start = true;
+                ++i;
+            } else if (std::isspace(static_cast<unsigned char>(c))) {
+                ++i;
+            } else if (c == '/' && i + 1 < size && source_[i + 1] == '/') {
+                while (i < size && source_[i] != '\n') {
+                    ++i;
+                }
+            } else if (c == '/' && i + 1 < size && source_[i + 1] == '*') {
+                const size_t close = source_.find("*/", i + 2);
+                i = close == std::string::npos ? size : close + 2;
+            } else if (c == '#' && line_start) {
+                while (i < size && source_[i] != '\n') {
+                    i += (source_[i] == '\\' && i + 1 < size) ? 2 : 1; // Line continuations
+                }
+            } else {
+                const size_t begin = i++;
+                if (std::isalnum(static_cast<unsigned char>(c)) || c == '_') {
+                    while (i < size && (std::isalnum(static_cast<unsigned char>(source_[i])) || source_[i] == '_' ||
+                                        source_[i] == '.')) {
+                        ++i;
+                    }
+                }
+                tokens_.push_back(Token{begin, i});
+                line_start = false;
+            }
+        }
+    }
+
+    // Walks the top-level statements, copying the source through and
+    // replacing the declarations that lose names.
+    void rewrite(std::string* out, std::vector<std::string>* pruned) {
+        std::vector<std::pair<size_t, size_t>> statements; // First token and ';' of each
+        size_t start = 0;
+        int depth = 0;
+        for (size_t i = 0; i < tokens_.size(); ++i) {
+            const char c = source_[tokens_[i].begin];
+            if (c == '{' || c == '(' || c == '[') {
+                ++depth;
+            } else if (c == '}' || c == ')' || c == ']') {
+                --depth;
+                if (c == '}' && depth == 0) {
+                    start = i + 1; // Function bodies and blocks end a statement
+                }
+            } else if (c == ';' && depth == 0) {
+                statements.emplace_back(start, i);
+                start = i + 1;
+            }
+        }
+
+        // Demoted names are collected up front, so an 'invariant name;' ahead
+        // of the declaration is handled as well.
+        std::vector<Declaration> declarations;
+        std::unordered_set<std::string> demoted;
+        for (const auto& statement : statements) {
+            Declaration declaration;
+            if (parse_declaration(statement.first, statement.second, &declaration)) {
+                for (const Declarator& declarator : declaration.declarators) {
+                    if (!keep_.count(text(tokens_[declarator.name]))) {
+                        declaration.demoted = true;
+                        if (demoted.insert(text(tokens_[declarator.name])).second) {
+                            pruned->push_back(text(tokens_[declarator.name]));
+                        }
+                    }
+                }
+                if (declaration.demoted) {
+                    declarations.push_back(declaration);
+                }
+            }
+        }
+
+        out->clear();
+        size_t copied = 0;
+        size_t next_declaration = 0;
+        for (const auto& statement : statements) {
+            const size_t begin = tokens_[statement.first].begin;
+            const size_t end = tokens_[statement.second].end;
+            std::string replacement;
+            if (next_declaration < declarations.size() && declarations[next_declaration].first == statement.first) {
+                replacement = demote(declarations[next_declaration++]);
+            } else if (!rewrite_invariant(statement.first, statement.second, demoted, &replacement)) {
+                continue;
+            }
+            out->append(source_, copied, begin - copied);
+            *out += replacement;
+            for (size_t i = begin; i < end; ++i) {
+                if (source_[i] == '\n') {
+                    *out += '\n';
+                }
+            }
+            copied = end;
+        }
+        out->append(source_, copied, std::string::npos);
+    }
+
+    struct Declarator {
+        size_t name;      // Token index of the name
+        size_t end;       // One past its last token (array sizes included)
+    };
+    struct Declaration {
+        size_t first;     // Token index where the statement starts
+        size_t storage;   // Token index of 'varying' or 'out'
+        size_t type_begin; // Precision (if any) and type, up to the first name
+        std::vector<Declarator> declarators;
+        bool demoted = false;
+    };
+
+    // Parses tokens [first, semicolon) as an output declaration.
+    bool parse_declaration(size_t first, size_t semicolon, Declaration* declaration) const {
+        size_t i = first;
+        while (i < semicolon) {
+            const Token& token = tokens_[i];
+            if (is(token, "layout") && i + 1 < semicolon && is(tokens_[i + 1], "(")) {
+                while (i < semicolon && !is(tokens_[i], ")")) {
+                    ++i;
+                }
+                ++i;
+            } else if (is(token, "flat") || is(token, "smooth") || is(token, "noperspective") ||
+                       is(token, "centroid") || is(token, "invariant")) {
+                ++i;
+            } else {
+                break;
+            }
+        }
+        if (i >= semicolon || !(is(tokens_[i], "varying") || is(tokens_[i], "out"))) {
+            return false;
+        }
+        declaration->first = first;
+        declaration->storage = i++;
+        declaration->type_begin = i;
+        if (i < semicolon && (is(tokens_[i], "lowp") || is(tokens_[i], "mediump") || is(tokens_[i], "highp"))) {
+            ++i;
+        }
+        if (i >= semicolon || !is_identifier(tokens_[i])) {
+            return false;
+        }
+        ++i;
+        i = skip_array_sizes(i, semicolon); // 'out vec2[2] name;'
+        while (i < semicolon) {
+            if (!is_identifier(tokens_[i])) {
+                return false;
+            }
+            Declarator declarator{i, skip_array_sizes(i + 1, semicolon)};
+            i = declarator.end;
+            declaration->declarators.push_back(declarator);
+            if (i < semicolon) {
+                if (!is(tokens_[i], ",")) {
+                    return false; // Initializers and anything unexpected
+                }
+                ++i;
+            }
+        }
+        return !declaration->declarators.empty();
+    }
+
+    size_t skip_array_sizes(size_t i, size_t limit) const {
+        while (i < limit && is(tokens_[i], "[")) {
+            while (i < limit && !is(tokens_[i], "]")) {
+                ++i;
+            }
+            ++i;
+        }
+        return i;
+    }
+
+    std::string span(size_t first, size_t last) const {
+        return source_.substr(tokens_[first].begin, tokens_[last - 1].end - tokens_[first].begin);
+    }
+
+    // The declaration with its kept names, followed by a private global
+    // declaring the others.
+    std::string demote(const Declaration& declaration) const {
+        const size_t first_name = declaration.declarators.front().name;
+        std::string kept, dropped;
+        for (const Declarator& declarator : declaration.declarators) {
+            std::string& list = keep_.count(text(tokens_[declarator.name])) ? kept : dropped;
+            if (!list.empty()) {
+                list += ", ";
+            }
+            list += span(declarator.name, declarator.end);
+        }
+        std::string replacement;
+        if (!kept.empty()) {
+            replacement = span(declaration.first, first_name) + " " + kept + "; ";
+        }
+        replacement += span(declaration.type_begin, first_name) + " " + dropped + ";";
+        return replacement;
+    }
+
+    // For 'invariant a, b;' naming a demoted output, sets *replacement to the
+    // statement without it and returns true.
+    bool rewrite_invariant(size_t first, size_t semicolon, const std::unordered_set<std::string>& demoted,
+                           std::string* replacement) const {
+        if (semicolon - first < 2 || !is(tokens_[first], "invariant")) {
+            return false;
+        }
+        std::string kept;
+        bool changed = false;
+        for (size_t i = first + 1; i < semicolon; i += 2) {
+            if (!is_identifier(tokens_[i]) || (i + 1 < semicolon && !is(tokens_[i + 1], ","))) {
+                return false;
+            }
+            if (demoted.count(text(tokens_[i]))) {
+                changed = true;
+            } else {
+                kept += kept.empty() ? "invariant " : ", ";
+                kept += text(tokens_[i]);
+            }
+        }
+        if (!changed) {
+            return false;
+        }
+        *replacement = kept.empty() ? "" : kept + ";";
+        return true;
+    }
+
+    const std::string& source_;
+    const std::unordered_set<std::string>& keep_;
+    std::vector<Token> tokens_;
+};
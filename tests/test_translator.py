@@ -1,12 +1,36 @@
 import pytest
+import asyncio
 import base64
-from angle_translator import ShaderTranslator
+import json
+import os
+import subprocess
+import sys
+from angle_translator import ShaderTranslator, ShaderTranslatorPool, AsyncShaderTranslator, ActiveVariables, load_module, default_module_cache_dir
+from angle_translator.translator import TIMEOUT_ERROR_CODE
 
 @pytest.fixture(scope="module")
 def translator():
     """Provides a single ShaderTranslator instance for all tests."""
     return ShaderTranslator()
 
+@pytest.fixture(scope="module")
+def native_executable():
+    """The native angle_shader_translator named by ANGLE_TRANSLATOR_EXECUTABLE; tests using it skip without one."""
+    executable = os.environ.get("ANGLE_TRANSLATOR_EXECUTABLE", "")
+    if not os.path.isfile(executable):
+        pytest.skip("set ANGLE_TRANSLATOR_EXECUTABLE to a native angle_shader_translator")
+    return executable
+
+def _content_length_frames(data: bytes) -> list:
+    """Splits Content-Length framed output into the decoded messages."""
+    messages = []
+    while data:
+        header, _, data = data.partition(b"\r\n\r\n")
+        length = int(header.split(b":", 1)[1])
+        messages.append(json.loads(data[:length]))
+        data = data[length:]
+    return messages
+
 def test_successful_frag_translation(translator):
     """Tests a valid WebGL fragment shader translation to ESSL (GLSL ES)."""
     fragment_shader = """
@@ -86,4 +110,546 @@ def test_active_variables(translator):
     assert len(active_vars["attributes"]) == 1
     assert active_vars["attributes"][0]["name"] == "a_pos"
     assert len(active_vars["uniforms"]) == 1
-    assert active_vars["uniforms"][0]["name"] == "u_time"
\ No newline at end of file
+    assert active_vars["uniforms"][0]["name"] == "u_time"
+
+def test_compilers_are_reused_and_flushed(translator):
+    """Tests that translations leave cached compilers behind and flush_compilers releases them."""
+    shader = "void main() { gl_Position = vec4(1.0); }"
+    translator.flush_compilers()
+    for _ in range(2):
+        response = translator.translate_shader(shader_code=shader, shader_type="vertex")
+        assert "result" in response
+    # Both translations share a single (vertex, webgl, essl) compiler
+    assert translator.flush_compilers() == 1
+    assert translator.flush_compilers() == 0
+
+def test_result_cache_hits(translator):
+    """Tests that repeating an identical request is answered from the result cache."""
+    shader = "precision mediump float; void main() { gl_FragColor = vec4(0.25); }"
+    translator.cache_clear()
+    before = translator.cache_stats()["result_cache"]
+    first = translator.translate_shader(shader_code=shader, shader_type="fragment")
+    second = translator.translate_shader(shader_code=shader, shader_type="fragment")
+    after = translator.cache_stats()["result_cache"]
+    assert first == second
+    assert after["misses"] == before["misses"] + 1
+    assert after["hits"] == before["hits"] + 1
+    assert after["entries"] == 1
+    assert translator.cache_clear() == 1
+
+def test_translate_batch(translator):
+    """Tests that translate_batch returns one result per item, in order, including failures."""
+    vertex_shader = "attribute vec2 a_pos; void main() { gl_Position = vec4(a_pos, 0.0, 1.0); }"
+    fragment_shader = "precision mediump float; void main() { gl_FragColor = vec4(1.0); }"
+    broken_shader = "void main() { gl_Position = undeclared_variable; }"
+    results = translator.translate_batch([
+        (vertex_shader, "vertex"),
+        {"shader_code": fragment_shader, "shader_type": "fragment"},
+        (broken_shader, "vertex"),
+    ])
+    assert len(results) == 3
+    assert "a_pos" in results[0]["result"]["object_code"]
+    assert "gl_FragColor" in results[1]["result"]["object_code"]
+    single = translator.translate_shader(shader_code=broken_shader, shader_type="vertex")
+    assert results[2]["error"]["code"] == single["error"]["code"]
+
+def test_translate_batch_items_share_cache_keys(translator):
+    """Tests that batch items without overrides hit the result cache of an identical earlier batch."""
+    shaders = [("precision mediump float; void main() { gl_FragColor = vec4(%d.0); }" % i, "fragment") for i in range(4)]
+    translator.cache_clear()
+    first = translator.translate_batch(shaders)
+    before = translator.cache_stats()["result_cache"]
+    second = translator.translate_batch(shaders)
+    after = translator.cache_stats()["result_cache"]
+    assert first == second
+    assert after["hits"] == before["hits"] + len(shaders)
+    assert after["misses"] == before["misses"]
+
+def test_plain_and_base64_sources_match(translator):
+    """Tests that 'shader_code' and the legacy 'shader_code_base64' field translate identically."""
+    shader = "precision mediump float; // \"quoted\" comment\nvoid main() { gl_FragColor = vec4(0.5); }"
+    common = {"shader_type": "fragment", "spec": "webgl", "output": "essl"}
+    plain = translator._send_request("translate", dict(common, shader_code=shader))
+    encoded = translator._send_request("translate", dict(
+        common, shader_code_base64=base64.b64encode(shader.encode('utf-8')).decode('ascii')))
+    assert "result" in plain
+    assert plain["result"] == encoded["result"]
+
+def test_base64_sources_round_trip(translator):
+    """Tests that base64 sources of every padding length, line-wrapped or not, decode to the plain source."""
+    base = "precision mediump float; // caf\u00e9 \u2713\nvoid main() { gl_FragColor = vec4(0.25); }"
+    common = {"shader_type": "fragment", "spec": "webgl", "output": "essl"}
+    for extra in ("", " ", "  "):  # Source lengths that need 0, 1 and 2 padding characters, in some order
+        shader = base + extra
+        plain = translator._send_request("translate", dict(common, shader_code=shader))
+        encoded = base64.b64encode(shader.encode("utf-8")).decode("ascii")
+        for variant in (encoded, base64.encodebytes(shader.encode("utf-8")).decode("ascii"), f"  {encoded}\r\n",
+                        encoded.rstrip("=")):
+            response = translator._send_request("translate", dict(common, shader_code_base64=variant))
+            assert response["result"] == plain["result"], repr(variant)
+
+def test_base64_invalid_input(translator):
+    """Tests that base64 input with nothing decodable is rejected, and stray characters are skipped."""
+    common = {"shader_type": "vertex", "spec": "webgl", "output": "essl"}
+    for bad in ("!!!!", "====", "A", " \n\t"):
+        response = translator._send_request("translate", dict(common, shader_code_base64=bad))
+        assert response["error"]["code"] == -32602, repr(bad)
+    shader = "void main() { gl_Position = vec4(1.0); }"
+    encoded = base64.b64encode(shader.encode("utf-8")).decode("ascii")
+    plain = translator._send_request("translate", dict(common, shader_code=shader))
+    noisy_encoded = "*".join(encoded[i:i + 5] for i in range(0, len(encoded), 5))
+    noisy = translator._send_request("translate", dict(common, shader_code_base64=noisy_encoded))
+    assert noisy["result"] == plain["result"]
+    trailing = translator._send_request("translate", dict(common, shader_code_base64=encoded + "=junk"))
+    assert trailing["result"] == plain["result"]
+
+def test_typed_fast_path_matches_json_path(translator):
+    """Tests that print_vars=False (typed accessor exports) returns what the JSON-RPC path returns."""
+    shader = "precision mediump float; varying vec2 v_uv; void main() { gl_FragColor = vec4(v_uv, 0.0, 1.0); }"
+    broken_shader = "void main() { gl_Position = undeclared_variable; }"
+    params = {"shader_code": shader, "shader_type": "fragment", "spec": "webgl", "output": "essl",
+              "print_active_variables": False, "compile_options": {"object_code": True},
+              "resources": {"EnableNameHashing": False}}
+    fast = translator.translate_shader(shader_code=shader, shader_type="fragment", print_vars=False)
+    assert fast["result"] == translator._send_request("translate", params)["result"]
+
+    failed = translator.translate_shader(shader_code=broken_shader, shader_type="vertex", print_vars=False)
+    assert "error" in failed
+    assert "'undeclared_variable' : undeclared identifier" in failed["error"]["data"]["info_log"]
+
+def test_pool_matches_single_translator(translator):
+    """Tests that a ShaderTranslatorPool returns the same responses as a single translator, in order."""
+    shaders = [("precision mediump float; void main() { gl_FragColor = vec4(%d.0); }" % i, "fragment") for i in range(6)]
+    shaders.append(("void main() { gl_Position = undeclared_variable; }", "vertex"))
+    with ShaderTranslatorPool(size=2) as pool:
+        futures = pool.map(shaders, print_vars=False)
+        responses = [future.result(timeout=60) for future in futures]
+    for (shader_code, shader_type), response in zip(shaders, responses):
+        expected = translator.translate_shader(shader_code=shader_code, shader_type=shader_type, print_vars=False)
+        assert response == expected
+
+def test_module_cache_roundtrip(tmp_path):
+    """Tests that load_module writes a precompiled artifact and loads it back on the next call."""
+    load_module(cache_dir=str(tmp_path))
+    artifacts = list(tmp_path.glob("*.cwasm"))
+    assert len(artifacts) == 1
+    engine, module = load_module(cache_dir=str(tmp_path))
+    assert list(tmp_path.glob("*.cwasm")) == artifacts
+    with ShaderTranslator(engine=engine, module=module) as cached:
+        response = cached.translate_shader(shader_code="void main() { gl_Position = vec4(1.0); }", shader_type="vertex")
+    assert "gl_Position" in response["result"]["object_code"]
+
+def test_module_cache_is_opt_in(monkeypatch, tmp_path):
+    """Tests that modules are only cached on disk once ANGLE_TRANSLATOR_CACHE_DIR is set."""
+    monkeypatch.delenv("ANGLE_TRANSLATOR_CACHE_DIR", raising=False)
+    assert default_module_cache_dir() is None
+    monkeypatch.setenv("ANGLE_TRANSLATOR_CACHE_DIR", str(tmp_path))
+    assert default_module_cache_dir() == str(tmp_path)
+
+def test_profile_timings(translator):
+    """Tests that profile=True adds per-phase timings without changing the translation."""
+    shader = "precision mediump float; uniform float u_profiled; void main() { gl_FragColor = vec4(u_profiled); }"
+    translator.cache_clear()
+    profiled = translator.translate_shader(shader_code=shader, shader_type="fragment", profile=True)
+    timings = profiled["result"].pop("timings")
+    for phase in ("decode_us", "parse_params_us", "construct_compiler_us", "compile_us",
+                  "get_object_code_us", "serialize_active_variables_us", "json_dump_us", "total_us"):
+        assert timings[phase] >= 0
+    assert timings["result_cache_hit"] is False
+    assert timings["process_memory_kb"] > 0
+    plain = translator.translate_shader(shader_code=shader, shader_type="fragment")
+    assert plain["result"] == profiled["result"]
+
+def test_stats(translator):
+    """Tests that the stats method counts requests and errors and renders Prometheus text."""
+    before = translator.stats()
+    translator.translate_shader(shader_code="void main() { gl_Position = vec4(0.0); }", shader_type="vertex", spec="webgl2")
+    translator.translate_shader(shader_code="void main() { gl_Position = undeclared_variable; }", shader_type="vertex")
+    after = translator.stats()
+    assert after["requests"]["by_method"]["translate"] == before["requests"]["by_method"].get("translate", 0) + 2
+    assert after["requests"]["by_spec"]["webgl2"] >= 1
+    assert after["errors"]["total"] == before["errors"]["total"] + 1
+    latency = after["latency_us"]["translate"]
+    assert latency["p50"] <= latency["p95"] <= latency["p99"]
+    text = translator.stats(format="prometheus")
+    assert 'shader_translator_requests_total{method="translate"}' in text
+    assert "shader_translator_request_duration_seconds_bucket" in text
+    with pytest.raises(ValueError):
+        translator.stats(format="xml")
+
+def test_stats_labels_rejected_values_as_invalid(translator):
+    """Tests that a spec the translator rejects is counted under "invalid" rather than as a label of its own."""
+    response = translator._send_request("translate", {"shader_code": "void main() {}", "shader_type": "vertex",
+                                                      "spec": "no-such-spec-1234"})
+    assert response["error"]["code"] == -32602
+    by_spec = translator.stats()["requests"]["by_spec"]
+    assert "no-such-spec-1234" not in by_spec
+    assert by_spec["invalid"] >= 1
+
+def test_request_buffers_are_reused(translator):
+    """Tests that repeated requests go through the persistent input buffer without growing linear memory."""
+    shader = "void main() { gl_Position = vec4(0.25); }"
+    translator.translate_shader(shader_code=shader, shader_type="vertex")
+    data_len = translator.memory.data_len(translator.store)
+    for _ in range(200):
+        translator.translate_shader(shader_code=shader, shader_type="vertex")
+    assert translator.memory.data_len(translator.store) == data_len
+    first = translator._get_input_buffer(translator.store, 64)
+    assert translator._get_input_buffer(translator.store, 32) == first
+
+def test_compact_and_recycle():
+    """Tests that compact releases compilers and that the recycle policy swaps in a fresh instance."""
+    shader = "void main() { gl_Position = vec4(0.5); }"
+    with ShaderTranslator(recycle_after_requests=3) as recycled:
+        recycled.translate_shader(shader_code=shader, shader_type="vertex")
+        compacted = recycled.compact(result_cache=True)
+        assert compacted["compilers_released"] >= 1
+        assert compacted["results_released"] >= 1
+        assert compacted["memory"]["high_water_kb"] >= compacted["memory"]["process_kb"]
+        assert recycled.recycles == 0
+        recycled.translate_shader(shader_code=shader, shader_type="vertex")
+        assert recycled.recycles == 1
+        response = recycled.translate_shader(shader_code=shader, shader_type="vertex")
+        assert "gl_Position" in response["result"]["object_code"]
+        assert recycled.cache_stats()["compiler_cache"]["entries"] == 1
+
+def test_registered_profile_matches_inline_options(translator):
+    """Tests that translating through a registered profile gives the same output as passing the options inline."""
+    shader = "#version 300 es\nprecision mediump float; uniform float u_gain; out vec4 color; void main() { color = vec4(u_gain); }"
+    profile_id = translator.register_profile(spec="webgl2", output="glsl330")
+    assert translator.register_profile(spec="webgl2", output="glsl330") == profile_id
+    inline = translator.translate_shader(shader_code=shader, shader_type="fragment", spec="webgl2", output="glsl330")
+    profiled = translator.translate_shader(shader_code=shader, shader_type="fragment", profile_id=profile_id)
+    assert profiled["result"] == inline["result"]
+    batch = translator.translate_batch([(shader, "fragment")], profile_id=profile_id)
+    assert batch[0]["result"] == inline["result"]
+    unknown = translator.translate_shader(shader_code=shader, shader_type="fragment", profile_id=profile_id + 1000)
+    assert unknown["error"]["code"] == -32602
+    with pytest.raises(ValueError):
+        translator.register_profile(spec="bogus")
+
+def test_session_reuses_result_for_comment_edits(translator):
+    """Tests that a session skips compilation for comment-only edits and recompiles real changes."""
+    shader = "precision mediump float;\nvoid main() {\n    gl_FragColor = vec4(1.0);\n}\n"
+    with translator.open_session("fragment", spec="webgl", output="essl") as session:
+        first = session.update(shader_code=shader)
+        assert first["result"]["revision"] == 1
+        assert not first["result"]["reused"]
+        commented = session.update(edits=[(0, 0, "// live edit\n")])
+        assert commented["result"]["reused"]
+        assert commented["result"]["object_code"] == first["result"]["object_code"]
+        changed = session.update(edits=[(session.source.index("1.0"), session.source.index("1.0") + 3, "0.5")])
+        assert not changed["result"]["reused"]
+        assert "0.5" in changed["result"]["object_code"]
+        assert changed["result"]["revision"] == 3
+        # A trailing backslash continues the comment over the precision statement
+        end_of_comment = session.source.index("// live edit") + len("// live edit")
+        continued = session.update(edits=[(end_of_comment, end_of_comment, " \\")])
+        assert not continued["error"]["data"]["reused"]
+        stale = translator._send_request("update_session", {"session_id": session._session_id, "revision": 1})
+        assert stale["result"]["superseded"]
+    assert session.closed
+
+def test_timeout_interrupts_and_recycles():
+    """Tests that a translation over its time budget is interrupted and the instance replaced."""
+    functions = "".join(f"float f{i}(float x) {{ return sin(x) * {i}.0 + x; }}\n" for i in range(20000))
+    shader = functions + "void main() { gl_Position = vec4(f1(1.0)); }"
+    with ShaderTranslator() as limited:
+        response = limited.translate_shader(shader_code=shader, shader_type="vertex", timeout_ms=1)
+        assert response["error"]["code"] == TIMEOUT_ERROR_CODE
+        assert limited.recycles == 1
+        response = limited.translate_shader(shader_code="void main() { gl_Position = vec4(1.0); }", shader_type="vertex")
+        assert "gl_Position" in response["result"]["object_code"]
+
+def test_program_prunes_varyings_the_fragment_stage_ignores(translator):
+    """Tests that translate_program drops vertex outputs the fragment shader never reads."""
+    vertex = ("attribute vec2 a_pos;\nvarying vec2 v_uv;\nvarying vec2 v_unused;\n"
+              "void main() { v_uv = a_pos; v_unused = a_pos * 2.0; gl_Position = vec4(a_pos, 0.0, 1.0); }")
+    fragment = "precision mediump float;\nvarying vec2 v_uv;\nvoid main() { gl_FragColor = vec4(v_uv, 0.0, 1.0); }"
+    result = translator.translate_program(vertex, fragment)["result"]
+    assert result["linked_varyings"] == ["v_uv"]
+    assert result["pruned_varyings"] == ["v_unused"]
+    outputs = [v["name"] for v in result["vertex"]["active_variables"].get("output_varyings", [])]
+    assert outputs == ["v_uv"]
+    unpruned = translator.translate_program(vertex, fragment, prune_varyings=False)["result"]
+    assert unpruned["pruned_varyings"] == []
+    failed = translator.translate_program(vertex, "void main() { undeclared_variable; }")
+    assert failed["error"]["data"]["stage"] == "fragment"
+
+def test_optimize_level_reports_pass_deltas(translator):
+    """Tests that 'optimize' removes unused declarations and reports each pass's size change."""
+    shader = "precision mediump float;\nuniform float u_unused;\nvoid main() { gl_FragColor = vec4(1.0); }"
+    response = translator.translate_shader(shader_code=shader, shader_type="fragment", optimize=1, profile=True)
+    assert "u_unused" not in response["result"]["object_code"]
+    passes = response["result"]["timings"]["optimize_passes"]
+    assert [p["pass"] for p in passes] == ["none", "remove_inactive_variables"]
+    assert passes[1]["bytes_delta"] < 0
+    for level in (2, 7):
+        invalid = translator.translate_shader(shader_code=shader, shader_type="fragment", optimize=level)
+        assert invalid["error"]["code"] == -32602
+
+def test_preprocess_hash_ignores_comments_and_macros(translator):
+    """Tests that preprocess gives equal hashes for sources differing only in comments, layout and macros."""
+    plain = "precision mediump float;\nvoid main() { gl_FragColor = vec4(1.0); }"
+    styled = "precision   mediump float; // tinted\n#define ONE 1.0\nvoid main()\n{\n    gl_FragColor = vec4(ONE);\n}\n"
+    other = "precision mediump float;\nvoid main() { gl_FragColor = vec4(0.5); }"
+    hashes = [translator.preprocess(src, "fragment")["result"]["hash"] for src in (plain, styled, other)]
+    assert hashes[0] == hashes[1] != hashes[2]
+    assert translator.preprocess("#error nope\n", "fragment")["error"]["code"] == 2
+    translator.cache_clear()
+    before = translator.cache_stats()["result_cache"]
+    first = translator.translate_shader(shader_code=plain, shader_type="fragment")
+    second = translator.translate_shader(shader_code=styled, shader_type="fragment", profile=True)
+    after = translator.cache_stats()["result_cache"]
+    assert second["result"]["timings"]["result_cache_hit"]
+    assert second["result"]["object_code"] == first["result"]["object_code"]
+    # One miss for the cold translation, and one stored payload for both sources
+    assert after["misses"] == before["misses"] + 1
+    assert after["entries"] == 1
+
+def test_disk_cache_serves_other_translators(tmp_path):
+    """Tests that a translator sharing a cache directory answers from it without compiling."""
+    shader = "void main() { gl_Position = vec4(0.25); }"
+    with ShaderTranslator(cache_dir=str(tmp_path)) as first:
+        expected = first.translate_shader(shader_code=shader, shader_type="vertex")
+    assert len(list(tmp_path.rglob("*.json"))) == 1
+    with ShaderTranslator(cache_dir=str(tmp_path)) as second:
+        assert second.translate_shader(shader_code=shader, shader_type="vertex") == expected
+        assert "translate" not in second.stats()["requests"]["by_method"]
+
+def test_backends_load_on_first_use():
+    """Tests that an HLSL request loads the HLSL variant only then, and routes its profiles there."""
+    shader = "void main() { gl_Position = vec4(1.0); }"
+    with ShaderTranslator() as fresh:
+        fresh.translate_shader(shader_code=shader, shader_type="vertex")
+        assert fresh._backends == {}
+        response = fresh.translate_shader(shader_code=shader, shader_type="vertex", output="hlsl11")
+        assert "object_code" in response["result"]
+        assert fresh.backend("hlsl11") is fresh._backends["hlsl"]
+        profile_id = fresh.register_profile(output="hlsl11")
+        assert fresh.translate_shader(shader_code=shader, shader_type="vertex", profile_id=profile_id) == response
+
+def test_native_backend_matches_wasm(translator):
+    """Tests that the in-process extension, when built, translates exactly like the WASM module."""
+    from angle_translator import translator as translator_module
+    if translator_module._native is None:
+        with ShaderTranslator(backend="native") as fallback:
+            assert fallback.backend_name == "wasm"
+        pytest.skip("angle_translator._native is not built")
+    shader = "precision mediump float;\nuniform vec4 u_color;\nvoid main() { gl_FragColor = u_color; }"
+    with ShaderTranslator(backend="native") as native:
+        assert native.backend_name == "native"
+        for print_vars in (False, True):
+            expected = translator.translate_shader(shader_code=shader, shader_type="fragment", print_vars=print_vars)
+            assert native.translate_shader(shader_code=shader, shader_type="fragment", print_vars=print_vars) == expected
+        assert native.translate_shader(shader_code="void main() { undeclared_variable; }", shader_type="fragment")["error"]["code"] == 2
+
+def test_async_translator_keeps_order_under_backpressure(translator):
+    """Tests that awaited translations on a pool match the blocking ones, in order, with one in flight."""
+    shaders = [(f"void main() {{ gl_Position = vec4({i}.0); }}", "vertex") for i in range(6)]
+    expected = [translator.translate_shader(shader_code=code, shader_type=kind) for code, kind in shaders]
+
+    async def translate_all():
+        async with AsyncShaderTranslator(size=2, max_in_flight=1) as async_translator:
+            return await async_translator.map(shaders)
+
+    assert asyncio.run(translate_all()) == expected
+
+def test_async_spawn_matches_responses_by_id(translator, native_executable):
+    """Tests that a spawned native server answers many in-flight requests, each with its own response."""
+    executable = native_executable
+    shaders = [(f"void main() {{ gl_Position = vec4({i}.0); }}", "vertex") for i in range(12)]
+    shaders.append(("void main() { gl_Position = undeclared_variable; }", "vertex"))
+    expected = [translator.translate_shader(shader_code=code, shader_type=kind) for code, kind in shaders]
+
+    async def translate_all():
+        async with await AsyncShaderTranslator.spawn(executable, workers=3, max_in_flight=8) as async_translator:
+            return await async_translator.map(shaders)
+
+    responses = asyncio.run(translate_all())
+    assert [response.get("result") for response in responses] == [response.get("result") for response in expected]
+    assert responses[-1]["error"]["code"] == expected[-1]["error"]["code"]
+
+def test_async_spawn_fails_pending_on_unidentified_response(tmp_path):
+    """Tests that a response with a null id fails the pending requests instead of leaving them waiting."""
+    server = tmp_path / "server.py"
+    server.write_text(
+        f"#!{sys.executable}\n"
+        "import sys\n"
+        "sys.stdin.buffer.readline(); sys.stdin.buffer.readline()\n"
+        "body = b'{\"jsonrpc\": \"2.0\", \"id\": null, \"error\": {\"code\": -32700, \"message\": \"Parse error\"}}'\n"
+        "sys.stdout.buffer.write(b'Content-Length: %d\\r\\n\\r\\n' % len(body) + body)\n")
+    server.chmod(0o755)
+
+    async def translate_one():
+        async_translator = await AsyncShaderTranslator.spawn(str(server), workers=1)
+        try:
+            with pytest.raises(RuntimeError, match="Parse error"):
+                await asyncio.wait_for(async_translator.translate("void main() {}", "vertex"), timeout=10)
+        finally:
+            await async_translator.aclose()
+
+    asyncio.run(translate_one())
+
+def test_content_length_framing_answers_pipelined_requests(native_executable):
+    """Tests that Content-Length frames, raw newlines included, are answered in order when pipelined."""
+    frames = b""
+    for i in range(5):
+        body = json.dumps({"jsonrpc": "2.0", "id": i, "method": "translate", "params": {
+            "shader_type": "vertex", "spec": "webgl", "output": "essl",
+            "shader_code": f"void main() {{\n  gl_Position = vec4({i}.0);\n}}\n"}}).encode("utf-8")
+        frames += b"Content-Length: %d\r\n\r\n" % len(body) + body
+    output = subprocess.run([native_executable, "--json-rpc", "--framing=content-length", "--flush-batch=2"],
+                            input=frames, capture_output=True, timeout=60).stdout
+    responses = _content_length_frames(output)
+    assert [response["id"] for response in responses] == list(range(5))
+    assert all("gl_Position" in response["result"]["object_code"] for response in responses)
+
+@pytest.mark.parametrize("length", [b"-1", b"99999999999999999999", b"99999999999999", b"12abc", b""])
+def test_content_length_framing_rejects_bad_lengths(native_executable, length):
+    """Tests that a negative, overflowing, oversized or non-numeric Content-Length gets a parse error, not a crash."""
+    body = b'{"jsonrpc": "2.0", "id": 1, "method": "stats"}'
+    frames = b"Content-Length: %d\r\n\r\n" % len(body) + body + b"Content-Length: " + length + b"\r\n\r\n" + body
+    result = subprocess.run([native_executable, "--json-rpc", "--framing=content-length"],
+                            input=frames, capture_output=True, timeout=60)
+    assert result.returncode == 0
+    first, error = _content_length_frames(result.stdout)
+    assert first["id"] == 1 and "result" in first
+    assert error["id"] is None
+    assert error["error"]["code"] == -32700
+
+def test_binary_reflection_matches_json(translator):
+    """Tests that the binary reflection blob reads back as the same variables the JSON format lists."""
+    shader = """#version 300 es
+    precision mediump float;
+    struct Light { vec3 color; float radius[2]; };
+    uniform Light u_light;
+    uniform Params { vec4 tint; mat4 transform; } params;
+    out vec4 fragColor;
+    void main() { fragColor = vec4(u_light.color * u_light.radius[1], 1.0) * params.tint; }
+    """
+    expected = translator.translate_shader(shader_code=shader, shader_type="fragment", spec="webgl2")
+    response = translator.translate_shader(shader_code=shader, shader_type="fragment", spec="webgl2",
+                                           reflection_format="binary")
+    reflection = response["result"]["active_variables"]
+    assert isinstance(reflection, ActiveVariables)
+    assert "active_variables_base64" not in response["result"]
+    assert reflection.to_dict() == expected["result"]["active_variables"]
+    light = reflection.uniforms.find("u_light")
+    assert [field.name for field in light.fields] == ["color", "radius"]
+    assert light.fields[1].array_sizes == (2,)
+    assert reflection.uniform_blocks[0].layout == "std140"
+
+def _invoke_by_length(translator, request: bytes, trailing: bytes = b"") -> bytes:
+    """
+    Sends request through the length-delimited entry point (invoke_ex, or the
+    native invoke) with trailing bytes after it that the length leaves out.
+    Returns the raw response text.
+    """
+    if translator._native is not None:
+        return translator._native.invoke(memoryview(bytearray(request + trailing))[:len(request)])
+    if not translator._invoke_ex:
+        pytest.skip("the WASM module predates invoke_ex")
+    ptr, ptr_to_free = translator._write_input(request + trailing)
+    try:
+        result_ptr = translator._invoke_ex(translator.store, ptr, len(request), translator._out_len_ptr)
+    finally:
+        if ptr_to_free:
+            translator._free(translator.store, ptr_to_free)
+    memory = translator.memory
+    result_len = int.from_bytes(memory.read(translator.store, translator._out_len_ptr, translator._out_len_ptr + 4), "little")
+    return bytes(memory.read(translator.store, result_ptr, result_ptr + result_len))
+
+def _length_delimited_translators(translator):
+    """The WASM translator, plus a native one when the extension is built."""
+    from angle_translator import translator as translator_module
+    yield translator
+    if translator_module._native is not None:
+        with ShaderTranslator(backend="native") as native:
+            yield native
+
+def test_invoke_ex_reads_only_the_given_length(translator):
+    """Tests that invoke_ex parses exactly length bytes of an unterminated request."""
+    request = json.dumps({"jsonrpc": "2.0", "id": 7, "method": "translate",
+                          "params": {"shader_code": "void main() { gl_Position = vec4(0.0); }",
+                                     "shader_type": "vertex"}}).encode("utf-8")
+    for backend in _length_delimited_translators(translator):
+        expected = json.loads(_invoke_by_length(backend, request))
+        assert expected["id"] == 7 and "object_code" in expected["result"]
+        # Bytes past the length must be ignored, whether they look like JSON or not.
+        for trailing in (b"garbage", b"}", b' {"id": 8}', b"\xff" * 64):
+            assert json.loads(_invoke_by_length(backend, request, trailing)) == expected
+        # A length that stops short of the closing brace is a parse error, even
+        # though the rest of the request follows it in memory.
+        truncated = json.loads(_invoke_by_length(backend, request[:-1], request[-1:]))
+        assert truncated["id"] is None
+        assert truncated["error"]["code"] == -32700
+
+def test_streamed_reflection_matches_json_dump(translator):
+    """
+    Tests that the streamed active_variables text for structs, arrays and
+    blocks is exactly the sorted, compact dump of the same JSON tree.
+    """
+    shader = """#version 300 es
+    precision mediump float;
+    struct Inner { float weights[3]; };
+    struct Light { vec3 color; float radius[2]; Inner inner; };
+    uniform Light u_lights[2];
+    uniform sampler2D u_textures[2];
+    uniform Params { vec4 tint; mat4 transform[2]; Light block_light; } params;
+    layout(std140) uniform Globals { vec4 g_fog; };
+    in vec2 v_uv;
+    out vec4 fragColor;
+    void main() {
+        fragColor = vec4(u_lights[1].color * u_lights[0].radius[1] * u_lights[1].inner.weights[2], 1.0)
+                  * params.tint * params.transform[1][0].x * params.block_light.radius[0] * g_fog
+                  * texture(u_textures[1], v_uv);
+    }
+    """
+    request = json.dumps({"jsonrpc": "2.0", "id": 1, "method": "translate",
+                          "params": {"shader_code": shader, "shader_type": "fragment", "spec": "webgl2",
+                                     "output": "essl", "print_active_variables": True}}).encode("utf-8")
+    for backend in _length_delimited_translators(translator):
+        raw = _invoke_by_length(backend, request).decode("utf-8")
+        response = json.loads(raw)
+        assert "active_variables" in response["result"]
+        # The whole response is written by the same writer, so the streamed
+        # lists are checked in place as well as on their own.
+        assert raw == json.dumps(response, sort_keys=True, separators=(",", ":"), ensure_ascii=False)
+        reflection = response["result"]["active_variables"]
+        streamed = json.dumps(reflection, sort_keys=True, separators=(",", ":"), ensure_ascii=False)
+        assert f'"active_variables":{streamed}' in raw
+
+def test_reflect_mask_and_kept_reflection(translator):
+    """Tests that 'reflect' limits the lists returned, and that kept lists can be fetched afterwards."""
+    shader = """#version 300 es
+    in vec4 a_position;
+    uniform Block { mat4 u_mvp; };
+    void main() { gl_Position = u_mvp * a_position; }
+    """
+    full = translator.translate_shader(shader_code=shader, shader_type="vertex", spec="webgl2")["result"]
+    assert "generic_interface_blocks" not in full["active_variables"]
+    masked = translator.translate_shader(shader_code=shader, shader_type="vertex", spec="webgl2",
+                                         reflect=["attributes"])["result"]
+    assert masked["active_variables"] == {"attributes": full["active_variables"]["attributes"]}
+
+    lazy = translator.translate_shader(shader_code=shader, shader_type="vertex", spec="webgl2",
+                                       print_vars=False, keep_reflection=True)["result"]
+    assert "active_variables" not in lazy
+    fetched = translator.get_reflection(lazy["reflection_handle"], "uniform_blocks")["result"]["active_variables"]
+    assert fetched == {"uniform_blocks": full["active_variables"]["uniform_blocks"]}
+    generic = translator.get_reflection(lazy["reflection_handle"], ["generic_interface_blocks"])["result"]
+    assert generic["active_variables"]["generic_interface_blocks"] == full["active_variables"]["uniform_blocks"]
+    assert translator.get_reflection(lazy["reflection_handle"] + 1000, "uniforms")["error"]["code"] == -32602
+
+def test_translate_program_keep_reflection_is_not_cached(translator):
+    """Tests that translate_program with keep_reflection hands out fresh handles instead of cached, expiring ones."""
+    params = {"vertex": {"shader_code": "attribute vec4 a_position; void main() { gl_Position = a_position; }"},
+              "fragment": {"shader_code": "precision mediump float; void main() { gl_FragColor = vec4(1.0); }"},
+              "print_active_variables": False, "keep_reflection": True}
+    first = translator._send_request("translate_program", params)["result"]
+    second = translator._send_request("translate_program", params)["result"]
+    assert first["vertex"]["reflection_handle"] != second["vertex"]["reflection_handle"]
+    for response in (first, second):
+        fetched = translator.get_reflection(response["vertex"]["reflection_handle"], "attributes")
+        assert "attributes" in fetched["result"]["active_variables"]